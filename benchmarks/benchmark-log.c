@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <static-json-builder.h>
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #include <io.h>
+    #include <fcntl.h>
+#else
+    #include <pthread.h>
+    #include <time.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+#endif
+
+/*
+ Runs N producers appending event records into one log writing to the null
+ device, and compares the lock-free `json_log_t` against a mutex guarding
+ `json_stringify_into_buffer(...)` and `write(...)` for N = 1, 2, 4, ... 64.
+ Usage: benchmark-log [max threads] [records per thread]
+*/
+
+typedef struct benchmark_log_t
+{
+    int   fd;
+    char  buffer[4096];
+#if defined(_WIN32)
+    CRITICAL_SECTION mutex;
+#else
+    pthread_mutex_t  mutex;
+#endif
+} benchmark_log_t;
+
+typedef struct benchmark_thread_t
+{
+    json_log_t      *log;
+    benchmark_log_t *locked;
+    size_t           records;
+    size_t           seed;
+} benchmark_thread_t;
+
+static double benchmark_now(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+#endif
+}
+
+static void benchmark_locked_write(benchmark_log_t *locked, json_value_t *json)
+{
+#if defined(_WIN32)
+    EnterCriticalSection(&locked->mutex);
+#else
+    pthread_mutex_lock(&locked->mutex);
+#endif
+
+    size_t length = json_stringify_into_buffer(json, locked->buffer);
+    locked->buffer[length] = '\n';
+
+#if defined(_WIN32)
+    (void) !_write(locked->fd, locked->buffer, (unsigned int) length + 1);
+    LeaveCriticalSection(&locked->mutex);
+#else
+    (void) !write(locked->fd, locked->buffer, length + 1);
+    pthread_mutex_unlock(&locked->mutex);
+#endif
+}
+
+static void benchmark_records(benchmark_thread_t *thread)
+{
+    for (size_t i = 0; i < thread->records; i++) {
+        int64_t id = (int64_t) (thread->seed * 1000003 + i);
+
+        Json json = JsonObject(
+            JsonProp("event",    JsonString("order.filled")),
+            JsonProp("id",       JsonInt(id)),
+            JsonProp("symbol",   JsonString("ACME")),
+            JsonProp("price",    JsonFloat((double) id / 64.0)),
+            JsonProp("quantity", JsonInt(-(id % 10000))),
+            JsonProp("thread",   JsonInt((int64_t) thread->seed)),
+        );
+
+        if (thread->log != NULL) {
+            json_log_write(thread->log, json);
+        } else {
+            benchmark_locked_write(thread->locked, json);
+        }
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI benchmark_thread_main(LPVOID argument)
+{
+    benchmark_records(argument);
+    return 0;
+}
+#else
+static void *benchmark_thread_main(void *argument)
+{
+    benchmark_records(argument);
+    return NULL;
+}
+#endif
+
+static void benchmark_run(benchmark_thread_t *threads, size_t count)
+{
+#if defined(_WIN32)
+    HANDLE *handles = calloc(count, sizeof(HANDLE));
+
+    for (size_t i = 0; i < count; i++) {
+        handles[i] = CreateThread(NULL, 0, benchmark_thread_main, &threads[i], 0, NULL);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        WaitForSingleObject(handles[i], INFINITE);
+        CloseHandle(handles[i]);
+    }
+
+    free(handles);
+#else
+    pthread_t *handles = calloc(count, sizeof(pthread_t));
+
+    for (size_t i = 0; i < count; i++) {
+        pthread_create(&handles[i], NULL, benchmark_thread_main, &threads[i]);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        pthread_join(handles[i], NULL);
+    }
+
+    free(handles);
+#endif
+}
+
+/* Lock-free log includes draining the ring so both sides pay for every write */
+static double benchmark_lock_free(benchmark_thread_t *threads, size_t count, size_t records, int fd)
+{
+    double      start = benchmark_now();
+    json_log_t *log   = json_log_open(fd, 1 << 20);
+
+    for (size_t i = 0; i < count; i++) {
+        threads[i] = (benchmark_thread_t) { .log = log, .locked = NULL, .records = records, .seed = i };
+    }
+
+    benchmark_run(threads, count);
+    json_log_close(log);
+
+    return (double) (records * count) / (benchmark_now() - start);
+}
+
+static double benchmark_locked(benchmark_thread_t *threads, size_t count, size_t records, benchmark_log_t *locked)
+{
+    double start = benchmark_now();
+
+    for (size_t i = 0; i < count; i++) {
+        threads[i] = (benchmark_thread_t) { .log = NULL, .locked = locked, .records = records, .seed = i };
+    }
+
+    benchmark_run(threads, count);
+
+    return (double) (records * count) / (benchmark_now() - start);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t max_threads = argc > 1 ? (size_t) strtoul(argv[1], NULL, 10) : 64;
+    size_t records     = argc > 2 ? (size_t) strtoul(argv[2], NULL, 10) : 100000;
+
+#if defined(_WIN32)
+    int fd = _open("NUL", _O_WRONLY | _O_BINARY);
+#else
+    int fd = open("/dev/null", O_WRONLY);
+#endif
+
+    benchmark_thread_t *threads = calloc(max_threads, sizeof(benchmark_thread_t));
+    benchmark_log_t    *locked  = calloc(1, sizeof(benchmark_log_t));
+
+    locked->fd = fd;
+
+#if defined(_WIN32)
+    InitializeCriticalSection(&locked->mutex);
+#else
+    pthread_mutex_init(&locked->mutex, NULL);
+#endif
+
+    printf("%8s %16s %16s %12s\n", "threads", "lock-free/s", "mutex/s", "speedup");
+
+    for (size_t count = 1; count <= max_threads; count = count < max_threads && count * 2 > max_threads ? max_threads : count * 2) {
+        double lock_free = benchmark_lock_free(threads, count, records, fd);
+        double mutex     = benchmark_locked(threads, count, records, locked);
+
+        printf("%8zu %16.0f %16.0f %11.2fx\n", count, lock_free, mutex, lock_free / mutex);
+    }
+
+#if defined(_WIN32)
+    DeleteCriticalSection(&locked->mutex);
+    _close(fd);
+#else
+    pthread_mutex_destroy(&locked->mutex);
+    close(fd);
+#endif
+
+    free(locked);
+    free(threads);
+
+    return 0;
+}
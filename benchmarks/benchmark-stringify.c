@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(BENCHMARK_SINGLE_HEADER)
+    #include "../single-header/static-json-builder.h"
+    #define BENCHMARK_MODE "single header"
+#else
+    #include <static-json-builder.h>
+    #define BENCHMARK_MODE "library"
+#endif
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+/*
+ Stringifies a tree built from compound literals right at the call site,
+ where the whole shape is visible to the compiler. Built once against the
+ library and once against the single header, which lets the compiler see
+ the writers together with the call site.
+ Reports the best of several rounds. Usage: benchmark-stringify [documents]
+*/
+
+#define BENCHMARK_ROUNDS 5
+
+static double benchmark_now(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+#endif
+}
+
+static double benchmark_round(size_t documents, size_t *written)
+{
+    char   buffer[1024];
+    double start = benchmark_now();
+
+    for (size_t i = 0; i < documents; i++) {
+        Json json = JsonObject(
+            JsonProp("status",  JsonString("ok")),
+            JsonProp("version", JsonInt(3)),
+            JsonProp("request", JsonInt((int64_t) i)),
+            JsonProp("flags",   JsonArray(JsonBool(true), JsonBool(false), JsonNull())),
+            JsonProp("limits",  JsonObject(
+                JsonProp("rate",  JsonInt(1000)),
+                JsonProp("burst", JsonInt(50)),
+            )),
+        );
+
+        *written += json_stringify_into_buffer(json, buffer);
+    }
+
+    return benchmark_now() - start;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t documents = argc > 1 ? (size_t) strtoul(argv[1], NULL, 10) : 1000000;
+    size_t written   = 0;
+    double best      = 0;
+
+    for (size_t round = 0; round < BENCHMARK_ROUNDS; round++) {
+        double elapsed = benchmark_round(documents, &written);
+        best = round == 0 || elapsed < best ? elapsed : best;
+    }
+
+    printf("%-32s %12.0f documents/s %8.1f ns/document (%zu bytes)\n",
+           BENCHMARK_MODE, (double) documents / best, best * 1e9 / (double) documents, written);
+
+    return 0;
+}
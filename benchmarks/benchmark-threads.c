@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <static-json-builder.h>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+/*
+ Runs N threads, each stringifying its own documents into its own buffer,
+ and reports the total throughput for N = 1, 2, 4, ... up to the thread limit.
+ Usage: benchmark-threads [max threads] [documents per thread]
+*/
+
+typedef struct benchmark_thread_t
+{
+    size_t documents;
+    size_t seed;
+    size_t written;
+} benchmark_thread_t;
+
+static double benchmark_now(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+#endif
+}
+
+static size_t benchmark_cpu_count(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    return (size_t) info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t) count : 1;
+#endif
+}
+
+static void benchmark_documents(benchmark_thread_t *thread)
+{
+    char buffer[4096];
+
+    for (size_t i = 0; i < thread->documents; i++) {
+        int64_t id = (int64_t) (thread->seed * 1000003 + i);
+
+        Json json = JsonObject(
+            JsonProp("id",       JsonInt(id)),
+            JsonProp("symbol",   JsonString("ACME")),
+            JsonProp("price",    JsonFloat((double) id / 64.0)),
+            JsonProp("quantity", JsonInt(-(id % 10000))),
+            JsonProp("active",   JsonBool(i % 2 == 0)),
+            JsonProp("fills",    JsonArray(
+                JsonFloat(101.25),
+                JsonFloat(0.000125 * (double) i),
+                JsonInt(id * 7),
+            )),
+        );
+
+        thread->written += json_stringify_into_buffer(json, buffer);
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI benchmark_thread_main(LPVOID argument)
+{
+    benchmark_documents(argument);
+    return 0;
+}
+#else
+static void *benchmark_thread_main(void *argument)
+{
+    benchmark_documents(argument);
+    return NULL;
+}
+#endif
+
+static double benchmark_run(benchmark_thread_t *threads, size_t count)
+{
+    double start = benchmark_now();
+
+#if defined(_WIN32)
+    HANDLE *handles = calloc(count, sizeof(HANDLE));
+
+    for (size_t i = 0; i < count; i++) {
+        handles[i] = CreateThread(NULL, 0, benchmark_thread_main, &threads[i], 0, NULL);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        WaitForSingleObject(handles[i], INFINITE);
+        CloseHandle(handles[i]);
+    }
+
+    free(handles);
+#else
+    pthread_t *handles = calloc(count, sizeof(pthread_t));
+
+    for (size_t i = 0; i < count; i++) {
+        pthread_create(&handles[i], NULL, benchmark_thread_main, &threads[i]);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        pthread_join(handles[i], NULL);
+    }
+
+    free(handles);
+#endif
+
+    return benchmark_now() - start;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t max_threads = argc > 1 ? (size_t) strtoul(argv[1], NULL, 10) : benchmark_cpu_count();
+    size_t documents   = argc > 2 ? (size_t) strtoul(argv[2], NULL, 10) : 200000;
+    double single      = 0;
+
+    benchmark_thread_t *threads = calloc(max_threads, sizeof(benchmark_thread_t));
+
+    printf("%8s %16s %12s\n", "threads", "documents/s", "scaling");
+
+    for (size_t count = 1; count <= max_threads; count = count < max_threads && count * 2 > max_threads ? max_threads : count * 2) {
+        for (size_t i = 0; i < count; i++) {
+            threads[i] = (benchmark_thread_t) { .documents = documents, .seed = i, .written = 0 };
+        }
+
+        double elapsed    = benchmark_run(threads, count);
+        double throughput = (double) (documents * count) / elapsed;
+
+        single = count == 1 ? throughput : single;
+        printf("%8zu %16.0f %11.2fx\n", count, throughput, throughput / single);
+    }
+
+    free(threads);
+
+    return 0;
+}
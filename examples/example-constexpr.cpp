@@ -0,0 +1,35 @@
+#include <cstdio>
+#include <static-json-builder.hpp>
+
+using namespace static_json_builder;
+
+static constexpr auto health = render([] {
+    return Object(                         /*  {                  */
+        Prop("items", Array(               /*     "items": [      */
+            Null(),                        /*         null,       */
+            Bool(true),                    /*         true,       */
+            Int(1),                        /*         1,          */
+            String("hello")                /*         "hello",    */
+        ))                                 /*      ],             */
+    );                                     /*  },                 */
+});
+
+static_assert(health.view() == R"({"items":[null,true,1,"hello"]})");
+
+int main(int argc, char *argv[])
+{
+    (void) argv;
+
+    auto json = Object(                    /*  {                  */
+        Prop("health", Raw(health)),       /*     "health": {...} */
+        Prop("args",   Int(argc))          /*     "args": 1       */
+    );                                     /*  }                  */
+
+    char buffer[stringified_size(Object(Prop("health", Raw(health)), Prop("args", Int(INT64_MIN))))];
+    stringify_into_buffer(json, buffer);
+
+    std::printf("%s\n", health.c_str());  /*  {"items":[null,true,1,"hello"]}                      */
+    std::printf("%s\n", buffer);          /*  {"health":{"items":[null,true,1,"hello"]},"args":1}  */
+
+    return 0;
+}
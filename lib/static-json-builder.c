@@ -1,211 +1,5886 @@
-#include <inttypes.h>
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <float.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define JSON_HAVE_SSE2
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #include <immintrin.h>
+    #define JSON_HAVE_BASE64_KERNELS
+    #define JSON_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#if defined(STATIC_JSON_BUILDER_THREADS) && defined(_WIN32)
+    #if !defined(WIN32_LEAN_AND_MEAN)
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #if !defined(NOMINMAX)
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #include <io.h>
+    #include <limits.h>
+#elif defined(STATIC_JSON_BUILDER_THREADS)
+    #include <pthread.h>
+    #include <sched.h>
+    #include <unistd.h>
+    #include <errno.h>
+    #include <poll.h>
+#endif
+
+#if defined(_MSC_VER)
+    #define JSON_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+    #define JSON_THREAD_LOCAL __thread
+#else
+    #define JSON_THREAD_LOCAL _Thread_local
+#endif
 
 #include "static-json-builder.h"
 
-typedef void (*json_size_compute_func_t) (json_value_t *json, size_t *size);
-typedef void (*json_write_func_t)        (json_value_t *json, char  **cursor);
+/*
+ Longest "%" PRId64 and "%f" representations: "-9223372036854775808"
+ and "-" followed by 309 integral digits, "." and 6 fractional digits.
+*/
+
+#define JSON_INT_MAX_LENGTH   20
+#define JSON_FLOAT_MAX_LENGTH 317
+#define JSON_FLOAT_DECIMALS   6
+
+/*
+ Numbers are formatted and parsed without stdio, so neither touches the
+ locale. Big integer holds the largest double multiplied by 10^6 when
+ formatting, and 10^1092 shifted by 58 bits when parsing: the largest
+ divisor of 768 significant digits which still can't round to zero.
+*/
+
+#define JSON_BIG_UINT_WORDS     120
+#define JSON_DECIMAL_MAX_DIGITS 768
+
+#define JSON_PARSE_MAX_DEPTH  1024
+#define JSON_NODE_ALIGNMENT   8
+
+#define JSON_TABLE_CACHED_KEYS 64
+
+/* Object index keeps at least twice as many slots as keys, so probes stay short */
+#define JSON_INDEX_MIN_SLOTS 8
+#define JSON_INDEX_HASH_MASK UINT64_C(0xFFFFFFFF00000000)
+
+/* Overlay patches up to this size are matched against the base once per walk */
+#define JSON_OVERLAY_PLAN_SIZE 32
+
+/*
+ Streaming writers check the space before every node, so a chunk keeps
+ a slack for the longest piece written without a check: a float number.
+*/
+
+#define JSON_PIPELINE_SLACK      512
+#define JSON_PIPELINE_MIN_CHUNK  4096
+#define JSON_PIPELINE_MIN_CHUNKS 2
+#define JSON_BOUNDED_SCRATCH     (JSON_PIPELINE_SLACK * 4)
+
+/*
+ Log records are aligned so that a record header always fits before the
+ end of the ring, a record may take at most half of the ring to be sure
+ that it fits after the padding of a wrap.
+*/
+
+#define JSON_LOG_ALIGNMENT    16
+#define JSON_LOG_MIN_CAPACITY 65536
+#define JSON_LOG_IDLE_YIELDS  64
+#define JSON_LOG_PADDING      ((size_t) 1 << (sizeof(size_t) * 8 - 1))
+
+#define JSON_REUSE_WINDOW        256
+#define JSON_REUSE_SHRINK_FACTOR 4
+#define JSON_REUSE_MIN_CAPACITY  4096
+
+#define JSON_SNAPSHOT_MAGIC      "SJBSNAP"
+#define JSON_SNAPSHOT_VERSION    1
+#define JSON_SNAPSHOT_BYTE_ORDER 0x01020304u
+
+/*
+ Snapshot is a header followed by records addressed with offsets from the
+ snapshot start. Nodes are stored by value: an array record is its size
+ followed by entry nodes, an object record is its size followed by pairs of
+ key offset and entry node, a string record is its length followed by the
+ zero terminated bytes. Every record is aligned to 8 bytes.
+*/
+
+typedef struct json_snapshot_node_t
+{
+    uint32_t type;
+    uint32_t width;
+    union
+    {
+        uint64_t boolean;
+        int64_t  integer;
+        double   floating;
+        uint64_t offset;
+    } as;
+} json_snapshot_node_t;
+
+typedef struct json_snapshot_prop_t
+{
+    uint64_t             key;
+    json_snapshot_node_t entry;
+} json_snapshot_prop_t;
+
+struct json_snapshot_t
+{
+    char                 magic[8];
+    uint32_t             version;
+    uint32_t             byte_order;
+    uint64_t             size;
+    json_snapshot_node_t root;
+};
+
+/*
+ Reusable buffer belongs to a thread and only grows to the needed sizes.
+ It keeps the peak size of the last window of calls, and when a whole window
+ needed a few times less than the capacity, it shrinks down to that peak.
+*/
+
+typedef struct json_reuse_buffer_t
+{
+    char  *memory;
+    size_t capacity;
+    size_t window_peak;
+    size_t window_calls;
+} json_reuse_buffer_t;
+
+static JSON_THREAD_LOCAL json_reuse_buffer_t json_reuse_buffer;
+
+typedef struct json_table_key_t
+{
+    const char *text;
+    size_t      size;
+} json_table_key_t;
+
+typedef struct json_emitter_t       json_emitter_t;
+typedef struct json_size_context_t  json_size_context_t;
+typedef struct json_write_context_t json_write_context_t;
+
+typedef void (*json_size_compute_func_t) (json_value_t *json, json_size_context_t  *context);
+typedef void (*json_write_func_t)        (json_value_t *json, json_write_context_t *context);
+
+typedef void (*json_size_frame_func_t)   (json_size_context_t  *context, json_value_type_t type, size_t count);
+typedef void (*json_size_key_func_t)     (json_size_context_t  *context, const char *key);
+typedef void (*json_write_frame_func_t)  (json_write_context_t *context, json_value_type_t type, size_t count);
+typedef void (*json_write_key_func_t)    (json_write_context_t *context, const char *key);
+typedef void (*json_write_flush_func_t)  (json_write_context_t *context);
+
+/*
+ Emitter is an output format backend: per-type size and write functions.
+ Container functions recurse through the emitter of the context,
+ so every backend walks the same json trees with its own encoding.
+
+ Nodes that produce arrays and objects without json_array_t and json_object_t
+ use the frame functions: `size_frame` accounts punctuation of a container with
+ `count` entries, `write_begin`, `write_separator` (before entry `count`) and
+ `write_end` emit it, `size_key` and `write_key` handle object keys.
+*/
+
+struct json_emitter_t
+{
+    const json_size_compute_func_t *size_compute_func_by_type;
+    const json_write_func_t        *write_func_by_type;
+    json_size_frame_func_t          size_frame;
+    json_size_key_func_t            size_key;
+    json_write_frame_func_t         write_begin;
+    json_write_frame_func_t         write_separator;
+    json_write_key_func_t           write_key;
+    json_write_frame_func_t         write_end;
+    bool                            write_begin_needs_count;
+};
+
+/*
+ `options` are the json_stringify_option_t flags of the text emitters,
+ sizing sets `invalid` when a string is not valid UTF-8.
+*/
+
+struct json_size_context_t
+{
+    const json_emitter_t *emitter;
+    size_t                size;
+    unsigned              options;
+    bool                  invalid;
+};
+
+/*
+ Streaming writers set `flush`, which hands the filled part of the buffer
+ over and switches to the next buffer. Raw writes are split at `end`,
+ nodes are started only below `limit`.
+*/
+
+struct json_write_context_t
+{
+    const json_emitter_t   *emitter;
+    char                   *buffer;
+    char                   *cursor;
+    json_slot_t            *slots;
+    size_t                  slots_count;
+    char                   *end;
+    char                   *limit;
+    json_write_flush_func_t flush;
+    void                   *sink;
+    unsigned                options;
+};
 
-static void json_size_compute_func_for_null     (json_value_t *json, size_t *size);
-static void json_size_compute_func_for_bool     (json_value_t *json, size_t *size);
-static void json_size_compute_func_for_int      (json_value_t *json, size_t *size);
-static void json_size_compute_func_for_floating (json_value_t *json, size_t *size);
-static void json_size_compute_func_for_string   (json_value_t *json, size_t *size);
-static void json_size_compute_func_for_array    (json_value_t *json, size_t *size);
-static void json_size_compute_func_for_object   (json_value_t *json, size_t *size);
+static void json_size_compute_func_for_null       (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_bool       (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_int        (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_floating   (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_string     (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_array      (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_object     (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_padded     (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_snapshot   (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_generator  (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_table      (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_compact    (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_base64     (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_overlay    (json_value_t *json, json_size_context_t *context);
+static void json_size_compute_func_for_projection (json_value_t *json, json_size_context_t *context);
 
 static const json_size_compute_func_t json_size_compute_func_by_type[JSON_VALUE_TYPE_MAX] = {
-    [JSON_VALUE_TYPE_NULL]   = json_size_compute_func_for_null,
-    [JSON_VALUE_TYPE_BOOL]   = json_size_compute_func_for_bool,
-    [JSON_VALUE_TYPE_INT]    = json_size_compute_func_for_int,
-    [JSON_VALUE_TYPE_FLOAT]  = json_size_compute_func_for_floating,
-    [JSON_VALUE_TYPE_STRING] = json_size_compute_func_for_string,
-    [JSON_VALUE_TYPE_ARRAY]  = json_size_compute_func_for_array,
-    [JSON_VALUE_TYPE_OBJECT] = json_size_compute_func_for_object,
-};
-
-static void json_write_func_for_null     (json_value_t *json, char **cursor);
-static void json_write_func_for_bool     (json_value_t *json, char **cursor);
-static void json_write_func_for_int      (json_value_t *json, char **cursor);
-static void json_write_func_for_floating (json_value_t *json, char **cursor);
-static void json_write_func_for_string   (json_value_t *json, char **cursor);
-static void json_write_func_for_array    (json_value_t *json, char **cursor);
-static void json_write_func_for_object   (json_value_t *json, char **cursor);
+    [JSON_VALUE_TYPE_NULL]             = json_size_compute_func_for_null,
+    [JSON_VALUE_TYPE_BOOL]             = json_size_compute_func_for_bool,
+    [JSON_VALUE_TYPE_INT]              = json_size_compute_func_for_int,
+    [JSON_VALUE_TYPE_FLOAT]            = json_size_compute_func_for_floating,
+    [JSON_VALUE_TYPE_STRING]           = json_size_compute_func_for_string,
+    [JSON_VALUE_TYPE_ARRAY]            = json_size_compute_func_for_array,
+    [JSON_VALUE_TYPE_OBJECT]           = json_size_compute_func_for_object,
+    [JSON_VALUE_TYPE_PADDED]           = json_size_compute_func_for_padded,
+    [JSON_VALUE_TYPE_SNAPSHOT]         = json_size_compute_func_for_snapshot,
+    [JSON_VALUE_TYPE_ARRAY_GENERATOR]  = json_size_compute_func_for_generator,
+    [JSON_VALUE_TYPE_OBJECT_GENERATOR] = json_size_compute_func_for_generator,
+    [JSON_VALUE_TYPE_TABLE]            = json_size_compute_func_for_table,
+    [JSON_VALUE_TYPE_COMPACT]          = json_size_compute_func_for_compact,
+    [JSON_VALUE_TYPE_BASE64]           = json_size_compute_func_for_base64,
+    [JSON_VALUE_TYPE_OVERLAY]          = json_size_compute_func_for_overlay,
+    [JSON_VALUE_TYPE_PROJECTION]       = json_size_compute_func_for_projection,
+};
+
+static void json_write_func_for_null       (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_bool       (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_int        (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_floating   (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_string     (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_array      (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_object     (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_padded     (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_snapshot   (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_generator  (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_table      (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_compact    (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_base64     (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_overlay    (json_value_t *json, json_write_context_t *context);
+static void json_write_func_for_projection (json_value_t *json, json_write_context_t *context);
 
 static const json_write_func_t json_write_func_by_type[JSON_VALUE_TYPE_MAX] = {
-    [JSON_VALUE_TYPE_NULL]   = json_write_func_for_null,
-    [JSON_VALUE_TYPE_BOOL]   = json_write_func_for_bool,
-    [JSON_VALUE_TYPE_INT]    = json_write_func_for_int,
-    [JSON_VALUE_TYPE_FLOAT]  = json_write_func_for_floating,
-    [JSON_VALUE_TYPE_STRING] = json_write_func_for_string,
-    [JSON_VALUE_TYPE_ARRAY]  = json_write_func_for_array,
-    [JSON_VALUE_TYPE_OBJECT] = json_write_func_for_object,
+    [JSON_VALUE_TYPE_NULL]             = json_write_func_for_null,
+    [JSON_VALUE_TYPE_BOOL]             = json_write_func_for_bool,
+    [JSON_VALUE_TYPE_INT]              = json_write_func_for_int,
+    [JSON_VALUE_TYPE_FLOAT]            = json_write_func_for_floating,
+    [JSON_VALUE_TYPE_STRING]           = json_write_func_for_string,
+    [JSON_VALUE_TYPE_ARRAY]            = json_write_func_for_array,
+    [JSON_VALUE_TYPE_OBJECT]           = json_write_func_for_object,
+    [JSON_VALUE_TYPE_PADDED]           = json_write_func_for_padded,
+    [JSON_VALUE_TYPE_SNAPSHOT]         = json_write_func_for_snapshot,
+    [JSON_VALUE_TYPE_ARRAY_GENERATOR]  = json_write_func_for_generator,
+    [JSON_VALUE_TYPE_OBJECT_GENERATOR] = json_write_func_for_generator,
+    [JSON_VALUE_TYPE_TABLE]            = json_write_func_for_table,
+    [JSON_VALUE_TYPE_COMPACT]          = json_write_func_for_compact,
+    [JSON_VALUE_TYPE_BASE64]           = json_write_func_for_base64,
+    [JSON_VALUE_TYPE_OVERLAY]          = json_write_func_for_overlay,
+    [JSON_VALUE_TYPE_PROJECTION]       = json_write_func_for_projection,
+};
+
+static void json_size_frame     (json_size_context_t  *context, json_value_type_t type, size_t count);
+static void json_size_key       (json_size_context_t  *context, const char *key);
+static void json_write_begin    (json_write_context_t *context, json_value_type_t type, size_t count);
+static void json_write_separator(json_write_context_t *context, json_value_type_t type, size_t count);
+static void json_write_key      (json_write_context_t *context, const char *key);
+static void json_write_end      (json_write_context_t *context, json_value_type_t type, size_t count);
+
+static const json_emitter_t json_emitter_text = {
+    .size_compute_func_by_type = json_size_compute_func_by_type,
+    .write_func_by_type        = json_write_func_by_type,
+    .size_frame                = json_size_frame,
+    .size_key                  = json_size_key,
+    .write_begin               = json_write_begin,
+    .write_separator           = json_write_separator,
+    .write_key                 = json_write_key,
+    .write_end                 = json_write_end,
+    .write_begin_needs_count   = false,
+};
+
+static void json_bound_size_compute_func_for_bool     (json_value_t *json, json_size_context_t *context);
+static void json_bound_size_compute_func_for_int      (json_value_t *json, json_size_context_t *context);
+static void json_bound_size_compute_func_for_floating (json_value_t *json, json_size_context_t *context);
+static void json_bound_size_compute_func_for_padded   (json_value_t *json, json_size_context_t *context);
+
+static const json_size_compute_func_t json_bound_size_compute_func_by_type[JSON_VALUE_TYPE_MAX] = {
+    [JSON_VALUE_TYPE_NULL]             = json_size_compute_func_for_null,
+    [JSON_VALUE_TYPE_BOOL]             = json_bound_size_compute_func_for_bool,
+    [JSON_VALUE_TYPE_INT]              = json_bound_size_compute_func_for_int,
+    [JSON_VALUE_TYPE_FLOAT]            = json_bound_size_compute_func_for_floating,
+    [JSON_VALUE_TYPE_STRING]           = json_size_compute_func_for_string,
+    [JSON_VALUE_TYPE_ARRAY]            = json_size_compute_func_for_array,
+    [JSON_VALUE_TYPE_OBJECT]           = json_size_compute_func_for_object,
+    [JSON_VALUE_TYPE_PADDED]           = json_bound_size_compute_func_for_padded,
+    [JSON_VALUE_TYPE_SNAPSHOT]         = json_size_compute_func_for_snapshot,
+    [JSON_VALUE_TYPE_ARRAY_GENERATOR]  = json_size_compute_func_for_generator,
+    [JSON_VALUE_TYPE_OBJECT_GENERATOR] = json_size_compute_func_for_generator,
+    [JSON_VALUE_TYPE_TABLE]            = json_size_compute_func_for_table,
+    [JSON_VALUE_TYPE_COMPACT]          = json_size_compute_func_for_compact,
+    [JSON_VALUE_TYPE_BASE64]           = json_size_compute_func_for_base64,
+    [JSON_VALUE_TYPE_OVERLAY]          = json_size_compute_func_for_overlay,
+    [JSON_VALUE_TYPE_PROJECTION]       = json_size_compute_func_for_projection,
 };
 
-static size_t json_size_compute(json_value_t *json)
+/*
+ Bound emitter writes exactly like the text one, but its sizing pass
+ doesn't format numbers and counts their widest representations instead.
+*/
+
+static const json_emitter_t json_emitter_text_bound = {
+    .size_compute_func_by_type = json_bound_size_compute_func_by_type,
+    .write_func_by_type        = json_write_func_by_type,
+    .size_frame                = json_size_frame,
+    .size_key                  = json_size_key,
+    .write_begin               = json_write_begin,
+    .write_separator           = json_write_separator,
+    .write_key                 = json_write_key,
+    .write_end                 = json_write_end,
+    .write_begin_needs_count   = false,
+};
+
+/*
+ Discard emitter writes nothing and doesn't descend into containers, a
+ bounded writer switches to it once the output is known not to fit, so
+ the rest of the tree is skipped.
+*/
+
+static void json_discard_write(json_value_t *json, json_write_context_t *context)
 {
-    size_t size = 0;
-    json_size_compute_func_by_type[json->type](json, &size);
-    return size;
+    (void) json;
+    (void) context;
 }
 
-static size_t json_write(json_value_t *json, char *buffer)
+static void json_discard_write_frame(json_write_context_t *context, json_value_type_t type, size_t count)
 {
-    char *cursor = buffer;
-    json_write_func_by_type[json->type](json, &cursor);
-    return (size_t) (cursor - buffer);
+    (void) context;
+    (void) type;
+    (void) count;
 }
 
-static void json_size_compute_func_for_null(json_value_t *json,  size_t *size)
+static void json_discard_write_key(json_write_context_t *context, const char *key)
 {
-    (void) json;
-    *size += strlen("null");
+    (void) context;
+    (void) key;
 }
 
-static void json_size_compute_func_for_bool(json_value_t *json, size_t *size)
+static const json_write_func_t json_discard_write_func_by_type[JSON_VALUE_TYPE_MAX] = {
+    [JSON_VALUE_TYPE_NULL]             = json_discard_write,
+    [JSON_VALUE_TYPE_BOOL]             = json_discard_write,
+    [JSON_VALUE_TYPE_INT]              = json_discard_write,
+    [JSON_VALUE_TYPE_FLOAT]            = json_discard_write,
+    [JSON_VALUE_TYPE_STRING]           = json_discard_write,
+    [JSON_VALUE_TYPE_ARRAY]            = json_discard_write,
+    [JSON_VALUE_TYPE_OBJECT]           = json_discard_write,
+    [JSON_VALUE_TYPE_PADDED]           = json_discard_write,
+    [JSON_VALUE_TYPE_SNAPSHOT]         = json_discard_write,
+    [JSON_VALUE_TYPE_ARRAY_GENERATOR]  = json_discard_write,
+    [JSON_VALUE_TYPE_OBJECT_GENERATOR] = json_discard_write,
+    [JSON_VALUE_TYPE_TABLE]            = json_discard_write,
+    [JSON_VALUE_TYPE_COMPACT]          = json_discard_write,
+    [JSON_VALUE_TYPE_BASE64]           = json_discard_write,
+    [JSON_VALUE_TYPE_OVERLAY]          = json_discard_write,
+    [JSON_VALUE_TYPE_PROJECTION]       = json_discard_write,
+};
+
+static const json_emitter_t json_emitter_discard = {
+    .size_compute_func_by_type = json_size_compute_func_by_type,
+    .write_func_by_type        = json_discard_write_func_by_type,
+    .size_frame                = json_size_frame,
+    .size_key                  = json_size_key,
+    .write_begin               = json_discard_write_frame,
+    .write_separator           = json_discard_write_frame,
+    .write_key                 = json_discard_write_key,
+    .write_end                 = json_discard_write_frame,
+    .write_begin_needs_count   = false,
+};
+
+static void json_msgpack_size_compute_func_for_null     (json_value_t *json, json_size_context_t *context);
+static void json_msgpack_size_compute_func_for_bool     (json_value_t *json, json_size_context_t *context);
+static void json_msgpack_size_compute_func_for_int      (json_value_t *json, json_size_context_t *context);
+static void json_msgpack_size_compute_func_for_floating (json_value_t *json, json_size_context_t *context);
+static void json_msgpack_size_compute_func_for_string   (json_value_t *json, json_size_context_t *context);
+static void json_msgpack_size_compute_func_for_array    (json_value_t *json, json_size_context_t *context);
+static void json_msgpack_size_compute_func_for_object   (json_value_t *json, json_size_context_t *context);
+static void json_msgpack_size_compute_func_for_padded   (json_value_t *json, json_size_context_t *context);
+static void json_msgpack_size_compute_func_for_base64   (json_value_t *json, json_size_context_t *context);
+
+static const json_size_compute_func_t json_msgpack_size_compute_func_by_type[JSON_VALUE_TYPE_MAX] = {
+    [JSON_VALUE_TYPE_NULL]             = json_msgpack_size_compute_func_for_null,
+    [JSON_VALUE_TYPE_BOOL]             = json_msgpack_size_compute_func_for_bool,
+    [JSON_VALUE_TYPE_INT]              = json_msgpack_size_compute_func_for_int,
+    [JSON_VALUE_TYPE_FLOAT]            = json_msgpack_size_compute_func_for_floating,
+    [JSON_VALUE_TYPE_STRING]           = json_msgpack_size_compute_func_for_string,
+    [JSON_VALUE_TYPE_ARRAY]            = json_msgpack_size_compute_func_for_array,
+    [JSON_VALUE_TYPE_OBJECT]           = json_msgpack_size_compute_func_for_object,
+    [JSON_VALUE_TYPE_PADDED]           = json_msgpack_size_compute_func_for_padded,
+    [JSON_VALUE_TYPE_SNAPSHOT]         = json_size_compute_func_for_snapshot,
+    [JSON_VALUE_TYPE_ARRAY_GENERATOR]  = json_size_compute_func_for_generator,
+    [JSON_VALUE_TYPE_OBJECT_GENERATOR] = json_size_compute_func_for_generator,
+    [JSON_VALUE_TYPE_TABLE]            = json_size_compute_func_for_table,
+    [JSON_VALUE_TYPE_COMPACT]          = json_size_compute_func_for_compact,
+    [JSON_VALUE_TYPE_BASE64]           = json_msgpack_size_compute_func_for_base64,
+    [JSON_VALUE_TYPE_OVERLAY]          = json_size_compute_func_for_overlay,
+    [JSON_VALUE_TYPE_PROJECTION]       = json_size_compute_func_for_projection,
+};
+
+static void json_msgpack_write_func_for_null     (json_value_t *json, json_write_context_t *context);
+static void json_msgpack_write_func_for_bool     (json_value_t *json, json_write_context_t *context);
+static void json_msgpack_write_func_for_int      (json_value_t *json, json_write_context_t *context);
+static void json_msgpack_write_func_for_floating (json_value_t *json, json_write_context_t *context);
+static void json_msgpack_write_func_for_string   (json_value_t *json, json_write_context_t *context);
+static void json_msgpack_write_func_for_array    (json_value_t *json, json_write_context_t *context);
+static void json_msgpack_write_func_for_object   (json_value_t *json, json_write_context_t *context);
+static void json_msgpack_write_func_for_padded   (json_value_t *json, json_write_context_t *context);
+static void json_msgpack_write_func_for_base64   (json_value_t *json, json_write_context_t *context);
+
+static const json_write_func_t json_msgpack_write_func_by_type[JSON_VALUE_TYPE_MAX] = {
+    [JSON_VALUE_TYPE_NULL]             = json_msgpack_write_func_for_null,
+    [JSON_VALUE_TYPE_BOOL]             = json_msgpack_write_func_for_bool,
+    [JSON_VALUE_TYPE_INT]              = json_msgpack_write_func_for_int,
+    [JSON_VALUE_TYPE_FLOAT]            = json_msgpack_write_func_for_floating,
+    [JSON_VALUE_TYPE_STRING]           = json_msgpack_write_func_for_string,
+    [JSON_VALUE_TYPE_ARRAY]            = json_msgpack_write_func_for_array,
+    [JSON_VALUE_TYPE_OBJECT]           = json_msgpack_write_func_for_object,
+    [JSON_VALUE_TYPE_PADDED]           = json_msgpack_write_func_for_padded,
+    [JSON_VALUE_TYPE_SNAPSHOT]         = json_write_func_for_snapshot,
+    [JSON_VALUE_TYPE_ARRAY_GENERATOR]  = json_write_func_for_generator,
+    [JSON_VALUE_TYPE_OBJECT_GENERATOR] = json_write_func_for_generator,
+    [JSON_VALUE_TYPE_TABLE]            = json_write_func_for_table,
+    [JSON_VALUE_TYPE_COMPACT]          = json_write_func_for_compact,
+    [JSON_VALUE_TYPE_BASE64]           = json_msgpack_write_func_for_base64,
+    [JSON_VALUE_TYPE_OVERLAY]          = json_write_func_for_overlay,
+    [JSON_VALUE_TYPE_PROJECTION]       = json_write_func_for_projection,
+};
+
+static void json_msgpack_size_frame     (json_size_context_t  *context, json_value_type_t type, size_t count);
+static void json_msgpack_size_key       (json_size_context_t  *context, const char *key);
+static void json_msgpack_write_begin    (json_write_context_t *context, json_value_type_t type, size_t count);
+static void json_msgpack_write_separator(json_write_context_t *context, json_value_type_t type, size_t count);
+static void json_msgpack_write_key      (json_write_context_t *context, const char *key);
+static void json_msgpack_write_end      (json_write_context_t *context, json_value_type_t type, size_t count);
+
+static const json_emitter_t json_emitter_msgpack = {
+    .size_compute_func_by_type = json_msgpack_size_compute_func_by_type,
+    .write_func_by_type        = json_msgpack_write_func_by_type,
+    .size_frame                = json_msgpack_size_frame,
+    .size_key                  = json_msgpack_size_key,
+    .write_begin               = json_msgpack_write_begin,
+    .write_separator           = json_msgpack_write_separator,
+    .write_key                 = json_msgpack_write_key,
+    .write_end                 = json_msgpack_write_end,
+    .write_begin_needs_count   = true,
+};
+
+static void json_size_compute(json_value_t *json, json_size_context_t *context)
 {
-    *size += json->as.boolean ? strlen("true") : strlen("false");
+    context->emitter->size_compute_func_by_type[json->type](json, context);
 }
 
-static void json_size_compute_func_for_int(json_value_t *json, size_t *size)
+static void json_write(json_value_t *json, json_write_context_t *context)
 {
-    *size += snprintf(NULL, 0, "%" PRId64, json->as.integer);
+    if (context->flush != NULL && context->cursor > context->limit) {
+        context->flush(context);
+    }
+
+    context->emitter->write_func_by_type[json->type](json, context);
 }
 
-static void json_size_compute_func_for_floating(json_value_t *json, size_t *size)
+static size_t json_emit_size(const json_emitter_t *emitter, json_value_t *json)
 {
-    *size += snprintf(NULL, 0, "%f", json->as.floating);
+    json_size_context_t context = {
+        .emitter = emitter,
+        .size    = 0,
+    };
+
+    json_size_compute(json, &context);
+    return context.size;
 }
 
-static void json_size_compute_func_for_string(json_value_t *json, size_t *size)
+static size_t json_emit(const json_emitter_t *emitter, json_value_t *json, char *buffer, json_slot_t *slots)
 {
-    *size += strlen("\"") + strlen(json->as.string) + strlen("\"");
+    json_write_context_t context = {
+        .emitter     = emitter,
+        .buffer      = buffer,
+        .cursor      = buffer,
+        .slots       = slots,
+        .slots_count = 0,
+    };
+
+    json_write(json, &context);
+    return (size_t) (context.cursor - buffer);
 }
 
-static void json_size_compute_func_for_array(json_value_t *json, size_t *size)
+static void json_write_raw(json_write_context_t *context, const void *data, size_t size)
 {
-    *size += strlen("[");
+    while (context->flush != NULL && size > (size_t) (context->end - context->cursor)) {
+        size_t part = (size_t) (context->end - context->cursor);
 
-    for (size_t i = 0; i < json->as.array->size; i++) {
-        if (i != 0) {
-            *size += strlen(",");
-        }
+        memcpy(context->cursor, data, part);
+        context->cursor += part;
+        data             = (const char *) data + part;
+        size            -= part;
 
-        *size += json_size_compute(json->as.array->entries[i]);
+        context->flush(context);
     }
 
-    *size += strlen("]");
+    memcpy(context->cursor, data, size);
+    context->cursor += size;
 }
 
-static void json_size_compute_func_for_object(json_value_t *json, size_t *size)
+static unsigned json_count_trailing_zeros(unsigned mask)
 {
-    *size += strlen("{");
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return (unsigned) index;
+#else
+    return (unsigned) __builtin_ctz(mask);
+#endif
+}
 
-    for (size_t i = 0; i < json->as.object->size; i++) {
-        json_prop_t *property = json->as.object->props[i];
+static bool json_is_string_special(char character)
+{
+    return character == '"' || character == '\\' || (unsigned char) character < 0x20;
+}
 
-        if (i != 0) {
-            *size += strlen(",");
+/*
+ Finds the first character that can't be copied into a json string as is:
+ a quote, a backslash or a control character. Compares 16 bytes at once
+ when SSE2 is available, the tail is always checked one byte at a time.
+*/
+
+static const char *json_scan_string_special(const char *cursor, const char *end)
+{
+#if defined(JSON_HAVE_SSE2)
+    const __m128i quote     = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control   = _mm_set1_epi8(0x1f);
+
+    while (end - cursor >= 16) {
+        __m128i chunk   = _mm_loadu_si128((const __m128i *) cursor);
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+
+        unsigned mask = (unsigned) _mm_movemask_epi8(special);
+
+        if (mask != 0) {
+            return cursor + json_count_trailing_zeros(mask);
         }
 
-        *size += strlen("\"") + strlen(property->key) + strlen("\":");
-        *size += json_size_compute(property->entry);
+        cursor += 16;
+    }
+#endif
+
+    while (cursor < end && !json_is_string_special(*cursor)) {
+        cursor++;
+    }
+
+    return cursor;
+}
+
+static const char *json_escape_sequence(char character)
+{
+    switch (character) {
+    case '"':  return "\\\"";
+    case '\\': return "\\\\";
+    case '\b': return "\\b";
+    case '\f': return "\\f";
+    case '\n': return "\\n";
+    case '\r': return "\\r";
+    case '\t': return "\\t";
+    default:   return NULL;
+    }
+}
+
+static size_t json_escaped_size(const char *string)
+{
+    const char *end    = string + strlen(string);
+    const char *cursor = json_scan_string_special(string, end);
+    size_t      size   = (size_t) (end - string);
+
+    while (cursor < end) {
+        const char *sequence = json_escape_sequence(*cursor);
+
+        size  += (sequence ? strlen(sequence) : strlen("\\u0000")) - 1;
+        cursor = json_scan_string_special(cursor + 1, end);
     }
 
-    *size += strlen("}");
+    return size;
 }
 
-static void json_write_func_for_null(json_value_t *json, char **cursor)
+static void json_write_escaped(json_write_context_t *context, const char *string)
 {
-    *cursor += snprintf(*cursor, json_size_compute(json) + 1, "%s", "null");
+    const char *end = string + strlen(string);
+
+    while (string < end) {
+        const char *special = json_scan_string_special(string, end);
+
+        json_write_raw(context, string, (size_t) (special - string));
+
+        if (special == end) {
+            break;
+        }
+
+        const char *sequence = json_escape_sequence(*special);
+
+        if (sequence != NULL) {
+            json_write_raw(context, sequence, strlen(sequence));
+        } else {
+            char escape[] = { '\\', 'u', '0', '0', "0123456789abcdef"[(unsigned char) *special >> 4], "0123456789abcdef"[(unsigned char) *special & 0xf] };
+            json_write_raw(context, escape, sizeof(escape));
+        }
+
+        string = special + 1;
+    }
 }
 
-static void json_write_func_for_bool(json_value_t *json, char **cursor)
+/*
+ Checked strings stop the scan also at every byte past ASCII, which starts
+ a multibyte sequence to be validated. Clean ASCII blocks are still skipped
+ 16 bytes at once and copied as they are.
+*/
+
+static const char *json_scan_string_checked(const char *cursor, const char *end)
 {
-    *cursor += snprintf(*cursor, json_size_compute(json) + 1, "%s", json->as.boolean ? "true" : "false");
+#if defined(JSON_HAVE_SSE2)
+    const __m128i quote     = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control   = _mm_set1_epi8(0x1f);
+
+    while (end - cursor >= 16) {
+        __m128i chunk   = _mm_loadu_si128((const __m128i *) cursor);
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+
+        unsigned mask = (unsigned) (_mm_movemask_epi8(special) | _mm_movemask_epi8(chunk));
+
+        if (mask != 0) {
+            return cursor + json_count_trailing_zeros(mask);
+        }
+
+        cursor += 16;
+    }
+#endif
+
+    while (cursor < end && !json_is_string_special(*cursor) && (unsigned char) *cursor < 0x80) {
+        cursor++;
+    }
+
+    return cursor;
 }
 
-static void json_write_func_for_int(json_value_t *json, char **cursor)
+/* Returns the length of the valid UTF-8 sequence at the cursor or 0 for overlong forms, surrogates and values past U+10FFFF */
+static size_t json_utf8_decode(const char *cursor, const char *end, uint32_t *code_point)
 {
-    *cursor += snprintf(*cursor, json_size_compute(json) + 1, "%" PRId64, json->as.integer);
+    const unsigned char *bytes  = (const unsigned char *) cursor;
+    size_t               length = 0;
+    uint32_t             least  = 0;
+
+    if (bytes[0] < 0x80) {
+        *code_point = bytes[0];
+        return 1;
+    } else if ((bytes[0] & 0xe0) == 0xc0) {
+        length      = 2;
+        least       = 0x80;
+        *code_point = bytes[0] & 0x1f;
+    } else if ((bytes[0] & 0xf0) == 0xe0) {
+        length      = 3;
+        least       = 0x800;
+        *code_point = bytes[0] & 0x0f;
+    } else if ((bytes[0] & 0xf8) == 0xf0) {
+        length      = 4;
+        least       = 0x10000;
+        *code_point = bytes[0] & 0x07;
+    } else {
+        return 0;
+    }
+
+    if ((size_t) (end - cursor) < length) {
+        return 0;
+    }
+
+    for (size_t i = 1; i < length; i++) {
+        if ((bytes[i] & 0xc0) != 0x80) {
+            return 0;
+        }
+
+        *code_point = *code_point << 6 | (bytes[i] & 0x3f);
+    }
+
+    if (*code_point < least || *code_point > 0x10ffff || (*code_point >= 0xd800 && *code_point <= 0xdfff)) {
+        return 0;
+    }
+
+    return length;
 }
 
-static void json_write_func_for_floating(json_value_t *json, char **cursor)
+static size_t json_escaped_size_checked(json_size_context_t *context, const char *string)
 {
-    *cursor += snprintf(*cursor, json_size_compute(json) + 1, "%f", json->as.floating);
+    const char *end    = string + strlen(string);
+    const char *cursor = json_scan_string_checked(string, end);
+    size_t      size   = (size_t) (end - string);
+
+    while (cursor < end) {
+        uint32_t code_point = 0;
+        size_t   length     = json_utf8_decode(cursor, end, &code_point);
+
+        if (length == 0) {
+            context->invalid = true;
+            return size;
+        }
+
+        if (length == 1) {
+            const char *sequence = json_escape_sequence(*cursor);
+            size += (sequence ? strlen(sequence) : strlen("\\u0000")) - 1;
+        } else if (context->options & JSON_STRINGIFY_ESCAPE_NON_ASCII) {
+            /* Code points past the basic plane are escaped as surrogate pairs */
+            size += (code_point >= 0x10000 ? 2 * strlen("\\u0000") : strlen("\\u0000")) - length;
+        }
+
+        cursor = json_scan_string_checked(cursor + length, end);
+    }
+
+    return size;
 }
 
-static void json_write_func_for_string(json_value_t *json, char **cursor)
+static void json_write_unicode_escape(json_write_context_t *context, uint32_t unit)
 {
-    *cursor += snprintf(*cursor, json_size_compute(json) + 1, "\"%s\"", json->as.string);
+    static const char digits[] = "0123456789abcdef";
+
+    char escape[] = { '\\', 'u', digits[unit >> 12 & 0xf], digits[unit >> 8 & 0xf], digits[unit >> 4 & 0xf], digits[unit & 0xf] };
+    json_write_raw(context, escape, sizeof(escape));
 }
 
-static void json_write_func_for_array(json_value_t *json, char **cursor)
+/* Writes a string validated by the sizing pass with every non-ASCII character escaped */
+static void json_write_escaped_ascii(json_write_context_t *context, const char *string)
 {
-    *cursor += snprintf(*cursor, 2, "%c", '[');
+    const char *end = string + strlen(string);
 
-    for (size_t i = 0; i < json->as.array->size; i++) {
-        json_value_t *entry = json->as.array->entries[i];
+    while (string < end) {
+        const char *special = json_scan_string_checked(string, end);
 
-        if (i != 0) {
-            *cursor += snprintf(*cursor, 2, "%c", ',');
+        json_write_raw(context, string, (size_t) (special - string));
+
+        if (special == end) {
+            break;
+        }
+
+        uint32_t    code_point = 0;
+        size_t      length     = json_utf8_decode(special, end, &code_point);
+        const char *sequence   = length == 1 ? json_escape_sequence(*special) : NULL;
+
+        assert(length != 0 && "attempt to write json string which is not valid UTF-8");
+
+        if (sequence != NULL) {
+            json_write_raw(context, sequence, strlen(sequence));
+        } else if (code_point >= 0x10000) {
+            json_write_unicode_escape(context, 0xd800 + ((code_point - 0x10000) >> 10));
+            json_write_unicode_escape(context, 0xdc00 + ((code_point - 0x10000) & 0x3ff));
+        } else {
+            json_write_unicode_escape(context, code_point);
         }
 
-        *cursor += json_write(entry, *cursor);
+        string = special + (length != 0 ? length : 1);
+    }
+}
+
+/* Strings and keys of the text emitters, checked only when options are given */
+
+static size_t json_string_size(json_size_context_t *context, const char *string)
+{
+    if (context->options != 0) {
+        return json_escaped_size_checked(context, string);
     }
 
-    *cursor += snprintf(*cursor, 2, "%c", ']');
+    return json_escaped_size(string);
+}
+
+static void json_write_string(json_write_context_t *context, const char *string)
+{
+    if (context->options & JSON_STRINGIFY_ESCAPE_NON_ASCII) {
+        json_write_escaped_ascii(context, string);
+    } else {
+        json_write_escaped(context, string);
+    }
 }
 
-static void json_write_func_for_object(json_value_t *json, char **cursor)
+static size_t json_padded_int_digits(int64_t integer)
 {
-    *cursor += snprintf(*cursor, 2, "%c", '{');
+    uint64_t magnitude = integer < 0 ? 0 - (uint64_t) integer : (uint64_t) integer;
+    size_t   digits    = integer < 0 ? 2 : 1;
 
-    for (size_t i = 0; i < json->as.object->size; i++) {
-        json_prop_t *property = json->as.object->props[i];
+    while (magnitude >= 10) {
+        magnitude /= 10;
+        digits++;
+    }
 
-        if (i != 0) {
-            *cursor += snprintf(*cursor, 2, "%c", ',');
+    return digits;
+}
+
+static size_t json_format_int(char *buffer, int64_t integer)
+{
+    uint64_t magnitude = integer < 0 ? 0 - (uint64_t) integer : (uint64_t) integer;
+    size_t   length    = json_padded_int_digits(integer);
+    char    *cursor    = buffer + length;
+
+    do {
+        *--cursor  = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    if (integer < 0) {
+        *--cursor = '-';
+    }
+
+    return length;
+}
+
+typedef struct json_big_uint_t
+{
+    uint32_t words[JSON_BIG_UINT_WORDS];
+    size_t   length;
+} json_big_uint_t;
+
+static void json_big_uint_multiply(json_big_uint_t *number, uint32_t factor)
+{
+    uint64_t carry = 0;
+
+    for (size_t i = 0; i < number->length; i++) {
+        uint64_t product = (uint64_t) number->words[i] * factor + carry;
+
+        number->words[i] = (uint32_t) product;
+        carry            = product >> 32;
+    }
+
+    if (carry != 0) {
+        number->words[number->length++] = (uint32_t) carry;
+    }
+}
+
+static void json_big_uint_shift_left(json_big_uint_t *number, size_t bits)
+{
+    size_t words = bits / 32;
+    size_t shift = bits % 32;
+
+    number->words[number->length + words] = 0;
+
+    for (size_t i = number->length; i-- > 0;) {
+        number->words[i + words + 1] |= shift ? number->words[i] >> (32 - shift) : 0;
+        number->words[i + words]      = number->words[i] << shift;
+    }
+
+    memset(number->words, 0, words * sizeof(uint32_t));
+    number->length += words + 1;
+
+    while (number->length != 0 && number->words[number->length - 1] == 0) {
+        number->length--;
+    }
+}
+
+static bool json_big_uint_bit(const json_big_uint_t *number, size_t index)
+{
+    return index / 32 < number->length && (number->words[index / 32] >> (index % 32)) & 1;
+}
+
+static bool json_big_uint_any_below(const json_big_uint_t *number, size_t index)
+{
+    for (size_t i = 0; i < number->length && i * 32 < index; i++) {
+        uint32_t mask = index - i * 32 >= 32 ? UINT32_MAX : ((uint32_t) 1 << (index - i * 32)) - 1;
+
+        if (number->words[i] & mask) {
+            return true;
         }
+    }
 
-        *cursor += snprintf(*cursor, strlen(property->key) + 4, "\"%s\":", property->key);
-        *cursor += json_write(property->entry, *cursor);
+    return false;
+}
+
+static void json_big_uint_shift_right(json_big_uint_t *number, size_t bits)
+{
+    size_t words = bits / 32;
+    size_t shift = bits % 32;
+
+    if (words >= number->length) {
+        number->length = 0;
+        return;
     }
 
-    *cursor += snprintf(*cursor, 2, "%c", '}');
+    for (size_t i = 0; i + words < number->length; i++) {
+        uint32_t high = i + words + 1 < number->length ? number->words[i + words + 1] : 0;
+
+        number->words[i] = (number->words[i + words] >> shift) | (shift ? high << (32 - shift) : 0);
+    }
+
+    number->length -= words;
+
+    while (number->length != 0 && number->words[number->length - 1] == 0) {
+        number->length--;
+    }
 }
 
-char *json_stringify(json_value_t *json)
+static void json_big_uint_increment(json_big_uint_t *number)
 {
-    assert(json && "attempt to stringify json but json is a null pointer");
+    for (size_t i = 0; i < number->length; i++) {
+        if (++number->words[i] != 0) {
+            return;
+        }
+    }
 
-    size_t length = json_size_compute(json);
-    char  *buffer = calloc(length + 1, sizeof(char));
+    number->words[number->length++] = 1;
+}
 
-    if (buffer == NULL) {
-        return NULL;
+static void json_big_uint_add(json_big_uint_t *number, uint32_t addend)
+{
+    uint64_t carry = addend;
+
+    for (size_t i = 0; i < number->length && carry != 0; i++) {
+        uint64_t sum = (uint64_t) number->words[i] + carry;
+
+        number->words[i] = (uint32_t) sum;
+        carry            = sum >> 32;
     }
 
-    size_t written = json_write(json, buffer);
-    assert(length == written && "not all data was written to the buffer");
+    if (carry != 0) {
+        number->words[number->length++] = (uint32_t) carry;
+    }
+}
 
-    return buffer;
+static size_t json_big_uint_bits(const json_big_uint_t *number)
+{
+    size_t bits = number->length * 32;
+
+    for (uint32_t top = number->length ? number->words[number->length - 1] : UINT32_MAX; !(top & 0x80000000u); top <<= 1) {
+        bits--;
+    }
+
+    return bits;
 }
 
-void json_stringify_into_buffer(json_value_t *json, char *buffer)
+static uint32_t json_big_uint_divide(json_big_uint_t *number, uint32_t divisor)
 {
-    assert(json   && "attempt to write json into buffer but json is a null pointer");
-    assert(buffer && "attempt to write json into buffer but buffer is a null pointer");
+    uint64_t remainder = 0;
+
+    for (size_t i = number->length; i-- > 0;) {
+        uint64_t current = (remainder << 32) | number->words[i];
+
+        number->words[i] = (uint32_t) (current / divisor);
+        remainder        = current % divisor;
+    }
+
+    while (number->length != 0 && number->words[number->length - 1] == 0) {
+        number->length--;
+    }
 
-    json_write(json, buffer);
+    return (uint32_t) remainder;
 }
 
-size_t json_stingified_size(json_value_t *json)
+/*
+ Formats a double exactly like "%f". The double is mantissa * 2^exponent,
+ so the value multiplied by 10^6 is an exact big integer when the exponent
+ isn't negative. Otherwise the dropped bits decide the rounding: to nearest,
+ ties to even, which is what glibc does in the default rounding mode.
+*/
+
+static size_t json_format_float(char *buffer, double floating)
 {
-    assert(json && "attempt to get the json string size but json is a null pointer");
+    uint64_t bits     = 0;
+    char    *cursor   = buffer;
+
+    memcpy(&bits, &floating, sizeof(bits));
+
+    uint64_t fraction = bits & (((uint64_t) 1 << 52) - 1);
+    int      biased   = (int) ((bits >> 52) & 0x7ff);
+
+    if (bits >> 63) {
+        *cursor++ = '-';
+    }
+
+    if (biased == 0x7ff) {
+        memcpy(cursor, fraction != 0 ? "nan" : "inf", strlen("nan"));
+        return (size_t) (cursor - buffer) + strlen("nan");
+    }
+
+    uint64_t        mantissa = biased != 0 ? fraction | (uint64_t) 1 << 52 : fraction;
+    int             exponent = biased != 0 ? biased - 1075 : -1074;
+    json_big_uint_t scaled;
+
+    /* Words above the length are never read, so they are left uninitialized */
+    scaled.words[0] = (uint32_t) mantissa;
+    scaled.words[1] = (uint32_t) (mantissa >> 32);
+    scaled.length   = mantissa >> 32 ? 2 : mantissa ? 1 : 0;
+
+    json_big_uint_multiply(&scaled, 1000000);
+
+    if (exponent >= 0) {
+        json_big_uint_shift_left(&scaled, (size_t) exponent);
+    } else {
+        size_t dropped = (size_t) -exponent;
+        bool   half    = json_big_uint_bit(&scaled, dropped - 1);
+        bool   sticky  = json_big_uint_any_below(&scaled, dropped - 1);
+
+        json_big_uint_shift_right(&scaled, dropped);
+
+        if (half && (sticky || json_big_uint_bit(&scaled, 0))) {
+            json_big_uint_increment(&scaled);
+        }
+    }
+
+    /* Digits are produced from the lowest ones, nine at a time */
+    char   digits[JSON_FLOAT_MAX_LENGTH + 9];
+    size_t count = 0;
+
+    do {
+        uint32_t chunk = json_big_uint_divide(&scaled, 1000000000);
+
+        for (size_t i = 0; i < 9; i++) {
+            digits[count++] = (char) ('0' + chunk % 10);
+            chunk /= 10;
+        }
+    } while (scaled.length != 0);
+
+    while (count > JSON_FLOAT_DECIMALS + 1 && digits[count - 1] == '0') {
+        count--;
+    }
+
+    while (count > JSON_FLOAT_DECIMALS) {
+        *cursor++ = digits[--count];
+    }
+
+    *cursor++ = '.';
+
+    while (count != 0) {
+        *cursor++ = digits[--count];
+    }
+
+    return (size_t) (cursor - buffer);
+}
+
+static size_t json_float_length(double floating)
+{
+    char buffer[JSON_FLOAT_MAX_LENGTH];
+    return json_format_float(buffer, floating);
+}
+
+/*
+ Base64 is encoded by 12 input bytes at once with SSSE3 or 24 with AVX2
+ when the processor supports them: bytes are spread into 6-bit indexes
+ by shuffles and multiplications, and indexes become characters by adding
+ the offset of their range. The rest is encoded one group of 3 at a time.
+*/
+
+static const char json_base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static size_t json_base64_length(size_t size)
+{
+    return (size + 2) / 3 * 4;
+}
+
+#if defined(JSON_HAVE_BASE64_KERNELS)
+static JSON_TARGET("ssse3") __m128i json_base64_indexes_ssse3(__m128i input)
+{
+    input = _mm_shuffle_epi8(input, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    __m128i high = _mm_mulhi_epu16(_mm_and_si128(input, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    __m128i low  = _mm_mullo_epi16(_mm_and_si128(input, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+
+    return _mm_or_si128(high, low);
+}
+
+static JSON_TARGET("ssse3") __m128i json_base64_characters_ssse3(__m128i indexes)
+{
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    /* Range 0 is A-Z, 1 is a-z, 2-11 are digits, 12 is '+' and 13 is '/' */
+    __m128i range = _mm_subs_epu8(indexes, _mm_set1_epi8(51));
+    range         = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indexes), _mm_set1_epi8(13)));
+
+    return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indexes);
+}
+
+static JSON_TARGET("ssse3") size_t json_base64_encode_ssse3(char *output, const uint8_t *input, size_t size)
+{
+    size_t consumed = 0;
+
+    /* Every load reads 16 bytes and encodes the first 12 of them */
+    for (; size - consumed >= 16; consumed += 12, output += 16) {
+        __m128i indexes = json_base64_indexes_ssse3(_mm_loadu_si128((const __m128i *) (input + consumed)));
+        _mm_storeu_si128((__m128i *) output, json_base64_characters_ssse3(indexes));
+    }
+
+    return consumed;
+}
+
+static JSON_TARGET("avx2") size_t json_base64_encode_avx2(char *output, const uint8_t *input, size_t size)
+{
+    const __m256i shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                            10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                                             'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    size_t consumed = 0;
+
+    /* Each lane encodes its own 12 bytes, the upper lane is loaded from the 12th byte */
+    for (; size - consumed >= 28; consumed += 24, output += 32) {
+        __m256i input_lanes = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) (input + consumed))),
+                                                      _mm_loadu_si128((const __m128i *) (input + consumed + 12)), 1);
+
+        input_lanes = _mm256_shuffle_epi8(input_lanes, shuffle);
+
+        __m256i high    = _mm256_mulhi_epu16(_mm256_and_si256(input_lanes, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+        __m256i low     = _mm256_mullo_epi16(_mm256_and_si256(input_lanes, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+        __m256i indexes = _mm256_or_si256(high, low);
+        __m256i range   = _mm256_subs_epu8(indexes, _mm256_set1_epi8(51));
+
+        range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indexes), _mm256_set1_epi8(13)));
+
+        _mm256_storeu_si256((__m256i *) output, _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indexes));
+    }
+
+    return consumed;
+}
+#endif
+
+static char *json_base64_encode(char *output, const uint8_t *input, size_t size)
+{
+    size_t consumed = 0;
+
+#if defined(JSON_HAVE_BASE64_KERNELS)
+    if (size >= 28 && __builtin_cpu_supports("avx2")) {
+        consumed = json_base64_encode_avx2(output, input, size);
+    } else if (size >= 16 && __builtin_cpu_supports("ssse3")) {
+        consumed = json_base64_encode_ssse3(output, input, size);
+    }
+
+    output += consumed / 3 * 4;
+#endif
+
+    for (; size - consumed >= 3; consumed += 3) {
+        uint32_t group = (uint32_t) input[consumed] << 16 | (uint32_t) input[consumed + 1] << 8 | input[consumed + 2];
+
+        *output++ = json_base64_alphabet[group >> 18];
+        *output++ = json_base64_alphabet[group >> 12 & 0x3f];
+        *output++ = json_base64_alphabet[group >> 6 & 0x3f];
+        *output++ = json_base64_alphabet[group & 0x3f];
+    }
+
+    if (size - consumed != 0) {
+        uint32_t group = (uint32_t) input[consumed] << 16 | (size - consumed == 2 ? (uint32_t) input[consumed + 1] << 8 : 0);
+
+        *output++ = json_base64_alphabet[group >> 18];
+        *output++ = json_base64_alphabet[group >> 12 & 0x3f];
+        *output++ = size - consumed == 2 ? json_base64_alphabet[group >> 6 & 0x3f] : '=';
+        *output++ = '=';
+    }
+
+    return output;
+}
+
+/* Streaming writers get the encoding in parts of whole groups which fit into the current buffer */
+static void json_write_base64(json_write_context_t *context, const uint8_t *input, size_t size)
+{
+    while (context->flush != NULL && size > (size_t) (context->end - context->cursor) / 4 * 3) {
+        size_t part = (size_t) (context->end - context->cursor) / 4 * 3;
+
+        context->cursor = json_base64_encode(context->cursor, input, part);
+        input          += part;
+        size           -= part;
+
+        context->flush(context);
+    }
+
+    context->cursor = json_base64_encode(context->cursor, input, size);
+}
+
+static void json_size_compute_func_for_null(json_value_t *json, json_size_context_t *context)
+{
+    (void) json;
+    context->size += strlen("null");
+}
+
+static void json_size_compute_func_for_bool(json_value_t *json, json_size_context_t *context)
+{
+    context->size += json->as.boolean ? strlen("true") : strlen("false");
+}
+
+static void json_size_compute_func_for_int(json_value_t *json, json_size_context_t *context)
+{
+    context->size += json_padded_int_digits(json->as.integer);
+}
+
+static void json_size_compute_func_for_floating(json_value_t *json, json_size_context_t *context)
+{
+    context->size += json_float_length(json->as.floating);
+}
+
+static void json_size_compute_func_for_string(json_value_t *json, json_size_context_t *context)
+{
+    context->size += strlen("\"") + json_string_size(context, json->as.string) + strlen("\"");
+}
+
+static void json_size_compute_func_for_base64(json_value_t *json, json_size_context_t *context)
+{
+    context->size += strlen("\"") + json_base64_length(json->as.base64->size) + strlen("\"");
+}
+
+static void json_size_compute_func_for_array(json_value_t *json, json_size_context_t *context)
+{
+    context->size += strlen("[");
+
+    for (size_t i = 0; i < json->as.array->size; i++) {
+        if (i != 0) {
+            context->size += strlen(",");
+        }
+
+        json_size_compute(json->as.array->entries[i], context);
+    }
+
+    context->size += strlen("]");
+}
+
+static void json_size_compute_func_for_object(json_value_t *json, json_size_context_t *context)
+{
+    context->size += strlen("{");
+
+    for (size_t i = 0; i < json->as.object->size; i++) {
+        json_prop_t *property = json->as.object->props[i];
+
+        if (i != 0) {
+            context->size += strlen(",");
+        }
+
+        context->size += strlen("\"") + json_string_size(context, property->key) + strlen("\":");
+        json_size_compute(property->entry, context);
+    }
+
+    context->size += strlen("}");
+}
+
+static void json_size_compute_func_for_padded(json_value_t *json, json_size_context_t *context)
+{
+    size_t digits = json_padded_int_digits(json->as.padded->integer);
+    context->size += digits > json->as.padded->width ? digits : json->as.padded->width;
+}
+
+static void json_bound_size_compute_func_for_bool(json_value_t *json, json_size_context_t *context)
+{
+    (void) json;
+    context->size += strlen("false");
+}
+
+static void json_bound_size_compute_func_for_int(json_value_t *json, json_size_context_t *context)
+{
+    (void) json;
+    context->size += JSON_INT_MAX_LENGTH;
+}
+
+static void json_bound_size_compute_func_for_floating(json_value_t *json, json_size_context_t *context)
+{
+    (void) json;
+    context->size += JSON_FLOAT_MAX_LENGTH;
+}
+
+static void json_bound_size_compute_func_for_padded(json_value_t *json, json_size_context_t *context)
+{
+    context->size += JSON_INT_MAX_LENGTH > json->as.padded->width ? JSON_INT_MAX_LENGTH : json->as.padded->width;
+}
+
+static void json_write_func_for_null(json_value_t *json, json_write_context_t *context)
+{
+    (void) json;
+    json_write_raw(context, "null", strlen("null"));
+}
+
+static void json_write_func_for_bool(json_value_t *json, json_write_context_t *context)
+{
+    if (json->as.boolean) {
+        json_write_raw(context, "true", strlen("true"));
+    } else {
+        json_write_raw(context, "false", strlen("false"));
+    }
+}
+
+static void json_write_func_for_int(json_value_t *json, json_write_context_t *context)
+{
+    context->cursor += json_format_int(context->cursor, json->as.integer);
+}
+
+static void json_write_func_for_floating(json_value_t *json, json_write_context_t *context)
+{
+    context->cursor += json_format_float(context->cursor, json->as.floating);
+}
+
+static void json_write_func_for_string(json_value_t *json, json_write_context_t *context)
+{
+    json_write_raw(context, "\"", strlen("\""));
+    json_write_string(context, json->as.string);
+    json_write_raw(context, "\"", strlen("\""));
+}
+
+static void json_write_func_for_base64(json_value_t *json, json_write_context_t *context)
+{
+    json_write_raw(context, "\"", strlen("\""));
+    json_write_base64(context, json->as.base64->data, json->as.base64->size);
+    json_write_raw(context, "\"", strlen("\""));
+}
+
+static void json_write_func_for_array(json_value_t *json, json_write_context_t *context)
+{
+    json_write_raw(context, "[", strlen("["));
+
+    for (size_t i = 0; i < json->as.array->size; i++) {
+        json_value_t *entry = json->as.array->entries[i];
+
+        if (i != 0) {
+            json_write_raw(context, ",", strlen(","));
+        }
+
+        json_write(entry, context);
+    }
+
+    json_write_raw(context, "]", strlen("]"));
+}
+
+static void json_write_func_for_object(json_value_t *json, json_write_context_t *context)
+{
+    json_write_raw(context, "{", strlen("{"));
+
+    for (size_t i = 0; i < json->as.object->size; i++) {
+        json_prop_t *property = json->as.object->props[i];
+
+        if (i != 0) {
+            json_write_raw(context, ",", strlen(","));
+        }
+
+        json_write_raw(context, "\"", strlen("\""));
+        json_write_string(context, property->key);
+        json_write_raw(context, "\":", strlen("\":"));
+        json_write(property->entry, context);
+    }
+
+    json_write_raw(context, "}", strlen("}"));
+}
+
+static void json_write_func_for_padded(json_value_t *json, json_write_context_t *context)
+{
+    size_t digits = json_padded_int_digits(json->as.padded->integer);
+    size_t width  = digits > json->as.padded->width ? digits : json->as.padded->width;
+
+    if (context->slots != NULL) {
+        context->slots[context->slots_count++] = (json_slot_t) {
+            .offset = (size_t) (context->cursor - context->buffer),
+            .width  = width,
+        };
+    }
+
+    char   integer[JSON_INT_MAX_LENGTH];
+    size_t padding = width - digits;
+
+    if (context->flush == NULL || padding <= (size_t) (context->end - context->cursor)) {
+        memset(context->cursor, ' ', padding);
+        context->cursor += padding;
+    } else {
+        while (padding-- != 0) {
+            json_write_raw(context, " ", strlen(" "));
+        }
+    }
+
+    json_write_raw(context, integer, json_format_int(integer, json->as.padded->integer));
+}
+
+static void json_size_frame(json_size_context_t *context, json_value_type_t type, size_t count)
+{
+    (void) type;
+    context->size += strlen("[]") + (count != 0 ? count - 1 : 0) * strlen(",");
+}
+
+static void json_size_key(json_size_context_t *context, const char *key)
+{
+    context->size += strlen("\"") + json_string_size(context, key) + strlen("\":");
+}
+
+static void json_write_begin(json_write_context_t *context, json_value_type_t type, size_t count)
+{
+    (void) count;
+    json_write_raw(context, type == JSON_VALUE_TYPE_OBJECT ? "{" : "[", strlen("["));
+}
+
+static void json_write_separator(json_write_context_t *context, json_value_type_t type, size_t count)
+{
+    (void) type;
+
+    if (count != 0) {
+        json_write_raw(context, ",", strlen(","));
+    }
+}
+
+static void json_write_key(json_write_context_t *context, const char *key)
+{
+    json_write_raw(context, "\"", strlen("\""));
+    json_write_string(context, key);
+    json_write_raw(context, "\":", strlen("\":"));
+}
+
+static void json_write_end(json_write_context_t *context, json_value_type_t type, size_t count)
+{
+    (void) count;
+    json_write_raw(context, type == JSON_VALUE_TYPE_OBJECT ? "}" : "]", strlen("]"));
+}
+
+static size_t json_msgpack_int_size(int64_t integer)
+{
+    if (integer >= 0) {
+        return integer <= 0x7f       ? 1
+             : integer <= UINT8_MAX  ? 2
+             : integer <= UINT16_MAX ? 3
+             : integer <= UINT32_MAX ? 5
+             : 9;
+    }
+
+    return integer >= -32       ? 1
+         : integer >= INT8_MIN  ? 2
+         : integer >= INT16_MIN ? 3
+         : integer >= INT32_MIN ? 5
+         : 9;
+}
+
+static size_t json_msgpack_string_header_size(size_t length)
+{
+    return length < 32          ? 1
+         : length <= UINT8_MAX  ? 2
+         : length <= UINT16_MAX ? 3
+         : 5;
+}
+
+static size_t json_msgpack_container_header_size(size_t size)
+{
+    return size < 16          ? 1
+         : size <= UINT16_MAX ? 3
+         : 5;
+}
+
+static void json_msgpack_write_tagged(json_write_context_t *context, uint8_t tag, uint64_t value, size_t bytes)
+{
+    *context->cursor++ = (char) tag;
+
+    for (size_t i = bytes; i > 0; i--) {
+        *context->cursor++ = (char) (uint8_t) (value >> ((i - 1) * 8));
+    }
+}
+
+static void json_msgpack_write_int(json_write_context_t *context, int64_t integer)
+{
+    switch (json_msgpack_int_size(integer)) {
+    case 1:
+        *context->cursor++ = (char) (uint8_t) integer;
+        break;
+    case 2:
+        json_msgpack_write_tagged(context, integer >= 0 ? 0xcc : 0xd0, (uint64_t) integer, 1);
+        break;
+    case 3:
+        json_msgpack_write_tagged(context, integer >= 0 ? 0xcd : 0xd1, (uint64_t) integer, 2);
+        break;
+    case 5:
+        json_msgpack_write_tagged(context, integer >= 0 ? 0xce : 0xd2, (uint64_t) integer, 4);
+        break;
+    default:
+        json_msgpack_write_tagged(context, integer >= 0 ? 0xcf : 0xd3, (uint64_t) integer, 8);
+        break;
+    }
+}
+
+static void json_msgpack_write_string_header(json_write_context_t *context, size_t length)
+{
+    switch (json_msgpack_string_header_size(length)) {
+    case 1:
+        json_msgpack_write_tagged(context, (uint8_t) (0xa0 | length), 0, 0);
+        break;
+    case 2:
+        json_msgpack_write_tagged(context, 0xd9, length, 1);
+        break;
+    case 3:
+        json_msgpack_write_tagged(context, 0xda, length, 2);
+        break;
+    default:
+        json_msgpack_write_tagged(context, 0xdb, length, 4);
+        break;
+    }
+}
+
+static void json_msgpack_write_string(json_write_context_t *context, const char *string)
+{
+    size_t length = strlen(string);
+
+    json_msgpack_write_string_header(context, length);
+    json_write_raw(context, string, length);
+}
+
+static void json_msgpack_write_container(json_write_context_t *context, const uint8_t tags[3], size_t size)
+{
+    switch (json_msgpack_container_header_size(size)) {
+    case 1:
+        json_msgpack_write_tagged(context, (uint8_t) (tags[0] | size), 0, 0);
+        break;
+    case 3:
+        json_msgpack_write_tagged(context, tags[1], size, 2);
+        break;
+    default:
+        json_msgpack_write_tagged(context, tags[2], size, 4);
+        break;
+    }
+}
+
+static void json_msgpack_size_compute_func_for_null(json_value_t *json, json_size_context_t *context)
+{
+    (void) json;
+    context->size += 1;
+}
+
+static void json_msgpack_size_compute_func_for_bool(json_value_t *json, json_size_context_t *context)
+{
+    (void) json;
+    context->size += 1;
+}
+
+static void json_msgpack_size_compute_func_for_int(json_value_t *json, json_size_context_t *context)
+{
+    context->size += json_msgpack_int_size(json->as.integer);
+}
+
+static void json_msgpack_size_compute_func_for_floating(json_value_t *json, json_size_context_t *context)
+{
+    (void) json;
+    context->size += 1 + sizeof(double);
+}
+
+static void json_msgpack_size_compute_func_for_string(json_value_t *json, json_size_context_t *context)
+{
+    size_t length = strlen(json->as.string);
+    context->size += json_msgpack_string_header_size(length) + length;
+}
+
+static void json_msgpack_size_compute_func_for_array(json_value_t *json, json_size_context_t *context)
+{
+    context->size += json_msgpack_container_header_size(json->as.array->size);
+
+    for (size_t i = 0; i < json->as.array->size; i++) {
+        json_size_compute(json->as.array->entries[i], context);
+    }
+}
+
+static void json_msgpack_size_compute_func_for_object(json_value_t *json, json_size_context_t *context)
+{
+    context->size += json_msgpack_container_header_size(json->as.object->size);
+
+    for (size_t i = 0; i < json->as.object->size; i++) {
+        json_prop_t *property = json->as.object->props[i];
+        size_t       length   = strlen(property->key);
+
+        context->size += json_msgpack_string_header_size(length) + length;
+        json_size_compute(property->entry, context);
+    }
+}
+
+static void json_msgpack_size_compute_func_for_padded(json_value_t *json, json_size_context_t *context)
+{
+    context->size += json_msgpack_int_size(json->as.padded->integer);
+}
+
+static void json_msgpack_size_compute_func_for_base64(json_value_t *json, json_size_context_t *context)
+{
+    size_t length = json_base64_length(json->as.base64->size);
+    context->size += json_msgpack_string_header_size(length) + length;
+}
+
+static void json_msgpack_write_func_for_null(json_value_t *json, json_write_context_t *context)
+{
+    (void) json;
+    json_msgpack_write_tagged(context, 0xc0, 0, 0);
+}
+
+static void json_msgpack_write_func_for_bool(json_value_t *json, json_write_context_t *context)
+{
+    json_msgpack_write_tagged(context, json->as.boolean ? 0xc3 : 0xc2, 0, 0);
+}
+
+static void json_msgpack_write_func_for_int(json_value_t *json, json_write_context_t *context)
+{
+    json_msgpack_write_int(context, json->as.integer);
+}
+
+static void json_msgpack_write_func_for_floating(json_value_t *json, json_write_context_t *context)
+{
+    uint64_t bits = 0;
+    memcpy(&bits, &json->as.floating, sizeof(bits));
+
+    json_msgpack_write_tagged(context, 0xcb, bits, sizeof(bits));
+}
+
+static void json_msgpack_write_func_for_string(json_value_t *json, json_write_context_t *context)
+{
+    json_msgpack_write_string(context, json->as.string);
+}
+
+static void json_msgpack_write_func_for_array(json_value_t *json, json_write_context_t *context)
+{
+    json_msgpack_write_container(context, (const uint8_t[]) { 0x90, 0xdc, 0xdd }, json->as.array->size);
+
+    for (size_t i = 0; i < json->as.array->size; i++) {
+        json_write(json->as.array->entries[i], context);
+    }
+}
+
+static void json_msgpack_write_func_for_object(json_value_t *json, json_write_context_t *context)
+{
+    json_msgpack_write_container(context, (const uint8_t[]) { 0x80, 0xde, 0xdf }, json->as.object->size);
+
+    for (size_t i = 0; i < json->as.object->size; i++) {
+        json_prop_t *property = json->as.object->props[i];
+
+        json_msgpack_write_string(context, property->key);
+        json_write(property->entry, context);
+    }
+}
+
+static void json_msgpack_write_func_for_padded(json_value_t *json, json_write_context_t *context)
+{
+    json_msgpack_write_int(context, json->as.padded->integer);
+}
+
+static void json_msgpack_write_func_for_base64(json_value_t *json, json_write_context_t *context)
+{
+    json_msgpack_write_string_header(context, json_base64_length(json->as.base64->size));
+    json_write_base64(context, json->as.base64->data, json->as.base64->size);
+}
+
+static void json_msgpack_size_frame(json_size_context_t *context, json_value_type_t type, size_t count)
+{
+    (void) type;
+    context->size += json_msgpack_container_header_size(count);
+}
+
+static void json_msgpack_size_key(json_size_context_t *context, const char *key)
+{
+    size_t length = strlen(key);
+    context->size += json_msgpack_string_header_size(length) + length;
+}
+
+static void json_msgpack_write_begin(json_write_context_t *context, json_value_type_t type, size_t count)
+{
+    if (type == JSON_VALUE_TYPE_OBJECT) {
+        json_msgpack_write_container(context, (const uint8_t[]) { 0x80, 0xde, 0xdf }, count);
+    } else {
+        json_msgpack_write_container(context, (const uint8_t[]) { 0x90, 0xdc, 0xdd }, count);
+    }
+}
+
+static void json_msgpack_write_separator(json_write_context_t *context, json_value_type_t type, size_t count)
+{
+    (void) context;
+    (void) type;
+    (void) count;
+}
+
+static void json_msgpack_write_key(json_write_context_t *context, const char *key)
+{
+    json_msgpack_write_string(context, key);
+}
+
+static void json_msgpack_write_end(json_write_context_t *context, json_value_type_t type, size_t count)
+{
+    (void) context;
+    (void) type;
+    (void) count;
+}
+
+static const char *json_skip_whitespace(const char *cursor, const char *end)
+{
+    while (cursor < end && (*cursor == ' ' || *cursor == '\n' || *cursor == '\r' || *cursor == '\t')) {
+        cursor++;
+    }
+
+    return cursor;
+}
+
+typedef struct json_parser_t
+{
+    char               *cursor;
+    char               *end;
+    json_pool_t        *pool;
+    size_t              depth;
+    json_parse_status_t status;
+} json_parser_t;
+
+static size_t json_align_size(size_t size)
+{
+    return (size + JSON_NODE_ALIGNMENT - 1) & ~(size_t) (JSON_NODE_ALIGNMENT - 1);
+}
+
+static void *json_pool_alloc(json_pool_t *pool, size_t size)
+{
+    size = json_align_size(size);
+
+    if (pool->top - pool->bottom < size) {
+        return NULL;
+    }
+
+    void *memory = pool->memory + pool->bottom;
+    pool->bottom += size;
+
+    return memory;
+}
+
+static bool json_pool_push(json_pool_t *pool, void *pointer)
+{
+    if (pool->top - pool->bottom < sizeof(void *)) {
+        return false;
+    }
+
+    pool->top -= sizeof(void *);
+    memcpy(pool->memory + pool->top, &pointer, sizeof(void *));
+
+    return true;
+}
+
+static void **json_pool_pop_into_array(json_pool_t *pool, size_t top, size_t count)
+{
+    if (count == 0) {
+        pool->top = top;
+        return NULL;
+    }
+
+    void **array = json_pool_alloc(pool, count * sizeof(void *));
+
+    if (array != NULL) {
+        for (size_t i = 0; i < count; i++) {
+            memcpy(&array[i], pool->memory + top - (i + 1) * sizeof(void *), sizeof(void *));
+        }
+    }
+
+    pool->top = top;
+    return array;
+}
+
+static void *json_parser_fail(json_parser_t *parser, json_parse_status_t status)
+{
+    if (parser->status == JSON_PARSE_OK) {
+        parser->status = status;
+    }
+
+    return NULL;
+}
+
+static void *json_parser_alloc(json_parser_t *parser, size_t size)
+{
+    void *memory = json_pool_alloc(parser->pool, size);
+    return memory ? memory : json_parser_fail(parser, JSON_PARSE_ERROR_POOL_EXHAUSTED);
+}
+
+static void json_parser_skip_whitespace(json_parser_t *parser)
+{
+    parser->cursor = (char *) json_skip_whitespace(parser->cursor, parser->end);
+}
+
+static bool json_parser_consume(json_parser_t *parser, char character)
+{
+    json_parser_skip_whitespace(parser);
+
+    if (parser->cursor < parser->end && *parser->cursor == character) {
+        parser->cursor++;
+        return true;
+    }
+
+    return false;
+}
+
+static bool json_parser_consume_literal(json_parser_t *parser, const char *literal)
+{
+    size_t length = strlen(literal);
+
+    if ((size_t) (parser->end - parser->cursor) < length || memcmp(parser->cursor, literal, length) != 0) {
+        return false;
+    }
+
+    parser->cursor += length;
+    return true;
+}
+
+static int json_parser_hex_digit(char character)
+{
+    if (character >= '0' && character <= '9') {
+        return character - '0';
+    }
+
+    if (character >= 'a' && character <= 'f') {
+        return character - 'a' + 10;
+    }
+
+    if (character >= 'A' && character <= 'F') {
+        return character - 'A' + 10;
+    }
+
+    return -1;
+}
+
+static bool json_parser_read_hex(json_parser_t *parser, uint32_t *code)
+{
+    if (parser->end - parser->cursor < 4) {
+        return false;
+    }
+
+    *code = 0;
+
+    for (int i = 0; i < 4; i++) {
+        int digit = json_parser_hex_digit(*parser->cursor++);
+
+        if (digit < 0) {
+            return false;
+        }
+
+        *code = (*code << 4) | (uint32_t) digit;
+    }
+
+    return true;
+}
+
+static char *json_parser_write_utf8(char *output, uint32_t code)
+{
+    if (code < 0x80) {
+        *output++ = (char) code;
+    } else if (code < 0x800) {
+        *output++ = (char) (0xc0 | (code >> 6));
+        *output++ = (char) (0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        *output++ = (char) (0xe0 | (code >> 12));
+        *output++ = (char) (0x80 | ((code >> 6) & 0x3f));
+        *output++ = (char) (0x80 | (code & 0x3f));
+    } else {
+        *output++ = (char) (0xf0 | (code >> 18));
+        *output++ = (char) (0x80 | ((code >> 12) & 0x3f));
+        *output++ = (char) (0x80 | ((code >> 6) & 0x3f));
+        *output++ = (char) (0x80 | (code & 0x3f));
+    }
+
+    return output;
+}
+
+static bool json_parser_unescape(json_parser_t *parser, char **output)
+{
+    uint32_t code = 0;
+
+    if (parser->cursor == parser->end) {
+        return false;
+    }
+
+    switch (*parser->cursor++) {
+    case '"':  *(*output)++ = '"';  return true;
+    case '\\': *(*output)++ = '\\'; return true;
+    case '/':  *(*output)++ = '/';  return true;
+    case 'b':  *(*output)++ = '\b'; return true;
+    case 'f':  *(*output)++ = '\f'; return true;
+    case 'n':  *(*output)++ = '\n'; return true;
+    case 'r':  *(*output)++ = '\r'; return true;
+    case 't':  *(*output)++ = '\t'; return true;
+    case 'u':  break;
+    default:   return false;
+    }
+
+    if (!json_parser_read_hex(parser, &code) || (code >= 0xdc00 && code <= 0xdfff)) {
+        return false;
+    }
+
+    /* Strings are zero terminated, so the zero character has no representation */
+    if (code == 0) {
+        json_parser_fail(parser, JSON_PARSE_ERROR_NUL_CHARACTER);
+        return false;
+    }
+
+    if (code >= 0xd800 && code <= 0xdbff) {
+        uint32_t low = 0;
+
+        if (!json_parser_consume_literal(parser, "\\u") || !json_parser_read_hex(parser, &low)) {
+            return false;
+        }
+
+        if (low < 0xdc00 || low > 0xdfff) {
+            return false;
+        }
+
+        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+    }
+
+    /* UTF-8 encoding is never longer than the escape sequence it replaces */
+    *output = json_parser_write_utf8(*output, code);
+    return true;
+}
+
+/*
+ Strings are unescaped in place: the unescaped string is never longer
+ than the escaped one, so it is written over the text and terminated
+ with zero at the latest where the closing quote was.
+*/
+
+static char *json_parse_string(json_parser_t *parser)
+{
+    if (!json_parser_consume(parser, '"')) {
+        return json_parser_fail(parser, JSON_PARSE_ERROR_SYNTAX);
+    }
+
+    char *string = parser->cursor;
+    char *output = parser->cursor;
+
+    for (;;) {
+        char *special = (char *) json_scan_string_special(parser->cursor, parser->end);
+        size_t length = (size_t) (special - parser->cursor);
+
+        if (output != parser->cursor) {
+            memmove(output, parser->cursor, length);
+        }
+
+        output        += length;
+        parser->cursor = special;
+
+        if (parser->cursor == parser->end) {
+            return json_parser_fail(parser, JSON_PARSE_ERROR_SYNTAX);
+        }
+
+        char character = *parser->cursor++;
+
+        if (character == '"') {
+            break;
+        }
+
+        if (character != '\\' || !json_parser_unescape(parser, &output)) {
+            return json_parser_fail(parser, JSON_PARSE_ERROR_SYNTAX);
+        }
+    }
+
+    *output = '\0';
+    return string;
+}
+
+static const char *json_scan_digits(const char *cursor, const char *end)
+{
+    const char *start = cursor;
+
+    while (cursor < end && *cursor >= '0' && *cursor <= '9') {
+        cursor++;
+    }
+
+    return cursor != start ? cursor : NULL;
+}
+
+/*
+ Finds the end of a json number: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+ Returns NULL if the text doesn't start with a valid number.
+*/
+
+static const char *json_scan_number(const char *cursor, const char *end, bool *integral)
+{
+    *integral = true;
+
+    if (cursor < end && *cursor == '-') {
+        cursor++;
+    }
+
+    if (cursor < end && *cursor == '0') {
+        cursor++;
+    } else if ((cursor = json_scan_digits(cursor, end)) == NULL) {
+        return NULL;
+    }
+
+    if (cursor < end && *cursor == '.') {
+        *integral = false;
+
+        if ((cursor = json_scan_digits(cursor + 1, end)) == NULL) {
+            return NULL;
+        }
+    }
+
+    if (cursor < end && (*cursor == 'e' || *cursor == 'E')) {
+        *integral = false;
+        cursor++;
+
+        if (cursor < end && (*cursor == '+' || *cursor == '-')) {
+            cursor++;
+        }
+
+        if ((cursor = json_scan_digits(cursor, end)) == NULL) {
+            return NULL;
+        }
+    }
+
+    return cursor;
+}
+
+static bool json_parse_integer(const char *start, const char *end, int64_t *integer)
+{
+    bool     negative = *start == '-';
+    uint64_t limit    = negative ? (uint64_t) INT64_MAX + 1 : (uint64_t) INT64_MAX;
+    uint64_t value    = 0;
+
+    for (const char *cursor = start + negative; cursor < end; cursor++) {
+        uint64_t digit = (uint64_t) (*cursor - '0');
+
+        if (value > (limit - digit) / 10) {
+            return false;
+        }
+
+        value = value * 10 + digit;
+    }
+
+    *integer = negative ? (int64_t) (0 - value) : (int64_t) value;
+    return true;
+}
+
+/*
+ Numbers are parsed without strtod, which reads the decimal point of
+ LC_NUMERIC. The value is its significant digits times 10^exponent. Up to
+ 15 digits with a small exponent are exact doubles, so one floating
+ operation rounds them correctly, others are divided as big integers.
+ A rounding boundary of a double has at most 767 significant digits, so
+ the digits after the 768th only tell whether the value lies above it.
+*/
+
+typedef struct json_decimal_t
+{
+    const char *digits;
+    const char *end;
+    size_t      count;
+    int64_t     exponent;
+    bool        negative;
+} json_decimal_t;
+
+static const double json_exact_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static void json_decimal_scan(json_decimal_t *decimal, const char *text, const char *end)
+{
+    int64_t fraction = 0;
+    int64_t exponent = 0;
+    bool    point    = false;
+    bool    negative = false;
+
+    decimal->negative = text != end && *text == '-';
+    decimal->digits   = NULL;
+    decimal->count    = 0;
+    text             += decimal->negative;
+
+    for (; text != end && (*text == '.' || (*text >= '0' && *text <= '9')); text++) {
+        if (*text == '.') {
+            point = true;
+            continue;
+        }
+
+        fraction += point;
+
+        if (decimal->digits == NULL && *text == '0') {
+            continue;
+        }
+
+        decimal->digits = decimal->digits ? decimal->digits : text;
+        decimal->count++;
+    }
+
+    decimal->end = text;
+
+    if (text != end && (*text == 'e' || *text == 'E')) {
+        text++;
+        negative = text != end && *text == '-';
+        text    += text != end && (*text == '-' || *text == '+');
+
+        /* Exponents this large are zero or infinity anyway, clamping keeps the arithmetic in range */
+        for (; text != end && *text >= '0' && *text <= '9'; text++) {
+            exponent = exponent < 100000 ? exponent * 10 + (*text - '0') : exponent;
+        }
+    }
+
+    decimal->exponent = (negative ? -exponent : exponent) - fraction;
+}
+
+static double json_double_from_bits(bool negative, uint64_t bits)
+{
+    double floating = 0;
+
+    bits |= (uint64_t) negative << 63;
+    memcpy(&floating, &bits, sizeof(floating));
+
+    return floating;
+}
+
+static void json_big_uint_multiply_power_of_ten(json_big_uint_t *number, int64_t exponent)
+{
+    for (; exponent >= 9; exponent -= 9) {
+        json_big_uint_multiply(number, 1000000000);
+    }
+
+    for (; exponent > 0; exponent--) {
+        json_big_uint_multiply(number, 10);
+    }
+}
+
+/*
+ The digits are scaled by 2^shift so that dividing them by 10^-exponent,
+ one 10^9 at a time, leaves more than 54 bits of quotient. Dividing step
+ by step floors exactly like one division, the remainders and the dropped
+ digits only tell whether something is left below the quotient.
+*/
+
+static double json_decimal_convert(const json_decimal_t *decimal)
+{
+    json_big_uint_t number  = { .length = 0 };
+    size_t          kept    = 0;
+    bool            sticky  = false;
+    uint32_t        chunk   = 0;
+    size_t          pending = 0;
+
+    for (const char *digit = decimal->digits; digit != decimal->end; digit++) {
+        if (*digit == '.') {
+            continue;
+        }
+
+        if (kept == JSON_DECIMAL_MAX_DIGITS) {
+            sticky |= *digit != '0';
+            continue;
+        }
+
+        chunk = chunk * 10 + (uint32_t) (*digit - '0');
+        kept++;
+
+        if (++pending == 9) {
+            json_big_uint_multiply(&number, 1000000000);
+            json_big_uint_add(&number, chunk);
+            chunk   = 0;
+            pending = 0;
+        }
+    }
+
+    json_big_uint_multiply_power_of_ten(&number, (int64_t) pending);
+    json_big_uint_add(&number, chunk);
+
+    int64_t exponent = decimal->exponent + (int64_t) (decimal->count - kept);
+    int64_t binary   = 0;
+
+    if (exponent >= 0) {
+        json_big_uint_multiply_power_of_ten(&number, exponent);
+    } else {
+        /* 10^k has floor(k * log2(10)) + 1 bits, the estimate is off by one at most */
+        int64_t divisor_bits = (-exponent * 217706 >> 16) + 1;
+        int64_t shift        = 58 - (int64_t) json_big_uint_bits(&number) + divisor_bits;
+
+        if (shift > 0) {
+            json_big_uint_shift_left(&number, (size_t) shift);
+            binary = -shift;
+        }
+
+        for (; exponent <= -9; exponent += 9) {
+            sticky |= json_big_uint_divide(&number, 1000000000) != 0;
+        }
+
+        if (exponent < 0) {
+            sticky |= json_big_uint_divide(&number, (uint32_t) json_exact_powers_of_ten[-exponent]) != 0;
+        }
+    }
+
+    size_t bits = json_big_uint_bits(&number);
+
+    if (bits > 64) {
+        sticky |= json_big_uint_any_below(&number, bits - 64);
+        json_big_uint_shift_right(&number, bits - 64);
+        binary += (int64_t) (bits - 64);
+        bits    = 64;
+    }
+
+    uint64_t quotient = number.words[0] | (number.length > 1 ? (uint64_t) number.words[1] << 32 : 0);
+
+    /* The value is quotient * 2^binary, normalized to 64 bits of which 53 are kept */
+    quotient <<= 64 - bits;
+    binary    -= (int64_t) (64 - bits);
+
+    int64_t dropped = binary + 11 < -1074 ? -1074 - binary : 11;
+
+    uint64_t mantissa = dropped < 64 ? quotient >> dropped : 0;
+    bool     half     = dropped <= 64 && (quotient >> (dropped - 1)) & 1;
+
+    sticky |= dropped > 64 ? quotient != 0 : dropped > 1 && (quotient & (UINT64_MAX >> (65 - dropped))) != 0;
+
+    if (half && (sticky || (mantissa & 1))) {
+        mantissa++;
+    }
+
+    int64_t lowest = binary + dropped;
+
+    if (mantissa >> 53) {
+        mantissa >>= 1;
+        lowest++;
+    }
+
+    if (mantissa >> 52 == 0) {
+        return json_double_from_bits(decimal->negative, mantissa);
+    }
+
+    if (lowest + 1075 >= 0x7ff) {
+        return json_double_from_bits(decimal->negative, (uint64_t) 0x7ff << 52);
+    }
+
+    return json_double_from_bits(decimal->negative, (uint64_t) (lowest + 1075) << 52 | (mantissa & (((uint64_t) 1 << 52) - 1)));
+}
+
+static double json_parse_double(const char *text, const char *end)
+{
+    json_decimal_t decimal;
+
+    json_decimal_scan(&decimal, text, end);
+
+    /* The value is below 10^magnitude and at least 10^(magnitude - 1) */
+    int64_t magnitude = decimal.exponent + (int64_t) decimal.count;
+
+    if (decimal.count == 0 || magnitude <= -324) {
+        return json_double_from_bits(decimal.negative, 0);
+    }
+
+    if (magnitude >= 310) {
+        return json_double_from_bits(decimal.negative, (uint64_t) 0x7ff << 52);
+    }
+
+#if FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 1
+    if (decimal.count <= 15 && decimal.exponent >= -22 && decimal.exponent <= 22) {
+        uint64_t significand = 0;
+
+        for (const char *digit = decimal.digits; digit != decimal.end; digit++) {
+            significand = *digit != '.' ? significand * 10 + (uint64_t) (*digit - '0') : significand;
+        }
+
+        double floating = (double) significand;
+
+        floating = decimal.exponent >= 0 ? floating * json_exact_powers_of_ten[decimal.exponent]
+                                         : floating / json_exact_powers_of_ten[-decimal.exponent];
+
+        return decimal.negative ? -floating : floating;
+    }
+#endif
+
+    return json_decimal_convert(&decimal);
+}
+
+static json_value_t *json_parse_number(json_parser_t *parser)
+{
+    char *start    = parser->cursor;
+    bool  integral = true;
+    char *end      = (char *) json_scan_number(start, parser->end, &integral);
+
+    if (end == NULL) {
+        return json_parser_fail(parser, JSON_PARSE_ERROR_SYNTAX);
+    }
+
+    parser->cursor = end;
+
+    json_value_t *json = json_parser_alloc(parser, sizeof(json_value_t));
+
+    if (json == NULL) {
+        return NULL;
+    }
+
+    if (integral && json_parse_integer(start, parser->cursor, &json->as.integer)) {
+        json->type = JSON_VALUE_TYPE_INT;
+        return json;
+    }
+
+    json->type        = JSON_VALUE_TYPE_FLOAT;
+    json->as.floating = json_parse_double(start, parser->cursor);
+
+    return json;
+}
+
+static json_value_t *json_parse_value(json_parser_t *parser);
+
+static json_value_t *json_parse_string_value(json_parser_t *parser)
+{
+    json_value_t *json = json_parser_alloc(parser, sizeof(json_value_t));
+
+    if (json == NULL) {
+        return NULL;
+    }
+
+    json->type      = JSON_VALUE_TYPE_STRING;
+    json->as.string = json_parse_string(parser);
+
+    return json->as.string ? json : NULL;
+}
+
+static json_value_t *json_parse_array(json_parser_t *parser)
+{
+    json_value_t *json  = json_parser_alloc(parser, sizeof(json_value_t));
+    json_array_t *array = json_parser_alloc(parser, sizeof(json_array_t));
+    size_t        top   = parser->pool->top;
+    size_t        size  = 0;
+
+    if (json == NULL || array == NULL) {
+        return NULL;
+    }
+
+    parser->cursor++;
+
+    if (!json_parser_consume(parser, ']')) {
+        do {
+            json_value_t *entry = json_parse_value(parser);
+
+            if (entry == NULL) {
+                return NULL;
+            }
+
+            if (!json_pool_push(parser->pool, entry)) {
+                return json_parser_fail(parser, JSON_PARSE_ERROR_POOL_EXHAUSTED);
+            }
+
+            size++;
+        } while (json_parser_consume(parser, ','));
+
+        if (!json_parser_consume(parser, ']')) {
+            return json_parser_fail(parser, JSON_PARSE_ERROR_SYNTAX);
+        }
+    }
+
+    array->size    = size;
+    array->entries = (json_value_t **) json_pool_pop_into_array(parser->pool, top, size);
+
+    if (size != 0 && array->entries == NULL) {
+        return json_parser_fail(parser, JSON_PARSE_ERROR_POOL_EXHAUSTED);
+    }
+
+    json->type     = JSON_VALUE_TYPE_ARRAY;
+    json->as.array = array;
+
+    return json;
+}
+
+static json_value_t *json_parse_object(json_parser_t *parser)
+{
+    json_value_t  *json   = json_parser_alloc(parser, sizeof(json_value_t));
+    json_object_t *object = json_parser_alloc(parser, sizeof(json_object_t));
+    size_t         top    = parser->pool->top;
+    size_t         size   = 0;
+
+    if (json == NULL || object == NULL) {
+        return NULL;
+    }
+
+    parser->cursor++;
+
+    if (!json_parser_consume(parser, '}')) {
+        do {
+            json_prop_t *property = json_parser_alloc(parser, sizeof(json_prop_t));
+
+            if (property == NULL || (property->key = json_parse_string(parser)) == NULL) {
+                return NULL;
+            }
+
+            if (!json_parser_consume(parser, ':')) {
+                return json_parser_fail(parser, JSON_PARSE_ERROR_SYNTAX);
+            }
+
+            if ((property->entry = json_parse_value(parser)) == NULL) {
+                return NULL;
+            }
+
+            if (!json_pool_push(parser->pool, property)) {
+                return json_parser_fail(parser, JSON_PARSE_ERROR_POOL_EXHAUSTED);
+            }
+
+            size++;
+        } while (json_parser_consume(parser, ','));
+
+        if (!json_parser_consume(parser, '}')) {
+            return json_parser_fail(parser, JSON_PARSE_ERROR_SYNTAX);
+        }
+    }
+
+    object->size  = size;
+    object->props = (json_prop_t **) json_pool_pop_into_array(parser->pool, top, size);
+    object->index = NULL;
+
+    if (size != 0 && object->props == NULL) {
+        return json_parser_fail(parser, JSON_PARSE_ERROR_POOL_EXHAUSTED);
+    }
+
+    json->type      = JSON_VALUE_TYPE_OBJECT;
+    json->as.object = object;
+
+    return json;
+}
+
+static json_value_t *json_parse_literal(json_parser_t *parser)
+{
+    json_value_t *json = json_parser_alloc(parser, sizeof(json_value_t));
+
+    if (json == NULL) {
+        return NULL;
+    }
+
+    if (json_parser_consume_literal(parser, "null")) {
+        json->type = JSON_VALUE_TYPE_NULL;
+    } else if (json_parser_consume_literal(parser, "true")) {
+        json->type       = JSON_VALUE_TYPE_BOOL;
+        json->as.boolean = true;
+    } else if (json_parser_consume_literal(parser, "false")) {
+        json->type       = JSON_VALUE_TYPE_BOOL;
+        json->as.boolean = false;
+    } else {
+        return json_parser_fail(parser, JSON_PARSE_ERROR_SYNTAX);
+    }
+
+    return json;
+}
+
+static json_value_t *json_parse_value(json_parser_t *parser)
+{
+    json_value_t *json = NULL;
+
+    json_parser_skip_whitespace(parser);
+
+    if (parser->cursor == parser->end) {
+        return json_parser_fail(parser, JSON_PARSE_ERROR_SYNTAX);
+    }
+
+    if (++parser->depth > JSON_PARSE_MAX_DEPTH) {
+        return json_parser_fail(parser, JSON_PARSE_ERROR_DEPTH);
+    }
+
+    switch (*parser->cursor) {
+    case '{':
+        json = json_parse_object(parser);
+        break;
+    case '[':
+        json = json_parse_array(parser);
+        break;
+    case '"':
+        json = json_parse_string_value(parser);
+        break;
+    case '-':
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+        json = json_parse_number(parser);
+        break;
+    default:
+        json = json_parse_literal(parser);
+        break;
+    }
+
+    parser->depth--;
+    return json;
+}
+
+/*
+ Finds the first quote or bracket. Opening and closing brackets differ
+ from each other only in case bit, so `c | 0x20` folds them into two values.
+*/
+
+static const char *json_scan_structural(const char *cursor, const char *end)
+{
+#if defined(JSON_HAVE_SSE2)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i case_ = _mm_set1_epi8(0x20);
+    const __m128i open  = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+
+    while (end - cursor >= 16) {
+        __m128i chunk  = _mm_loadu_si128((const __m128i *) cursor);
+        __m128i folded = _mm_or_si128(chunk, case_);
+        __m128i found  = _mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close));
+
+        found = _mm_or_si128(found, _mm_cmpeq_epi8(chunk, quote));
+
+        unsigned mask = (unsigned) _mm_movemask_epi8(found);
+
+        if (mask != 0) {
+            return cursor + json_count_trailing_zeros(mask);
+        }
+
+        cursor += 16;
+    }
+#endif
+
+    while (cursor < end && *cursor != '"' && (*cursor | 0x20) != '{' && (*cursor | 0x20) != '}') {
+        cursor++;
+    }
+
+    return cursor;
+}
+
+static const char *json_skip_string(const char *cursor, const char *end)
+{
+    for (;;) {
+        cursor = json_scan_string_special(cursor, end);
+
+        if (cursor == end) {
+            return NULL;
+        }
+
+        if (*cursor == '"') {
+            return cursor + 1;
+        }
+
+        /* Backslash as the last byte of truncated text has nothing to escape */
+        if (*cursor == '\\' && end - cursor < 2) {
+            return NULL;
+        }
+
+        cursor += *cursor == '\\' ? 2 : 1;
+    }
+}
+
+static const char *json_skip_container(const char *cursor, const char *end)
+{
+    size_t depth = 0;
+
+    for (;;) {
+        cursor = json_scan_structural(cursor, end);
+
+        if (cursor == end) {
+            return NULL;
+        }
+
+        char character = *cursor++;
+
+        if (character == '"') {
+            if ((cursor = json_skip_string(cursor, end)) == NULL) {
+                return NULL;
+            }
+        } else if (character == '{' || character == '[') {
+            depth++;
+        } else if (--depth == 0) {
+            return cursor;
+        }
+    }
+}
+
+static const char *json_skip_value(const char *cursor, const char *end)
+{
+    if (cursor == end) {
+        return NULL;
+    }
+
+    switch (*cursor) {
+    case '"':
+        return json_skip_string(cursor + 1, end);
+    case '{':
+    case '[':
+        return json_skip_container(cursor, end);
+    default:
+        while (cursor < end && *cursor != ',' && *cursor != '}' && *cursor != ']' &&
+               *cursor != ' ' && *cursor != '\n' && *cursor != '\r' && *cursor != '\t') {
+            cursor++;
+        }
+        return cursor;
+    }
+}
+
+static const char *json_skip_separator(const char *cursor, const char *end, char separator)
+{
+    cursor = json_skip_whitespace(cursor, end);
+    return cursor < end && *cursor == separator ? json_skip_whitespace(cursor + 1, end) : NULL;
+}
+
+/*
+ Compact values are decoded into temporary nodes: scalars go through the
+ regular functions of the emitter, containers stay compact and are framed
+ by the emitter like any other container.
+*/
+
+static bool json_compact_is_boxed(json_compact_t value)
+{
+    return (value & JSON_COMPACT_BOX) == JSON_COMPACT_BOX;
+}
+
+static json_compact_tag_t json_compact_tag(json_compact_t value)
+{
+    return (json_compact_tag_t) (value >> JSON_COMPACT_TAG_SHIFT & 0x7);
+}
+
+static const void *json_compact_pointer(json_compact_t value)
+{
+    return (const void *) (uintptr_t) (value & JSON_COMPACT_PAYLOAD_MASK);
+}
+
+static bool json_compact_is_container(json_compact_t value)
+{
+    return json_compact_is_boxed(value) &&
+           (json_compact_tag(value) == JSON_COMPACT_TAG_ARRAY || json_compact_tag(value) == JSON_COMPACT_TAG_OBJECT);
+}
+
+static void json_compact_load(json_compact_t value, json_value_t *json)
+{
+    uint64_t payload = value & JSON_COMPACT_PAYLOAD_MASK;
+
+    if (!json_compact_is_boxed(value)) {
+        json->type = JSON_VALUE_TYPE_FLOAT;
+        memcpy(&json->as.floating, &value, sizeof(value));
+        return;
+    }
+
+    switch (json_compact_tag(value)) {
+    case JSON_COMPACT_TAG_NULL:
+        json->type = JSON_VALUE_TYPE_NULL;
+        break;
+    case JSON_COMPACT_TAG_BOOL:
+        json->type       = JSON_VALUE_TYPE_BOOL;
+        json->as.boolean = payload != 0;
+        break;
+    case JSON_COMPACT_TAG_INT:
+        /* Sign of the 48-bit payload is extended without shifting negative values */
+        json->type       = JSON_VALUE_TYPE_INT;
+        json->as.integer = (int64_t) (payload & (JSON_COMPACT_PAYLOAD_MASK >> 1)) - (int64_t) (payload & (UINT64_C(1) << 47));
+        break;
+    case JSON_COMPACT_TAG_BIG_INT:
+        json->type       = JSON_VALUE_TYPE_INT;
+        json->as.integer = *(const int64_t *) json_compact_pointer(value);
+        break;
+    case JSON_COMPACT_TAG_STRING:
+        json->type      = JSON_VALUE_TYPE_STRING;
+        json->as.string = json_compact_pointer(value);
+        break;
+    default:
+        json->type       = JSON_VALUE_TYPE_COMPACT;
+        json->as.compact = value;
+        break;
+    }
+}
+
+static json_value_type_t json_compact_container_type(json_compact_t value)
+{
+    return json_compact_tag(value) == JSON_COMPACT_TAG_OBJECT ? JSON_VALUE_TYPE_OBJECT : JSON_VALUE_TYPE_ARRAY;
+}
+
+static size_t json_compact_count(json_compact_t value)
+{
+    const json_compact_t *words = json_compact_pointer(value);
+    return (size_t) words[0];
+}
+
+/* Returns the entry of a compact container and its key for objects */
+static json_compact_t json_compact_entry(json_compact_t value, size_t index, const char **key)
+{
+    const json_compact_t *words = json_compact_pointer(value);
+
+    if (json_compact_tag(value) == JSON_COMPACT_TAG_OBJECT) {
+        *key = json_compact_pointer(words[1 + index * 2]);
+        return words[2 + index * 2];
+    }
+
+    return words[1 + index];
+}
+
+/*
+ Clone keeps every node and string of the tree in one block. Pieces are
+ laid out in the walk order and aligned like nodes, so the clone size
+ doesn't depend on the block address. Snapshot views and generators
+ reference memory and callbacks the clone can't own, so trees with them
+ are not cloned.
+*/
+
+static size_t json_clone_size_compute(json_value_t *json);
+
+static bool json_clone_supported(json_value_t *json)
+{
+    switch (json->type) {
+    case JSON_VALUE_TYPE_SNAPSHOT:
+    case JSON_VALUE_TYPE_ARRAY_GENERATOR:
+    case JSON_VALUE_TYPE_OBJECT_GENERATOR:
+        return false;
+    case JSON_VALUE_TYPE_ARRAY:
+        for (size_t i = 0; i < json->as.array->size; i++) {
+            if (!json_clone_supported(json->as.array->entries[i])) {
+                return false;
+            }
+        }
+        return true;
+    case JSON_VALUE_TYPE_OBJECT:
+        for (size_t i = 0; i < json->as.object->size; i++) {
+            if (!json_clone_supported(json->as.object->props[i]->entry)) {
+                return false;
+            }
+        }
+        return true;
+    case JSON_VALUE_TYPE_OVERLAY:
+        return json_clone_supported(json->as.overlay->base) && json_clone_supported(json->as.overlay->patch);
+    case JSON_VALUE_TYPE_PROJECTION:
+        return json_clone_supported(json->as.projection->json);
+    case JSON_VALUE_TYPE_TABLE:
+        for (size_t i = 0; i < json->as.table->columns * json->as.table->rows; i++) {
+            if (!json_clone_supported(&json->as.table->values[i])) {
+                return false;
+            }
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+static size_t json_clone_mask_size(const json_mask_t *mask)
+{
+    size_t size = 0;
+
+    for (; mask != NULL; mask = mask->next) {
+        size += json_align_size(sizeof(json_mask_t));
+        size += mask->key ? json_align_size(mask->length + 1) : 0;
+        size += json_clone_mask_size(mask->children);
+    }
+
+    return size;
+}
+
+static size_t json_clone_compact_size(json_compact_t value)
+{
+    size_t size = 0;
+
+    if (!json_compact_is_boxed(value)) {
+        return 0;
+    }
+
+    switch (json_compact_tag(value)) {
+    case JSON_COMPACT_TAG_BIG_INT:
+        size += json_align_size(sizeof(int64_t));
+        break;
+    case JSON_COMPACT_TAG_STRING:
+        size += json_align_size(strlen(json_compact_pointer(value)) + 1);
+        break;
+    case JSON_COMPACT_TAG_ARRAY:
+    case JSON_COMPACT_TAG_OBJECT: {
+        const json_compact_t *words = json_compact_pointer(value);
+        size_t                count = json_compact_count(value) * (json_compact_tag(value) == JSON_COMPACT_TAG_OBJECT ? 2 : 1);
+
+        size += json_align_size((count + 1) * sizeof(json_compact_t));
+
+        /* Keys are compact strings, so they are cloned like the values */
+        for (size_t i = 1; i <= count; i++) {
+            size += json_clone_compact_size(words[i]);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    return size;
+}
+
+static size_t json_clone_payload_size(json_value_t *json)
+{
+    size_t size = 0;
+
+    switch (json->type) {
+    case JSON_VALUE_TYPE_STRING:
+        size += json_align_size(strlen(json->as.string) + 1);
+        break;
+    case JSON_VALUE_TYPE_ARRAY:
+        size += json_align_size(sizeof(json_array_t));
+        size += json_align_size(json->as.array->size * sizeof(json_value_t *));
+
+        for (size_t i = 0; i < json->as.array->size; i++) {
+            size += json_clone_size_compute(json->as.array->entries[i]);
+        }
+        break;
+    case JSON_VALUE_TYPE_OBJECT:
+        size += json_align_size(sizeof(json_object_t));
+        size += json_align_size(json->as.object->size * sizeof(json_prop_t *));
+
+        for (size_t i = 0; i < json->as.object->size; i++) {
+            json_prop_t *property = json->as.object->props[i];
+
+            size += json_align_size(sizeof(json_prop_t));
+            size += json_align_size(strlen(property->key) + 1);
+            size += json_clone_size_compute(property->entry);
+        }
+        break;
+    case JSON_VALUE_TYPE_PADDED:
+        size += json_align_size(sizeof(json_padded_int_t));
+        break;
+    case JSON_VALUE_TYPE_COMPACT:
+        size += json_clone_compact_size(json->as.compact);
+        break;
+    case JSON_VALUE_TYPE_BASE64:
+        size += json_align_size(sizeof(json_base64_t));
+        size += json_align_size(json->as.base64->size);
+        break;
+    case JSON_VALUE_TYPE_OVERLAY:
+        size += json_align_size(sizeof(json_overlay_t));
+        size += json_clone_size_compute(json->as.overlay->base);
+        size += json_clone_size_compute(json->as.overlay->patch);
+        break;
+    case JSON_VALUE_TYPE_PROJECTION:
+        size += json_align_size(sizeof(json_projection_t));
+        size += json_clone_size_compute(json->as.projection->json);
+        size += json_clone_mask_size(json->as.projection->mask);
+        break;
+    case JSON_VALUE_TYPE_TABLE: {
+        json_table_t *table = json->as.table;
+
+        size += json_align_size(sizeof(json_table_t));
+        size += json_align_size(table->columns * sizeof(const char *));
+        size += json_align_size(table->columns * table->rows * sizeof(json_value_t));
+
+        for (size_t i = 0; i < table->columns; i++) {
+            size += json_align_size(strlen(table->keys[i]) + 1);
+        }
+
+        for (size_t i = 0; i < table->columns * table->rows; i++) {
+            size += json_clone_payload_size(&table->values[i]);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    return size;
+}
+
+static size_t json_clone_size_compute(json_value_t *json)
+{
+    return json_align_size(sizeof(json_value_t)) + json_clone_payload_size(json);
+}
+
+static void *json_clone_alloc(char **cursor, const void *source, size_t size)
+{
+    void *memory = *cursor;
+
+    memcpy(memory, source, size);
+    *cursor += json_align_size(size);
+
+    return memory;
+}
+
+static json_value_t *json_clone_node(json_value_t *json, char **cursor);
+
+/* Mask keys point into the fields text, so the clone gets its own terminated copies */
+static json_mask_t *json_clone_mask(const json_mask_t *mask, char **cursor)
+{
+    json_mask_t  *first = NULL;
+    json_mask_t **link  = &first;
+
+    for (; mask != NULL; mask = mask->next) {
+        json_mask_t *node = json_clone_alloc(cursor, mask, sizeof(json_mask_t));
+
+        if (mask->key != NULL) {
+            char *key = *cursor;
+
+            memcpy(key, mask->key, mask->length);
+            key[mask->length] = '\0';
+
+            *cursor  += json_align_size(mask->length + 1);
+            node->key = key;
+        }
+
+        node->children = json_clone_mask(mask->children, cursor);
+        node->next     = NULL;
+
+        *link = node;
+        link  = &node->next;
+    }
+
+    return first;
+}
+
+static json_compact_t json_clone_compact(json_compact_t value, char **cursor)
+{
+    const void *payload = json_compact_pointer(value);
+
+    if (!json_compact_is_boxed(value)) {
+        return value;
+    }
+
+    switch (json_compact_tag(value)) {
+    case JSON_COMPACT_TAG_BIG_INT:
+        return json_compact_box(JSON_COMPACT_TAG_BIG_INT, (uintptr_t) json_clone_alloc(cursor, payload, sizeof(int64_t)));
+    case JSON_COMPACT_TAG_STRING:
+        return json_compact_box(JSON_COMPACT_TAG_STRING, (uintptr_t) json_clone_alloc(cursor, payload, strlen(payload) + 1));
+    case JSON_COMPACT_TAG_ARRAY:
+    case JSON_COMPACT_TAG_OBJECT: {
+        size_t          count = json_compact_count(value) * (json_compact_tag(value) == JSON_COMPACT_TAG_OBJECT ? 2 : 1);
+        json_compact_t *words = json_clone_alloc(cursor, payload, (count + 1) * sizeof(json_compact_t));
+
+        for (size_t i = 1; i <= count; i++) {
+            words[i] = json_clone_compact(words[i], cursor);
+        }
+
+        return json_compact_box(json_compact_tag(value), (uintptr_t) words);
+    }
+    default:
+        return value;
+    }
+}
+
+/* Clone is a copy of the json node whose pointers are replaced with the cloned payload */
+
+static void json_clone_payload(json_value_t *json, json_value_t *clone, char **cursor)
+{
+    switch (json->type) {
+    case JSON_VALUE_TYPE_STRING:
+        clone->as.string = json_clone_alloc(cursor, json->as.string, strlen(json->as.string) + 1);
+        break;
+    case JSON_VALUE_TYPE_ARRAY:
+        clone->as.array = json_clone_alloc(cursor, json->as.array, sizeof(json_array_t));
+        clone->as.array->entries = json->as.array->size
+            ? json_clone_alloc(cursor, json->as.array->entries, json->as.array->size * sizeof(json_value_t *))
+            : NULL;
+
+        for (size_t i = 0; i < json->as.array->size; i++) {
+            clone->as.array->entries[i] = json_clone_node(json->as.array->entries[i], cursor);
+        }
+        break;
+    case JSON_VALUE_TYPE_OBJECT:
+        clone->as.object = json_clone_alloc(cursor, json->as.object, sizeof(json_object_t));
+        clone->as.object->index = NULL;
+        clone->as.object->props = json->as.object->size
+            ? json_clone_alloc(cursor, json->as.object->props, json->as.object->size * sizeof(json_prop_t *))
+            : NULL;
+
+        for (size_t i = 0; i < json->as.object->size; i++) {
+            json_prop_t *property = json_clone_alloc(cursor, json->as.object->props[i], sizeof(json_prop_t));
+
+            property->key   = json_clone_alloc(cursor, property->key, strlen(property->key) + 1);
+            property->entry = json_clone_node(property->entry, cursor);
+
+            clone->as.object->props[i] = property;
+        }
+        break;
+    case JSON_VALUE_TYPE_PADDED:
+        clone->as.padded = json_clone_alloc(cursor, json->as.padded, sizeof(json_padded_int_t));
+        break;
+    case JSON_VALUE_TYPE_COMPACT:
+        clone->as.compact = json_clone_compact(json->as.compact, cursor);
+        break;
+    case JSON_VALUE_TYPE_BASE64:
+        clone->as.base64       = json_clone_alloc(cursor, json->as.base64, sizeof(json_base64_t));
+        clone->as.base64->data = json_clone_alloc(cursor, json->as.base64->data, json->as.base64->size);
+        break;
+    case JSON_VALUE_TYPE_OVERLAY:
+        clone->as.overlay        = json_clone_alloc(cursor, json->as.overlay, sizeof(json_overlay_t));
+        clone->as.overlay->base  = json_clone_node(json->as.overlay->base, cursor);
+        clone->as.overlay->patch = json_clone_node(json->as.overlay->patch, cursor);
+        break;
+    case JSON_VALUE_TYPE_PROJECTION:
+        clone->as.projection       = json_clone_alloc(cursor, json->as.projection, sizeof(json_projection_t));
+        clone->as.projection->json = json_clone_node(json->as.projection->json, cursor);
+        clone->as.projection->mask = json_clone_mask(json->as.projection->mask, cursor);
+        break;
+    case JSON_VALUE_TYPE_TABLE: {
+        json_table_t *table = json->as.table;
+        size_t        cells = table->columns * table->rows;
+        const char  **keys  = NULL;
+
+        clone->as.table = json_clone_alloc(cursor, table, sizeof(json_table_t));
+        keys            = table->columns ? json_clone_alloc(cursor, table->keys, table->columns * sizeof(const char *)) : NULL;
+
+        clone->as.table->values = cells ? json_clone_alloc(cursor, table->values, cells * sizeof(json_value_t)) : NULL;
+
+        for (size_t i = 0; i < table->columns; i++) {
+            keys[i] = json_clone_alloc(cursor, table->keys[i], strlen(table->keys[i]) + 1);
+        }
+
+        for (size_t i = 0; i < cells; i++) {
+            json_clone_payload(&table->values[i], &clone->as.table->values[i], cursor);
+        }
+
+        clone->as.table->keys = keys;
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static json_value_t *json_clone_node(json_value_t *json, char **cursor)
+{
+    json_value_t *clone = json_clone_alloc(cursor, json, sizeof(json_value_t));
+
+    json_clone_payload(json, clone, cursor);
+    return clone;
+}
+
+static const void *json_snapshot_record(const json_snapshot_t *snapshot, uint64_t offset)
+{
+    return (const char *) snapshot + offset;
+}
+
+static uint64_t json_snapshot_count(const json_snapshot_t *snapshot, const json_snapshot_node_t *node)
+{
+    const uint64_t *record = json_snapshot_record(snapshot, node->as.offset);
+    return *record;
+}
+
+/*
+ Scalars of a snapshot are loaded into temporary nodes and go through the
+ regular functions of the emitter, containers are framed by the emitter.
+*/
+
+static void json_snapshot_load(const json_snapshot_t *snapshot, const json_snapshot_node_t *node,
+                               json_value_t *json, json_padded_int_t *padded)
+{
+    json->type = (json_value_type_t) node->type;
+
+    switch (json->type) {
+    case JSON_VALUE_TYPE_BOOL:
+        json->as.boolean = node->as.boolean != 0;
+        break;
+    case JSON_VALUE_TYPE_INT:
+        json->as.integer = node->as.integer;
+        break;
+    case JSON_VALUE_TYPE_FLOAT:
+        json->as.floating = node->as.floating;
+        break;
+    case JSON_VALUE_TYPE_STRING:
+        json->as.string = (const char *) json_snapshot_record(snapshot, node->as.offset) + sizeof(uint64_t);
+        break;
+    case JSON_VALUE_TYPE_PADDED:
+        padded->integer = node->as.integer;
+        padded->width   = node->width;
+        json->as.padded = padded;
+        break;
+    default:
+        break;
+    }
+}
+
+static const json_snapshot_node_t *json_snapshot_entry(const json_snapshot_t *snapshot, const json_snapshot_node_t *node,
+                                                       size_t index, const char **key)
+{
+    const char *record = json_snapshot_record(snapshot, node->as.offset);
+
+    if (node->type == JSON_VALUE_TYPE_ARRAY) {
+        return (const json_snapshot_node_t *) (record + sizeof(uint64_t)) + index;
+    }
+
+    const json_snapshot_prop_t *property = (const json_snapshot_prop_t *) (record + sizeof(uint64_t)) + index;
+
+    *key = (const char *) json_snapshot_record(snapshot, property->key) + sizeof(uint64_t);
+    return &property->entry;
+}
+
+static void json_snapshot_size_compute_node(const json_snapshot_t *snapshot, const json_snapshot_node_t *node,
+                                            json_size_context_t *context)
+{
+    if (node->type != JSON_VALUE_TYPE_ARRAY && node->type != JSON_VALUE_TYPE_OBJECT) {
+        json_value_t      json;
+        json_padded_int_t padded;
+
+        json_snapshot_load(snapshot, node, &json, &padded);
+        json_size_compute(&json, context);
+        return;
+    }
+
+    size_t count = json_snapshot_count(snapshot, node);
+
+    context->emitter->size_frame(context, (json_value_type_t) node->type, count);
+
+    for (size_t i = 0; i < count; i++) {
+        const char                 *key   = NULL;
+        const json_snapshot_node_t *entry = json_snapshot_entry(snapshot, node, i, &key);
+
+        if (key != NULL) {
+            context->emitter->size_key(context, key);
+        }
+
+        json_snapshot_size_compute_node(snapshot, entry, context);
+    }
+}
+
+static void json_snapshot_write_node(const json_snapshot_t *snapshot, const json_snapshot_node_t *node,
+                                     json_write_context_t *context)
+{
+    if (node->type != JSON_VALUE_TYPE_ARRAY && node->type != JSON_VALUE_TYPE_OBJECT) {
+        json_value_t      json;
+        json_padded_int_t padded;
+
+        json_snapshot_load(snapshot, node, &json, &padded);
+        json_write(&json, context);
+        return;
+    }
+
+    json_value_type_t type  = (json_value_type_t) node->type;
+    size_t            count = json_snapshot_count(snapshot, node);
+
+    context->emitter->write_begin(context, type, count);
+
+    for (size_t i = 0; i < count; i++) {
+        const char                 *key   = NULL;
+        const json_snapshot_node_t *entry = json_snapshot_entry(snapshot, node, i, &key);
+
+        context->emitter->write_separator(context, type, i);
+
+        if (key != NULL) {
+            context->emitter->write_key(context, key);
+        }
+
+        json_snapshot_write_node(snapshot, entry, context);
+    }
+
+    context->emitter->write_end(context, type, count);
+}
+
+static void json_size_compute_func_for_snapshot(json_value_t *json, json_size_context_t *context)
+{
+    json_snapshot_size_compute_node(json->as.snapshot, &json->as.snapshot->root, context);
+}
+
+static void json_write_func_for_snapshot(json_value_t *json, json_write_context_t *context)
+{
+    json_snapshot_write_node(json->as.snapshot, &json->as.snapshot->root, context);
+}
+
+static size_t json_snapshot_slots_count(const json_snapshot_t *snapshot, const json_snapshot_node_t *node)
+{
+    size_t count = node->type == JSON_VALUE_TYPE_PADDED ? 1 : 0;
+
+    if (node->type == JSON_VALUE_TYPE_ARRAY || node->type == JSON_VALUE_TYPE_OBJECT) {
+        for (size_t i = 0; i < json_snapshot_count(snapshot, node); i++) {
+            const char *key = NULL;
+            count += json_snapshot_slots_count(snapshot, json_snapshot_entry(snapshot, node, i, &key));
+        }
+    }
+
+    return count;
+}
+
+static bool json_generator_next(json_value_t *json, size_t index, json_prop_t *property)
+{
+    if (json->type == JSON_VALUE_TYPE_ARRAY_GENERATOR) {
+        return json->as.array_generator->next(json->as.array_generator->context, index, property->entry);
+    }
+
+    return json->as.object_generator->next(json->as.object_generator->context, index, property);
+}
+
+static json_value_type_t json_generator_type(json_value_t *json)
+{
+    return json->type == JSON_VALUE_TYPE_ARRAY_GENERATOR ? JSON_VALUE_TYPE_ARRAY : JSON_VALUE_TYPE_OBJECT;
+}
+
+static size_t json_generator_count(json_value_t *json)
+{
+    json_value_t entry    = { .type = JSON_VALUE_TYPE_NULL };
+    json_prop_t  property = { .key = NULL, .entry = &entry };
+    size_t       count    = 0;
+
+    while (json_generator_next(json, count, &property)) {
+        count++;
+    }
+
+    return count;
+}
+
+static void json_size_compute_func_for_generator(json_value_t *json, json_size_context_t *context)
+{
+    json_value_type_t type     = json_generator_type(json);
+    json_value_t      entry    = { .type = JSON_VALUE_TYPE_NULL };
+    json_prop_t       property = { .key = NULL, .entry = &entry };
+    size_t            count    = 0;
+
+    while (json_generator_next(json, count, &property)) {
+        if (type == JSON_VALUE_TYPE_OBJECT) {
+            context->emitter->size_key(context, property.key);
+        }
+
+        json_size_compute(property.entry, context);
+        count++;
+    }
+
+    context->emitter->size_frame(context, type, count);
+}
+
+static void json_write_func_for_generator(json_value_t *json, json_write_context_t *context)
+{
+    json_value_type_t type     = json_generator_type(json);
+    json_value_t      entry    = { .type = JSON_VALUE_TYPE_NULL };
+    json_prop_t       property = { .key = NULL, .entry = &entry };
+    size_t            count    = 0;
+
+    context->emitter->write_begin(context, type, context->emitter->write_begin_needs_count ? json_generator_count(json) : 0);
+
+    while (json_generator_next(json, count, &property)) {
+        context->emitter->write_separator(context, type, count);
+
+        if (type == JSON_VALUE_TYPE_OBJECT) {
+            context->emitter->write_key(context, property.key);
+        }
+
+        json_write(property.entry, context);
+        count++;
+    }
+
+    context->emitter->write_end(context, type, count);
+}
+
+/*
+ Overlay walk lists the base properties in their order, with the value of
+ the patch for the keys it overrides, followed by the patch properties new
+ to the base. Every patch key is looked up in the base once, when the walk
+ starts, and the overridden base indexes are kept sorted, so the base walk
+ checks one index per property. Larger patches are matched key by key. A
+ plain object walks like an overlay with an empty patch.
+*/
+
+typedef struct json_overlay_walk_t
+{
+    const json_object_t *base;
+    const json_object_t *patch;
+    size_t               position;
+    size_t               count;
+    bool                 planned;
+    size_t               overrides;
+    size_t               next;
+    uint32_t             overridden;
+    size_t               base_indexes[JSON_OVERLAY_PLAN_SIZE];
+    size_t               patch_indexes[JSON_OVERLAY_PLAN_SIZE];
+} json_overlay_walk_t;
+
+static size_t json_object_find(const json_object_t *object, const char *key, size_t length);
+
+static void json_overlay_walk_init(json_overlay_walk_t *walk, json_value_t *json)
+{
+    static const json_object_t empty = { 0, NULL, NULL };
+
+    walk->base       = json->type == JSON_VALUE_TYPE_OVERLAY ? json->as.overlay->base->as.object : json->as.object;
+    walk->patch      = json->type == JSON_VALUE_TYPE_OVERLAY ? json->as.overlay->patch->as.object : &empty;
+    walk->position   = 0;
+    walk->count      = walk->base->size;
+    walk->planned    = walk->patch->size <= JSON_OVERLAY_PLAN_SIZE;
+    walk->overrides  = 0;
+    walk->next       = 0;
+    walk->overridden = 0;
+
+    assert((json->type != JSON_VALUE_TYPE_OVERLAY || json->as.overlay->base->type  == JSON_VALUE_TYPE_OBJECT) && "attempt to merge json but base is not an object");
+    assert((json->type != JSON_VALUE_TYPE_OVERLAY || json->as.overlay->patch->type == JSON_VALUE_TYPE_OBJECT) && "attempt to merge json but patch is not an object");
+
+    for (size_t i = 0; i < walk->patch->size; i++) {
+        const char *key   = walk->patch->props[i]->key;
+        size_t      index = json_object_find(walk->base, key, strlen(key));
+
+        if (index == walk->base->size) {
+            walk->count++;
+            continue;
+        }
+
+        if (!walk->planned) {
+            continue;
+        }
+
+        /* Insertion keeps the first patch property of a base index in front */
+        size_t slot = walk->overrides++;
+
+        for (; slot != 0 && walk->base_indexes[slot - 1] > index; slot--) {
+            walk->base_indexes[slot]  = walk->base_indexes[slot - 1];
+            walk->patch_indexes[slot] = walk->patch_indexes[slot - 1];
+        }
+
+        walk->base_indexes[slot]  = index;
+        walk->patch_indexes[slot] = i;
+        walk->overridden         |= (uint32_t) 1 << i;
+    }
+}
+
+static json_prop_t *json_overlay_next(json_overlay_walk_t *walk)
+{
+    if (walk->position < walk->base->size) {
+        size_t       index    = walk->position++;
+        json_prop_t *property = walk->base->props[index];
+
+        if (!walk->planned) {
+            size_t patched = json_object_find(walk->patch, property->key, strlen(property->key));
+            return patched != walk->patch->size ? walk->patch->props[patched] : property;
+        }
+
+        if (walk->next < walk->overrides && walk->base_indexes[walk->next] == index) {
+            property = walk->patch->props[walk->patch_indexes[walk->next]];
+
+            while (walk->next < walk->overrides && walk->base_indexes[walk->next] == index) {
+                walk->next++;
+            }
+        }
+
+        return property;
+    }
+
+    while (walk->position < walk->base->size + walk->patch->size) {
+        size_t       index    = walk->position++ - walk->base->size;
+        json_prop_t *property = walk->patch->props[index];
+
+        bool overrides = walk->planned ? (walk->overridden >> index & 1) != 0
+                                       : json_object_find(walk->base, property->key, strlen(property->key)) != walk->base->size;
+
+        if (!overrides) {
+            return property;
+        }
+    }
+
+    return NULL;
+}
+
+static void json_size_compute_func_for_overlay(json_value_t *json, json_size_context_t *context)
+{
+    json_overlay_walk_t walk;
+    json_prop_t        *property = NULL;
+    size_t              count    = 0;
+
+    json_overlay_walk_init(&walk, json);
+
+    while ((property = json_overlay_next(&walk)) != NULL) {
+        context->emitter->size_key(context, property->key);
+        json_size_compute(property->entry, context);
+        count++;
+    }
+
+    context->emitter->size_frame(context, JSON_VALUE_TYPE_OBJECT, count);
+}
+
+static void json_write_func_for_overlay(json_value_t *json, json_write_context_t *context)
+{
+    json_overlay_walk_t walk;
+    json_prop_t        *property = NULL;
+    size_t              count    = 0;
+
+    json_overlay_walk_init(&walk, json);
+    context->emitter->write_begin(context, JSON_VALUE_TYPE_OBJECT, walk.count);
+
+    while ((property = json_overlay_next(&walk)) != NULL) {
+        context->emitter->write_separator(context, JSON_VALUE_TYPE_OBJECT, count);
+        context->emitter->write_key(context, property->key);
+        json_write(property->entry, context);
+        count++;
+    }
+
+    context->emitter->write_end(context, JSON_VALUE_TYPE_OBJECT, count);
+}
+
+static void json_size_compute_func_for_table(json_value_t *json, json_size_context_t *context)
+{
+    json_table_t       *table = json->as.table;
+    json_size_context_t row   = {
+        .emitter = context->emitter,
+        .size    = 0,
+        .options = context->options,
+    };
+
+    context->emitter->size_frame(context, JSON_VALUE_TYPE_ARRAY, table->rows);
+
+    if (table->rows == 0) {
+        return;
+    }
+
+    /* Every row has the same frame and keys, they are sized once */
+    context->emitter->size_frame(&row, JSON_VALUE_TYPE_OBJECT, table->columns);
+
+    for (size_t i = 0; i < table->columns; i++) {
+        context->emitter->size_key(&row, table->keys[i]);
+    }
+
+    context->size   += row.size * table->rows;
+    context->invalid = context->invalid || row.invalid;
+
+    for (size_t i = 0; i < table->columns * table->rows; i++) {
+        json_size_compute(&table->values[i], context);
+    }
+}
+
+/*
+ Keys are rendered once, in the first row, and the following rows copy
+ the rendered bytes from the output. Columns past the cache are rendered
+ in every row, as well as all keys of streaming writers whose previous
+ output is already handed over.
+*/
+
+static void json_write_func_for_table(json_value_t *json, json_write_context_t *context)
+{
+    json_table_t    *table = json->as.table;
+    json_table_key_t keys[JSON_TABLE_CACHED_KEYS];
+
+    context->emitter->write_begin(context, JSON_VALUE_TYPE_ARRAY, table->rows);
+
+    for (size_t row = 0; row < table->rows; row++) {
+        context->emitter->write_separator(context, JSON_VALUE_TYPE_ARRAY, row);
+        context->emitter->write_begin(context, JSON_VALUE_TYPE_OBJECT, table->columns);
+
+        for (size_t column = 0; column < table->columns; column++) {
+            context->emitter->write_separator(context, JSON_VALUE_TYPE_OBJECT, column);
+
+            if (row != 0 && column < JSON_TABLE_CACHED_KEYS && context->flush == NULL) {
+                json_write_raw(context, keys[column].text, keys[column].size);
+            } else {
+                const char *text = context->cursor;
+
+                context->emitter->write_key(context, table->keys[column]);
+
+                if (column < JSON_TABLE_CACHED_KEYS) {
+                    keys[column] = (json_table_key_t) {
+                        .text = text,
+                        .size = (size_t) (context->cursor - text),
+                    };
+                }
+            }
+
+            json_write(&table->values[column * table->rows + row], context);
+        }
+
+        context->emitter->write_end(context, JSON_VALUE_TYPE_OBJECT, table->columns);
+    }
+
+    context->emitter->write_end(context, JSON_VALUE_TYPE_ARRAY, table->rows);
+}
+
+static void json_size_compute_func_for_compact(json_value_t *json, json_size_context_t *context)
+{
+    json_compact_t value = json->as.compact;
+    json_value_t   entry;
+
+    if (!json_compact_is_container(value)) {
+        json_compact_load(value, &entry);
+        json_size_compute(&entry, context);
+        return;
+    }
+
+    json_value_type_t type  = json_compact_container_type(value);
+    size_t            count = json_compact_count(value);
+
+    for (size_t i = 0; i < count; i++) {
+        const char *key = NULL;
+
+        json_compact_load(json_compact_entry(value, i, &key), &entry);
+
+        if (type == JSON_VALUE_TYPE_OBJECT) {
+            context->emitter->size_key(context, key);
+        }
+
+        json_size_compute(&entry, context);
+    }
+
+    context->emitter->size_frame(context, type, count);
+}
+
+static void json_write_func_for_compact(json_value_t *json, json_write_context_t *context)
+{
+    json_compact_t value = json->as.compact;
+    json_value_t   entry;
+
+    if (!json_compact_is_container(value)) {
+        json_compact_load(value, &entry);
+        json_write(&entry, context);
+        return;
+    }
+
+    json_value_type_t type  = json_compact_container_type(value);
+    size_t            count = json_compact_count(value);
+
+    context->emitter->write_begin(context, type, count);
+
+    for (size_t i = 0; i < count; i++) {
+        const char *key = NULL;
+
+        json_compact_load(json_compact_entry(value, i, &key), &entry);
+        context->emitter->write_separator(context, type, i);
+
+        if (type == JSON_VALUE_TYPE_OBJECT) {
+            context->emitter->write_key(context, key);
+        }
+
+        json_write(&entry, context);
+    }
+
+    context->emitter->write_end(context, type, count);
+}
+
+static size_t json_snapshot_string_size(const char *string)
+{
+    return json_align_size(sizeof(uint64_t) + strlen(string) + 1);
+}
+
+static size_t json_snapshot_records_size(json_value_t *json)
+{
+    size_t size = 0;
+
+    switch (json->type) {
+    case JSON_VALUE_TYPE_STRING:
+        size += json_snapshot_string_size(json->as.string);
+        break;
+    case JSON_VALUE_TYPE_BASE64:
+        size += json_align_size(sizeof(uint64_t) + json_base64_length(json->as.base64->size) + 1);
+        break;
+    case JSON_VALUE_TYPE_OVERLAY: {
+        json_overlay_walk_t walk;
+        json_prop_t        *property = NULL;
+
+        json_overlay_walk_init(&walk, json);
+        size += sizeof(uint64_t);
+
+        while ((property = json_overlay_next(&walk)) != NULL) {
+            size += sizeof(json_snapshot_prop_t) + json_snapshot_string_size(property->key);
+            size += json_snapshot_records_size(property->entry);
+        }
+        break;
+    }
+    case JSON_VALUE_TYPE_ARRAY:
+        size += sizeof(uint64_t) + json->as.array->size * sizeof(json_snapshot_node_t);
+
+        for (size_t i = 0; i < json->as.array->size; i++) {
+            size += json_snapshot_records_size(json->as.array->entries[i]);
+        }
+        break;
+    case JSON_VALUE_TYPE_OBJECT:
+        size += sizeof(uint64_t) + json->as.object->size * sizeof(json_snapshot_prop_t);
+
+        for (size_t i = 0; i < json->as.object->size; i++) {
+            size += json_snapshot_string_size(json->as.object->props[i]->key);
+            size += json_snapshot_records_size(json->as.object->props[i]->entry);
+        }
+        break;
+    case JSON_VALUE_TYPE_ARRAY_GENERATOR:
+    case JSON_VALUE_TYPE_OBJECT_GENERATOR: {
+        json_value_t entry    = { .type = JSON_VALUE_TYPE_NULL };
+        json_prop_t  property = { .key = NULL, .entry = &entry };
+        size_t       count    = 0;
+
+        while (json_generator_next(json, count, &property)) {
+            if (json->type == JSON_VALUE_TYPE_OBJECT_GENERATOR) {
+                size += sizeof(json_snapshot_prop_t) + json_snapshot_string_size(property.key);
+            } else {
+                size += sizeof(json_snapshot_node_t);
+            }
+
+            size += json_snapshot_records_size(property.entry);
+            count++;
+        }
+
+        size += sizeof(uint64_t);
+        break;
+    }
+    case JSON_VALUE_TYPE_TABLE: {
+        json_table_t *table = json->as.table;
+
+        size += sizeof(uint64_t) + table->rows * sizeof(json_snapshot_node_t);
+        size += table->rows * (sizeof(uint64_t) + table->columns * sizeof(json_snapshot_prop_t));
+
+        for (size_t i = 0; i < table->columns && table->rows != 0; i++) {
+            size += json_snapshot_string_size(table->keys[i]);
+        }
+
+        for (size_t i = 0; i < table->columns * table->rows; i++) {
+            size += json_snapshot_records_size(&table->values[i]);
+        }
+        break;
+    }
+    case JSON_VALUE_TYPE_COMPACT: {
+        json_compact_t value = json->as.compact;
+        json_value_t   entry;
+
+        if (!json_compact_is_container(value)) {
+            json_compact_load(value, &entry);
+            size += json_snapshot_records_size(&entry);
+            break;
+        }
+
+        size += sizeof(uint64_t);
+
+        for (size_t i = 0; i < json_compact_count(value); i++) {
+            const char *key = NULL;
+
+            json_compact_load(json_compact_entry(value, i, &key), &entry);
+
+            if (key != NULL) {
+                size += sizeof(json_snapshot_prop_t) + json_snapshot_string_size(key);
+            } else {
+                size += sizeof(json_snapshot_node_t);
+            }
+
+            size += json_snapshot_records_size(&entry);
+        }
+        break;
+    }
+    default:
+        assert(json->type != JSON_VALUE_TYPE_SNAPSHOT && "attempt to save json snapshot which contains a snapshot");
+        assert(json->type != JSON_VALUE_TYPE_PROJECTION && "attempt to save json snapshot which contains a projection");
+        break;
+    }
+
+    return size;
+}
+
+static uint64_t json_snapshot_write_string(char *buffer, size_t *offset, const char *string)
+{
+    uint64_t record = *offset;
+    uint64_t length = strlen(string);
+
+    memcpy(buffer + record, &length, sizeof(length));
+    memcpy(buffer + record + sizeof(length), string, length + 1);
+
+    *offset += json_snapshot_string_size(string);
+    return record;
+}
+
+static void json_snapshot_write_records(json_value_t *json, json_snapshot_node_t *node, char *buffer, size_t *offset)
+{
+    memset(node, 0, sizeof(*node));
+    node->type = (uint32_t) json->type;
+
+    switch (json->type) {
+    case JSON_VALUE_TYPE_BOOL:
+        node->as.boolean = json->as.boolean;
+        break;
+    case JSON_VALUE_TYPE_INT:
+        node->as.integer = json->as.integer;
+        break;
+    case JSON_VALUE_TYPE_FLOAT:
+        node->as.floating = json->as.floating;
+        break;
+    case JSON_VALUE_TYPE_STRING:
+        node->as.offset = json_snapshot_write_string(buffer, offset, json->as.string);
+        break;
+    case JSON_VALUE_TYPE_BASE64: {
+        /* Snapshots keep the encoded text, so they are viewed as plain strings */
+        uint64_t length = json_base64_length(json->as.base64->size);
+        char    *end    = json_base64_encode(buffer + *offset + sizeof(length), json->as.base64->data, json->as.base64->size);
+
+        *end            = '\0';
+        node->type      = JSON_VALUE_TYPE_STRING;
+        node->as.offset = *offset;
+        memcpy(buffer + *offset, &length, sizeof(length));
+        *offset += json_align_size(sizeof(length) + length + 1);
+        break;
+    }
+    case JSON_VALUE_TYPE_OVERLAY: {
+        json_overlay_walk_t   walk;
+        json_snapshot_prop_t *props    = (json_snapshot_prop_t *) (buffer + *offset + sizeof(uint64_t));
+        json_prop_t          *property = NULL;
+
+        json_overlay_walk_init(&walk, json);
+
+        uint64_t size = walk.count;
+
+        node->type      = JSON_VALUE_TYPE_OBJECT;
+        node->as.offset = *offset;
+        memcpy(buffer + *offset, &size, sizeof(size));
+        *offset += sizeof(uint64_t) + size * sizeof(json_snapshot_prop_t);
+
+        for (size_t i = 0; (property = json_overlay_next(&walk)) != NULL; i++) {
+            props[i].key = json_snapshot_write_string(buffer, offset, property->key);
+            json_snapshot_write_records(property->entry, &props[i].entry, buffer, offset);
+        }
+        break;
+    }
+    case JSON_VALUE_TYPE_PADDED:
+        assert(json->as.padded->width <= UINT32_MAX && "attempt to save json snapshot with too wide padded int");
+        node->as.integer = json->as.padded->integer;
+        node->width      = (uint32_t) json->as.padded->width;
+        break;
+    case JSON_VALUE_TYPE_ARRAY: {
+        uint64_t              size    = json->as.array->size;
+        json_snapshot_node_t *entries = (json_snapshot_node_t *) (buffer + *offset + sizeof(uint64_t));
+
+        node->as.offset = *offset;
+        memcpy(buffer + *offset, &size, sizeof(size));
+        *offset += sizeof(uint64_t) + size * sizeof(json_snapshot_node_t);
+
+        for (size_t i = 0; i < size; i++) {
+            json_snapshot_write_records(json->as.array->entries[i], &entries[i], buffer, offset);
+        }
+        break;
+    }
+    case JSON_VALUE_TYPE_OBJECT: {
+        uint64_t              size  = json->as.object->size;
+        json_snapshot_prop_t *props = (json_snapshot_prop_t *) (buffer + *offset + sizeof(uint64_t));
+
+        node->as.offset = *offset;
+        memcpy(buffer + *offset, &size, sizeof(size));
+        *offset += sizeof(uint64_t) + size * sizeof(json_snapshot_prop_t);
+
+        for (size_t i = 0; i < size; i++) {
+            props[i].key = json_snapshot_write_string(buffer, offset, json->as.object->props[i]->key);
+            json_snapshot_write_records(json->as.object->props[i]->entry, &props[i].entry, buffer, offset);
+        }
+        break;
+    }
+    case JSON_VALUE_TYPE_ARRAY_GENERATOR:
+    case JSON_VALUE_TYPE_OBJECT_GENERATOR: {
+        uint64_t              size     = json_generator_count(json);
+        json_snapshot_node_t *entries  = (json_snapshot_node_t *) (buffer + *offset + sizeof(uint64_t));
+        json_snapshot_prop_t *props    = (json_snapshot_prop_t *) (buffer + *offset + sizeof(uint64_t));
+        json_value_t          entry    = { .type = JSON_VALUE_TYPE_NULL };
+        json_prop_t           property = { .key = NULL, .entry = &entry };
+
+        node->type      = (uint32_t) json_generator_type(json);
+        node->as.offset = *offset;
+        memcpy(buffer + *offset, &size, sizeof(size));
+
+        if (json->type == JSON_VALUE_TYPE_OBJECT_GENERATOR) {
+            *offset += sizeof(uint64_t) + size * sizeof(json_snapshot_prop_t);
+        } else {
+            *offset += sizeof(uint64_t) + size * sizeof(json_snapshot_node_t);
+        }
+
+        for (size_t i = 0; i < size && json_generator_next(json, i, &property); i++) {
+            if (json->type == JSON_VALUE_TYPE_OBJECT_GENERATOR) {
+                props[i].key = json_snapshot_write_string(buffer, offset, property.key);
+                json_snapshot_write_records(property.entry, &props[i].entry, buffer, offset);
+            } else {
+                json_snapshot_write_records(property.entry, &entries[i], buffer, offset);
+            }
+        }
+        break;
+    }
+    case JSON_VALUE_TYPE_TABLE: {
+        json_table_t         *table   = json->as.table;
+        uint64_t              rows    = table->rows;
+        uint64_t              columns = table->columns;
+        json_snapshot_node_t *entries = (json_snapshot_node_t *) (buffer + *offset + sizeof(uint64_t));
+        json_snapshot_prop_t *first   = NULL;
+
+        node->type      = JSON_VALUE_TYPE_ARRAY;
+        node->as.offset = *offset;
+        memcpy(buffer + *offset, &rows, sizeof(rows));
+        *offset += sizeof(uint64_t) + rows * sizeof(json_snapshot_node_t);
+
+        /* Rows are written as objects which share the key strings of the first row */
+        for (size_t row = 0; row < rows; row++) {
+            json_snapshot_prop_t *props = (json_snapshot_prop_t *) (buffer + *offset + sizeof(uint64_t));
+
+            memset(&entries[row], 0, sizeof(entries[row]));
+            entries[row].type      = JSON_VALUE_TYPE_OBJECT;
+            entries[row].as.offset = *offset;
+            memcpy(buffer + *offset, &columns, sizeof(columns));
+            *offset += sizeof(uint64_t) + columns * sizeof(json_snapshot_prop_t);
+
+            for (size_t column = 0; column < columns; column++) {
+                props[column].key = first ? first[column].key : json_snapshot_write_string(buffer, offset, table->keys[column]);
+                json_snapshot_write_records(&table->values[column * rows + row], &props[column].entry, buffer, offset);
+            }
+
+            first = props;
+        }
+        break;
+    }
+    case JSON_VALUE_TYPE_COMPACT: {
+        json_compact_t value = json->as.compact;
+        json_value_t   entry;
+
+        if (!json_compact_is_container(value)) {
+            json_compact_load(value, &entry);
+            json_snapshot_write_records(&entry, node, buffer, offset);
+            break;
+        }
+
+        uint64_t              size    = json_compact_count(value);
+        json_snapshot_node_t *entries = (json_snapshot_node_t *) (buffer + *offset + sizeof(uint64_t));
+        json_snapshot_prop_t *props   = (json_snapshot_prop_t *) (buffer + *offset + sizeof(uint64_t));
+
+        node->type      = (uint32_t) json_compact_container_type(value);
+        node->as.offset = *offset;
+        memcpy(buffer + *offset, &size, sizeof(size));
+
+        if (node->type == JSON_VALUE_TYPE_OBJECT) {
+            *offset += sizeof(uint64_t) + size * sizeof(json_snapshot_prop_t);
+        } else {
+            *offset += sizeof(uint64_t) + size * sizeof(json_snapshot_node_t);
+        }
+
+        for (size_t i = 0; i < size; i++) {
+            const char *key = NULL;
+
+            json_compact_load(json_compact_entry(value, i, &key), &entry);
+
+            if (node->type == JSON_VALUE_TYPE_OBJECT) {
+                props[i].key = json_snapshot_write_string(buffer, offset, key);
+                json_snapshot_write_records(&entry, &props[i].entry, buffer, offset);
+            } else {
+                json_snapshot_write_records(&entry, &entries[i], buffer, offset);
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static size_t json_projection_slots_count(json_value_t *json, const json_mask_t *mask);
+
+static size_t json_slots_count(json_value_t *json)
+{
+    size_t count = 0;
+
+    switch (json->type) {
+    case JSON_VALUE_TYPE_PADDED:
+        count += 1;
+        break;
+    case JSON_VALUE_TYPE_ARRAY:
+        for (size_t i = 0; i < json->as.array->size; i++) {
+            count += json_slots_count(json->as.array->entries[i]);
+        }
+        break;
+    case JSON_VALUE_TYPE_OBJECT:
+        for (size_t i = 0; i < json->as.object->size; i++) {
+            count += json_slots_count(json->as.object->props[i]->entry);
+        }
+        break;
+    case JSON_VALUE_TYPE_SNAPSHOT:
+        count += json_snapshot_slots_count(json->as.snapshot, &json->as.snapshot->root);
+        break;
+    case JSON_VALUE_TYPE_ARRAY_GENERATOR:
+    case JSON_VALUE_TYPE_OBJECT_GENERATOR: {
+        json_value_t entry    = { .type = JSON_VALUE_TYPE_NULL };
+        json_prop_t  property = { .key = NULL, .entry = &entry };
+
+        for (size_t i = 0; json_generator_next(json, i, &property); i++) {
+            count += json_slots_count(property.entry);
+        }
+        break;
+    }
+    case JSON_VALUE_TYPE_TABLE:
+        for (size_t i = 0; i < json->as.table->columns * json->as.table->rows; i++) {
+            count += json_slots_count(&json->as.table->values[i]);
+        }
+        break;
+    case JSON_VALUE_TYPE_OVERLAY: {
+        json_overlay_walk_t walk;
+        json_prop_t        *property = NULL;
+
+        json_overlay_walk_init(&walk, json);
+
+        while ((property = json_overlay_next(&walk)) != NULL) {
+            count += json_slots_count(property->entry);
+        }
+        break;
+    }
+    case JSON_VALUE_TYPE_PROJECTION:
+        count += json_projection_slots_count(json->as.projection->json, json->as.projection->mask);
+        break;
+    default:
+        break;
+    }
+
+    return count;
+}
+
+char *json_stringify(json_value_t *json)
+{
+    assert(json && "attempt to stringify json but json is a null pointer");
+
+    size_t length = json_emit_size(&json_emitter_text, json);
+    char  *buffer = calloc(length + 1, sizeof(char));
+
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    size_t written = json_emit(&json_emitter_text, json, buffer, NULL);
+    assert(length == written && "not all data was written to the buffer");
+
+    return buffer;
+}
+
+size_t json_stringify_into_buffer(json_value_t *json, char *buffer)
+{
+    assert(json   && "attempt to write json into buffer but json is a null pointer");
+    assert(buffer && "attempt to write json into buffer but buffer is a null pointer");
+
+    size_t written = json_emit(&json_emitter_text, json, buffer, NULL);
+    buffer[written] = '\0';
+
+    return written;
+}
+
+bool json_stringified_size_with_options(json_value_t *json, unsigned options, size_t *size)
+{
+    assert(json && "attempt to compute json size but json is a null pointer");
+    assert(size && "attempt to compute json size but size is a null pointer");
+
+    /* Non-ASCII characters can be escaped only when they are decoded */
+    json_size_context_t context = {
+        .emitter = &json_emitter_text,
+        .size    = 0,
+        .options = options & JSON_STRINGIFY_ESCAPE_NON_ASCII ? options | JSON_STRINGIFY_VALIDATE_UTF8 : options,
+    };
+
+    json_size_compute(json, &context);
+    *size = context.size + 1;
+
+    return !context.invalid;
+}
+
+size_t json_stringify_into_buffer_with_options(json_value_t *json, unsigned options, char *buffer)
+{
+    assert(json   && "attempt to write json into buffer but json is a null pointer");
+    assert(buffer && "attempt to write json into buffer but buffer is a null pointer");
+
+    json_write_context_t context = {
+        .emitter = &json_emitter_text,
+        .buffer  = buffer,
+        .cursor  = buffer,
+        .options = options,
+    };
+
+    json_write(json, &context);
+    *context.cursor = '\0';
+
+    return (size_t) (context.cursor - buffer);
+}
+
+char *json_stringify_with_options(json_value_t *json, unsigned options)
+{
+    assert(json && "attempt to stringify json but json is a null pointer");
+
+    size_t size = 0;
+
+    if (!json_stringified_size_with_options(json, options, &size)) {
+        return NULL;
+    }
+
+    char *buffer = malloc(size);
+
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    size_t written = json_stringify_into_buffer_with_options(json, options, buffer);
+    assert(size == written + 1 && "not all data was written to the buffer");
+    (void) written;
+
+    return buffer;
+}
+
+/*
+ Bounded writing goes straight into the caller's buffer. Its last slack
+ can't take a node without a check, so the tail is written through a
+ scratch area copied into the buffer on every flush. When the text doesn't
+ fit, the writer switches to the discard emitter and only then the exact
+ size is computed.
+*/
+
+typedef struct json_bounded_t
+{
+    char   *output;
+    size_t  usable;
+    size_t  written;
+    bool    overflowed;
+    char    scratch[JSON_BOUNDED_SCRATCH];
+} json_bounded_t;
+
+static void json_bounded_flush(json_write_context_t *context)
+{
+    json_bounded_t *bounded = context->sink;
+    size_t          size    = (size_t) (context->cursor - context->buffer);
+
+    if (context->buffer == bounded->output) {
+        bounded->written = size;
+    } else if (!bounded->overflowed && bounded->written + size <= bounded->usable) {
+        memcpy(bounded->output + bounded->written, context->buffer, size);
+        bounded->written += size;
+    } else {
+        bounded->overflowed = true;
+        context->emitter    = &json_emitter_discard;
+    }
+
+    context->buffer = bounded->scratch;
+    context->cursor = bounded->scratch;
+    context->end    = bounded->scratch + JSON_BOUNDED_SCRATCH;
+    context->limit  = context->end - JSON_PIPELINE_SLACK;
+}
+
+bool json_stringify_into_buffer_n(json_value_t *json, char *buffer, size_t capacity, size_t *needed)
+{
+    assert(json   && "attempt to write json into buffer but json is a null pointer");
+    assert(buffer && "attempt to write json into buffer but buffer is a null pointer");
+    assert(needed && "attempt to write json into buffer but needed is a null pointer");
+
+    json_bounded_t bounded = {
+        .output     = buffer,
+        .usable     = capacity != 0 ? capacity - 1 : 0,
+        .written    = 0,
+        .overflowed = capacity == 0,
+    };
+
+    json_write_context_t context = {
+        .emitter = bounded.overflowed ? &json_emitter_discard : &json_emitter_text,
+        .flush   = json_bounded_flush,
+        .sink    = &bounded,
+    };
+
+    /* Buffers smaller than the slack are written through the scratch from the start */
+    if (bounded.usable > JSON_PIPELINE_SLACK) {
+        context.buffer = buffer;
+        context.cursor = buffer;
+        context.end    = buffer + bounded.usable;
+        context.limit  = context.end - JSON_PIPELINE_SLACK;
+    } else {
+        context.buffer = bounded.scratch;
+        context.cursor = bounded.scratch;
+        context.end    = bounded.scratch + JSON_BOUNDED_SCRATCH;
+        context.limit  = context.end - JSON_PIPELINE_SLACK;
+    }
+
+    json_write(json, &context);
+    json_bounded_flush(&context);
+
+    if (bounded.overflowed) {
+        *needed = json_emit_size(&json_emitter_text, json) + 1;
+        return false;
+    }
+
+    buffer[bounded.written] = '\0';
+    *needed = bounded.written + 1;
+
+    return true;
+}
+
+static size_t json_reuse_capacity(size_t size)
+{
+    size_t capacity = JSON_REUSE_MIN_CAPACITY;
+
+    while (capacity < size) {
+        capacity *= 2;
+    }
+
+    return capacity;
+}
+
+/*
+ The thread local slot only holds the pointer, so with threads support the
+ memory is also kept in a key with a destructor which releases it when the
+ thread exits.
+*/
+
+#if defined(STATIC_JSON_BUILDER_THREADS) && defined(_WIN32)
+
+static INIT_ONCE json_reuse_once = INIT_ONCE_STATIC_INIT;
+static DWORD     json_reuse_key  = FLS_OUT_OF_INDEXES;
+
+static void NTAPI json_reuse_destroy(void *memory)
+{
+    free(memory);
+}
+
+static BOOL CALLBACK json_reuse_key_create(PINIT_ONCE once, void *parameter, void **context)
+{
+    (void) once;
+    (void) parameter;
+    (void) context;
+
+    json_reuse_key = FlsAlloc(json_reuse_destroy);
+    return TRUE;
+}
+
+static void json_reuse_register(void *memory)
+{
+    InitOnceExecuteOnce(&json_reuse_once, json_reuse_key_create, NULL, NULL);
+
+    if (json_reuse_key != FLS_OUT_OF_INDEXES) {
+        FlsSetValue(json_reuse_key, memory);
+    }
+}
+
+#elif defined(STATIC_JSON_BUILDER_THREADS)
+
+static pthread_once_t json_reuse_once  = PTHREAD_ONCE_INIT;
+static pthread_key_t  json_reuse_key;
+static bool           json_reuse_keyed = false;
+
+static void json_reuse_destroy(void *memory)
+{
+    free(memory);
+}
+
+static void json_reuse_key_create(void)
+{
+    json_reuse_keyed = pthread_key_create(&json_reuse_key, json_reuse_destroy) == 0;
+}
+
+static void json_reuse_register(void *memory)
+{
+    pthread_once(&json_reuse_once, json_reuse_key_create);
+
+    if (json_reuse_keyed) {
+        pthread_setspecific(json_reuse_key, memory);
+    }
+}
+
+#else
+
+static void json_reuse_register(void *memory)
+{
+    (void) memory;
+}
+
+#endif
+
+static bool json_reuse_resize(json_reuse_buffer_t *reuse, size_t capacity)
+{
+    char *memory = malloc(capacity);
+
+    if (memory == NULL) {
+        return false;
+    }
+
+    free(reuse->memory);
+    json_reuse_register(memory);
+    reuse->memory   = memory;
+    reuse->capacity = capacity;
+
+    return true;
+}
+
+static void json_reuse_track(json_reuse_buffer_t *reuse, size_t size)
+{
+    reuse->window_peak = size > reuse->window_peak ? size : reuse->window_peak;
+    reuse->window_calls++;
+}
+
+static void json_reuse_shrink(json_reuse_buffer_t *reuse)
+{
+    if (reuse->window_calls < JSON_REUSE_WINDOW) {
+        return;
+    }
+
+    size_t capacity = json_reuse_capacity(reuse->window_peak);
+
+    if (capacity * JSON_REUSE_SHRINK_FACTOR <= reuse->capacity) {
+        json_reuse_resize(reuse, capacity);
+    }
+
+    reuse->window_peak  = 0;
+    reuse->window_calls = 0;
+}
+
+const char *json_stringify_reusable(json_value_t *json, size_t *length)
+{
+    assert(json   && "attempt to stringify json into reusable buffer but json is a null pointer");
+    assert(length && "attempt to stringify json into reusable buffer but length is a null pointer");
+
+    json_reuse_buffer_t *reuse  = &json_reuse_buffer;
+    size_t               needed = 0;
+
+    json_reuse_shrink(reuse);
+
+    if (reuse->memory == NULL && !json_reuse_resize(reuse, JSON_REUSE_MIN_CAPACITY)) {
+        return NULL;
+    }
+
+    if (!json_stringify_into_buffer_n(json, reuse->memory, reuse->capacity, &needed)) {
+        if (!json_reuse_resize(reuse, json_reuse_capacity(needed))) {
+            return NULL;
+        }
+
+        json_stringify_into_buffer(json, reuse->memory);
+    }
+
+    json_reuse_track(reuse, needed);
+
+    *length = needed - 1;
+    return reuse->memory;
+}
+
+void json_release_reusable_buffer(void)
+{
+    free(json_reuse_buffer.memory);
+    json_reuse_register(NULL);
+    json_reuse_buffer = (json_reuse_buffer_t) { 0 };
+}
+
+size_t json_int_text_size(int64_t integer)
+{
+    return json_padded_int_digits(integer);
+}
+
+char *json_int_text_write(char *cursor, int64_t integer)
+{
+    assert(cursor && "attempt to write json integer but cursor is a null pointer");
+
+    return cursor + json_format_int(cursor, integer);
+}
+
+size_t json_float_text_size(double floating)
+{
+    return json_float_length(floating);
+}
+
+char *json_float_text_write(char *cursor, double floating)
+{
+    assert(cursor && "attempt to write json float but cursor is a null pointer");
+
+    return cursor + json_format_float(cursor, floating);
+}
+
+size_t json_string_text_size(const char *string)
+{
+    assert(string && "attempt to get json string size but string is a null pointer");
+
+    return strlen("\"") + json_escaped_size(string) + strlen("\"");
+}
+
+char *json_string_text_write(char *cursor, const char *string)
+{
+    assert(cursor && "attempt to write json string but cursor is a null pointer");
+    assert(string && "attempt to write json string but string is a null pointer");
+
+    json_write_context_t context = {
+        .emitter     = &json_emitter_text,
+        .buffer      = cursor,
+        .cursor      = cursor,
+        .slots       = NULL,
+        .slots_count = 0,
+    };
+
+    json_write_raw(&context, "\"", strlen("\""));
+    json_write_escaped(&context, string);
+    json_write_raw(&context, "\"", strlen("\""));
+
+    return context.cursor;
+}
+
+#if defined(STATIC_JSON_BUILDER_THREADS)
+
+/*
+ Pipeline is a ring of chunks shared by the serializing thread and a writer
+ thread. The serializer publishes a filled chunk by incrementing `produced`,
+ the writer releases a written chunk by incrementing `consumed`, so each
+ counter has a single writer and the handoff needs no locks.
+*/
+
+typedef struct json_pipeline_t
+{
+    int             fd;
+    char           *memory;
+    size_t         *sizes;
+    size_t          chunk_size;
+    size_t          chunks_count;
+    volatile size_t produced;
+    volatile size_t consumed;
+    volatile size_t finished;
+    volatile size_t failed;
+} json_pipeline_t;
+
+/*
+ MSVC barriers only restrain the compiler and volatile accesses are plain
+ ones on ARM, so the interlocked functions provide the ordering there.
+*/
+
+static size_t json_atomic_load(const volatile size_t *value)
+{
+#if defined(_MSC_VER)
+    return (size_t) InterlockedCompareExchangePointer((PVOID volatile *) value, NULL, NULL);
+#else
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static void json_atomic_store(volatile size_t *value, size_t desired)
+{
+#if defined(_MSC_VER)
+    InterlockedExchangePointer((PVOID volatile *) value, (PVOID) desired);
+#else
+    __atomic_store_n(value, desired, __ATOMIC_RELEASE);
+#endif
+}
+
+static void json_thread_yield(void)
+{
+#if defined(_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+static bool json_write_fd(int fd, const char *data, size_t size)
+{
+    while (size != 0) {
+#if defined(_WIN32)
+        int written = _write(fd, data, size > INT_MAX ? INT_MAX : (unsigned) size);
+#else
+        ssize_t written = write(fd, data, size);
+
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (written <= 0) {
+            return false;
+        }
+
+        data += written;
+        size -= (size_t) written;
+    }
+
+    return true;
+}
+
+static void json_pipeline_drain(json_pipeline_t *pipeline)
+{
+    size_t consumed = 0;
+
+    for (;;) {
+        while (json_atomic_load(&pipeline->produced) == consumed) {
+            if (json_atomic_load(&pipeline->finished) && json_atomic_load(&pipeline->produced) == consumed) {
+                return;
+            }
+
+            json_thread_yield();
+        }
+
+        size_t chunk = consumed % pipeline->chunks_count;
+
+        if (!pipeline->failed && !json_write_fd(pipeline->fd, pipeline->memory + chunk * pipeline->chunk_size, pipeline->sizes[chunk])) {
+            json_atomic_store(&pipeline->failed, true);
+        }
+
+        json_atomic_store(&pipeline->consumed, ++consumed);
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI json_pipeline_thread(LPVOID pipeline)
+{
+    json_pipeline_drain(pipeline);
+    return 0;
+}
+#else
+static void *json_pipeline_thread(void *pipeline)
+{
+    json_pipeline_drain(pipeline);
+    return NULL;
+}
+#endif
+
+static void json_pipeline_publish(json_write_context_t *context)
+{
+    json_pipeline_t *pipeline = context->sink;
+    size_t           produced = pipeline->produced;
+
+    pipeline->sizes[produced % pipeline->chunks_count] = (size_t) (context->cursor - context->buffer);
+    json_atomic_store(&pipeline->produced, ++produced);
+}
+
+static void json_pipeline_flush(json_write_context_t *context)
+{
+    json_pipeline_t *pipeline = context->sink;
+
+    json_pipeline_publish(context);
+
+    /* The next chunk is free once the writer has released it */
+    while (pipeline->produced - json_atomic_load(&pipeline->consumed) >= pipeline->chunks_count) {
+        json_thread_yield();
+    }
+
+    context->buffer = pipeline->memory + pipeline->produced % pipeline->chunks_count * pipeline->chunk_size;
+    context->cursor = context->buffer;
+    context->end    = context->buffer + pipeline->chunk_size;
+    context->limit  = context->end - JSON_PIPELINE_SLACK;
+}
+
+bool json_stringify_to_fd_pipelined(json_value_t *json, int fd, size_t chunk_size, size_t chunks_count)
+{
+    assert(json && "attempt to stringify json into file descriptor but json is a null pointer");
+
+    json_pipeline_t pipeline = {
+        .fd           = fd,
+        .chunk_size   = chunk_size > JSON_PIPELINE_MIN_CHUNK ? chunk_size : JSON_PIPELINE_MIN_CHUNK,
+        .chunks_count = chunks_count > JSON_PIPELINE_MIN_CHUNKS ? chunks_count : JSON_PIPELINE_MIN_CHUNKS,
+    };
+
+    pipeline.memory = malloc(pipeline.chunk_size * pipeline.chunks_count);
+    pipeline.sizes  = calloc(pipeline.chunks_count, sizeof(size_t));
+
+    if (pipeline.memory == NULL || pipeline.sizes == NULL) {
+        free(pipeline.memory);
+        free(pipeline.sizes);
+        return false;
+    }
+
+#if defined(_WIN32)
+    HANDLE thread  = CreateThread(NULL, 0, json_pipeline_thread, &pipeline, 0, NULL);
+    bool   started = thread != NULL;
+#else
+    pthread_t thread;
+    bool      started = pthread_create(&thread, NULL, json_pipeline_thread, &pipeline) == 0;
+#endif
+
+    if (!started) {
+        free(pipeline.memory);
+        free(pipeline.sizes);
+        return false;
+    }
+
+    json_write_context_t context = {
+        .emitter = &json_emitter_text,
+        .buffer  = pipeline.memory,
+        .cursor  = pipeline.memory,
+        .end     = pipeline.memory + pipeline.chunk_size,
+        .limit   = pipeline.memory + pipeline.chunk_size - JSON_PIPELINE_SLACK,
+        .flush   = json_pipeline_flush,
+        .sink    = &pipeline,
+    };
+
+    json_write(json, &context);
+    json_pipeline_publish(&context);
+    json_atomic_store(&pipeline.finished, true);
+
+#if defined(_WIN32)
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+
+    free(pipeline.memory);
+    free(pipeline.sizes);
+
+    return !pipeline.failed;
+}
+
+/*
+ Log is a multi-producer single-consumer byte ring. Producers reserve whole
+ records by advancing `head` with compare-and-swap, serialize into them and
+ publish them by storing the record sequence into its header. The consumer
+ copies published records into a batch, releases the ring space by
+ advancing `tail` and writes the batch with one call. A record that doesn't
+ fit before the end of the ring is preceded by a padding record up to it.
+
+ Sequences are the ring positions plus one and grow forever, so a header
+ left from a previous lap never matches; the first word of stale json
+ text doesn't either since json text has no zero bytes.
+*/
+
+typedef struct json_log_record_t
+{
+    volatile uint64_t sequence;
+    size_t            length;
+} json_log_record_t;
+
+struct json_log_t
+{
+    int             fd;
+    char           *memory;
+    char           *batch;
+    size_t          capacity;
+    /* Shared between threads, only accessed through the json_atomic_* helpers */
+    volatile size_t head;
+    volatile size_t tail;
+    volatile size_t closing;
+    volatile size_t failed;
+#if defined(_WIN32)
+    HANDLE          thread;
+#else
+    pthread_t       thread;
+#endif
+};
+
+static bool json_atomic_compare_exchange(volatile size_t *value, size_t expected, size_t desired)
+{
+#if defined(_MSC_VER)
+    return (size_t) InterlockedCompareExchangePointer((PVOID volatile *) value, (PVOID) desired, (PVOID) expected) == expected;
+#else
+    return __atomic_compare_exchange_n(value, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static uint64_t json_atomic_load_sequence(const volatile uint64_t *value)
+{
+#if defined(_MSC_VER)
+    return (uint64_t) InterlockedCompareExchange64((LONG64 volatile *) value, 0, 0);
+#else
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static void json_atomic_store_sequence(volatile uint64_t *value, uint64_t desired)
+{
+#if defined(_MSC_VER)
+    InterlockedExchange64((LONG64 volatile *) value, (LONG64) desired);
+#else
+    __atomic_store_n(value, desired, __ATOMIC_RELEASE);
+#endif
+}
+
+/* Idle consumer yields for a while and then sleeps, so an empty log doesn't spin */
+static void json_thread_pause(size_t *idle)
+{
+    if (++*idle < JSON_LOG_IDLE_YIELDS) {
+        json_thread_yield();
+        return;
+    }
+
+#if defined(_WIN32)
+    Sleep(1);
+#else
+    poll(NULL, 0, 1);
+#endif
+}
+
+static size_t json_log_record_size(size_t length)
+{
+    return (sizeof(json_log_record_t) + length + JSON_LOG_ALIGNMENT - 1) / JSON_LOG_ALIGNMENT * JSON_LOG_ALIGNMENT;
+}
+
+static json_log_record_t *json_log_record(json_log_t *log, size_t position)
+{
+    return (json_log_record_t *) (log->memory + (position & (log->capacity - 1)));
+}
+
+static void json_log_drain(json_log_t *log)
+{
+    size_t tail = json_atomic_load(&log->tail);
+    size_t idle = 0;
+
+    for (;;) {
+        size_t batched = 0;
+
+        /* Records larger than the rest of the batch wait for the next one, the batch is as large as the ring */
+        for (;;) {
+            json_log_record_t *record = json_log_record(log, tail);
+
+            if (json_atomic_load_sequence(&record->sequence) != (uint64_t) tail + 1) {
+                break;
+            }
+
+            if (record->length & JSON_LOG_PADDING) {
+                tail += record->length & ~JSON_LOG_PADDING;
+                continue;
+            }
+
+            if (batched + record->length > log->capacity) {
+                break;
+            }
+
+            memcpy(log->batch + batched, record + 1, record->length);
+            batched += record->length;
+            tail    += json_log_record_size(record->length);
+        }
+
+        json_atomic_store(&log->tail, tail);
+
+        if (batched != 0) {
+            idle = 0;
+
+            if (!json_atomic_load(&log->failed) && !json_write_fd(log->fd, log->batch, batched)) {
+                json_atomic_store(&log->failed, true);
+            }
+        } else if (json_atomic_load(&log->closing) && json_atomic_load(&log->head) == tail) {
+            return;
+        } else {
+            json_thread_pause(&idle);
+        }
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI json_log_thread(LPVOID log)
+{
+    json_log_drain(log);
+    return 0;
+}
+#else
+static void *json_log_thread(void *log)
+{
+    json_log_drain(log);
+    return NULL;
+}
+#endif
+
+json_log_t *json_log_open(int fd, size_t capacity)
+{
+    json_log_t *log = calloc(1, sizeof(json_log_t));
+
+    if (log == NULL) {
+        return NULL;
+    }
+
+    log->fd       = fd;
+    log->capacity = JSON_LOG_MIN_CAPACITY;
+
+    while (log->capacity < capacity) {
+        log->capacity *= 2;
+    }
+
+    /* Zeroed ring has no published records: the first sequence is 1 */
+    log->memory = calloc(log->capacity, sizeof(char));
+    log->batch  = malloc(log->capacity);
+
+    if (log->memory == NULL || log->batch == NULL) {
+        free(log->memory);
+        free(log->batch);
+        free(log);
+        return NULL;
+    }
+
+#if defined(_WIN32)
+    log->thread  = CreateThread(NULL, 0, json_log_thread, log, 0, NULL);
+    bool started = log->thread != NULL;
+#else
+    bool started = pthread_create(&log->thread, NULL, json_log_thread, log) == 0;
+#endif
+
+    if (!started) {
+        free(log->memory);
+        free(log->batch);
+        free(log);
+        return NULL;
+    }
+
+    return log;
+}
+
+bool json_log_write(json_log_t *log, json_value_t *json)
+{
+    assert(log  && "attempt to write json log record but log is a null pointer");
+    assert(json && "attempt to write json log record but json is a null pointer");
+
+    size_t length = json_emit_size(&json_emitter_text, json) + strlen("\n");
+    size_t size   = json_log_record_size(length);
+    size_t head   = 0;
+    size_t pad    = 0;
+
+    if (size > log->capacity / 2) {
+        return false;
+    }
+
+    for (;;) {
+        head = json_atomic_load(&log->head);
+        pad  = log->capacity - (head & (log->capacity - 1));
+        pad  = pad < size ? pad : 0;
+
+        if (head + pad + size - json_atomic_load(&log->tail) > log->capacity) {
+            json_thread_yield();
+        } else if (json_atomic_compare_exchange(&log->head, head, head + pad + size)) {
+            break;
+        }
+    }
+
+    if (pad != 0) {
+        json_log_record_t *padding = json_log_record(log, head);
+
+        padding->length = pad | JSON_LOG_PADDING;
+        json_atomic_store_sequence(&padding->sequence, (uint64_t) head + 1);
+    }
+
+    json_log_record_t *record = json_log_record(log, head + pad);
+    char              *text   = (char *) (record + 1);
+
+    json_emit(&json_emitter_text, json, text, NULL);
+    text[length - 1] = '\n';
+    record->length   = length;
+    json_atomic_store_sequence(&record->sequence, (uint64_t) (head + pad) + 1);
+
+    return true;
+}
+
+bool json_log_close(json_log_t *log)
+{
+    assert(log && "attempt to close json log but log is a null pointer");
+
+    json_atomic_store(&log->closing, true);
+
+#if defined(_WIN32)
+    WaitForSingleObject(log->thread, INFINITE);
+    CloseHandle(log->thread);
+#else
+    pthread_join(log->thread, NULL);
+#endif
+
+    bool succeeded = !json_atomic_load(&log->failed);
+
+    free(log->memory);
+    free(log->batch);
+    free(log);
+
+    return succeeded;
+}
+
+#endif
+
+size_t json_stingified_size(json_value_t *json)
+{
+    assert(json && "attempt to get the json string size but json is a null pointer");
+
+    return json_emit_size(&json_emitter_text, json) + 1;
+}
+
+size_t json_stringified_size_upper_bound(json_value_t *json)
+{
+    assert(json && "attempt to get the json string size bound but json is a null pointer");
+
+    return json_emit_size(&json_emitter_text_bound, json) + 1;
+}
+
+size_t json_patchable_slots_count(json_value_t *json)
+{
+    assert(json && "attempt to count json patchable slots but json is a null pointer");
+
+    return json_slots_count(json);
+}
+
+void json_render_patchable(json_value_t *json, char *buffer, json_slot_t *slots)
+{
+    assert(json   && "attempt to render patchable json but json is a null pointer");
+    assert(buffer && "attempt to render patchable json but buffer is a null pointer");
+    assert((slots || json_slots_count(json) == 0) && "attempt to render patchable json but slots is a null pointer");
+
+    size_t written = json_emit(&json_emitter_text, json, buffer, slots);
+    buffer[written] = '\0';
+}
+
+bool json_patch_slot(char *buffer, const json_slot_t *slot, int64_t value)
+{
+    assert(buffer && "attempt to patch json slot but buffer is a null pointer");
+    assert(slot   && "attempt to patch json slot but slot is a null pointer");
+
+    char   digits[21];
+    size_t length = json_padded_int_digits(value);
+
+    if (length > slot->width) {
+        return false;
+    }
+
+    json_format_int(digits, value);
+
+    memset(buffer + slot->offset, ' ', slot->width - length);
+    memcpy(buffer + slot->offset + slot->width - length, digits, length);
+
+    return true;
+}
+
+uint8_t *json_encode_msgpack(json_value_t *json, size_t *size)
+{
+    assert(json && "attempt to encode json to msgpack but json is a null pointer");
+    assert(size && "attempt to encode json to msgpack but size is a null pointer");
+
+    size_t   length = json_emit_size(&json_emitter_msgpack, json);
+    uint8_t *buffer = malloc(length);
+
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    size_t written = json_emit(&json_emitter_msgpack, json, (char *) buffer, NULL);
+    assert(length == written && "not all data was written to the buffer");
+
+    *size = written;
+    return buffer;
+}
+
+void json_encode_msgpack_into_buffer(json_value_t *json, uint8_t *buffer)
+{
+    assert(json   && "attempt to encode json to msgpack into buffer but json is a null pointer");
+    assert(buffer && "attempt to encode json to msgpack into buffer but buffer is a null pointer");
+
+    json_emit(&json_emitter_msgpack, json, (char *) buffer, NULL);
+}
+
+size_t json_encode_msgpack_size(json_value_t *json)
+{
+    assert(json && "attempt to get the json msgpack size but json is a null pointer");
+
+    return json_emit_size(&json_emitter_msgpack, json);
+}
+
+void json_pool_init(json_pool_t *pool, void *memory, size_t capacity)
+{
+    assert(pool   && "attempt to init json pool but pool is a null pointer");
+    assert(memory && "attempt to init json pool but memory is a null pointer");
+
+    size_t padding = (JSON_NODE_ALIGNMENT - (uintptr_t) memory % JSON_NODE_ALIGNMENT) % JSON_NODE_ALIGNMENT;
+
+    if (padding > capacity) {
+        padding = capacity;
+    }
+
+    pool->memory   = (char *) memory + padding;
+    pool->capacity = capacity - padding;
+    pool->bottom   = 0;
+    pool->top      = pool->capacity & ~(size_t) (JSON_NODE_ALIGNMENT - 1);
+}
+
+json_parse_status_t json_parse(char *text, size_t length, json_pool_t *pool, json_value_t **json)
+{
+    assert(text && "attempt to parse json but text is a null pointer");
+    assert(pool && "attempt to parse json but pool is a null pointer");
+    assert(json && "attempt to parse json but json is a null pointer");
+
+    json_parser_t parser = {
+        .cursor = text,
+        .end    = text + length,
+        .pool   = pool,
+        .depth  = 0,
+        .status = JSON_PARSE_OK,
+    };
+
+    size_t        bottom = pool->bottom;
+    size_t        top    = pool->top;
+    json_value_t *root   = json_parse_value(&parser);
+
+    json_parser_skip_whitespace(&parser);
+
+    if (root != NULL && parser.cursor != parser.end) {
+        json_parser_fail(&parser, JSON_PARSE_ERROR_SYNTAX);
+    }
+
+    if (parser.status != JSON_PARSE_OK) {
+        pool->bottom = bottom;
+        pool->top    = top;
+        return parser.status;
+    }
+
+    *json = root;
+    return JSON_PARSE_OK;
+}
+
+void json_cursor_init(json_cursor_t *cursor, const char *text, size_t length)
+{
+    assert(cursor && "attempt to init json cursor but cursor is a null pointer");
+    assert(text   && "attempt to init json cursor but text is a null pointer");
+
+    cursor->position = json_skip_whitespace(text, text + length);
+    cursor->end      = text + length;
+}
+
+bool json_cursor_find_key(json_cursor_t *cursor, const char *key)
+{
+    assert(cursor && "attempt to find json key but cursor is a null pointer");
+    assert(key    && "attempt to find json key but key is a null pointer");
+
+    const char *position = json_skip_separator(cursor->position, cursor->end, '{');
+    size_t      length   = strlen(key);
+
+    if (position == NULL || (position < cursor->end && *position == '}')) {
+        return false;
+    }
+
+    while (position != NULL && position < cursor->end && *position == '"') {
+        const char *name = position + 1;
+
+        if ((position = json_skip_string(name, cursor->end)) == NULL) {
+            return false;
+        }
+
+        bool found = (size_t) (position - 1 - name) == length && memcmp(name, key, length) == 0;
+
+        if ((position = json_skip_separator(position, cursor->end, ':')) == NULL) {
+            return false;
+        }
+
+        if (found) {
+            cursor->position = position;
+            return true;
+        }
+
+        if ((position = json_skip_value(position, cursor->end)) == NULL) {
+            return false;
+        }
+
+        position = json_skip_separator(position, cursor->end, ',');
+    }
+
+    return false;
+}
+
+bool json_cursor_find_index(json_cursor_t *cursor, size_t index)
+{
+    assert(cursor && "attempt to find json index but cursor is a null pointer");
+
+    const char *position = json_skip_separator(cursor->position, cursor->end, '[');
+
+    if (position == NULL || (position < cursor->end && *position == ']')) {
+        return false;
+    }
+
+    for (size_t i = 0; i < index && position != NULL; i++) {
+        if ((position = json_skip_value(position, cursor->end)) == NULL) {
+            return false;
+        }
+
+        position = json_skip_separator(position, cursor->end, ',');
+    }
+
+    if (position == NULL || position == cursor->end) {
+        return false;
+    }
+
+    cursor->position = position;
+    return true;
+}
+
+bool json_cursor_get_int(const json_cursor_t *cursor, int64_t *integer)
+{
+    assert(cursor  && "attempt to get json int but cursor is a null pointer");
+    assert(integer && "attempt to get json int but integer is a null pointer");
+
+    bool        integral = false;
+    const char *end      = json_scan_number(cursor->position, cursor->end, &integral);
+
+    return end != NULL && integral && json_parse_integer(cursor->position, end, integer);
+}
+
+bool json_cursor_get_string(const json_cursor_t *cursor, char *buffer, size_t capacity)
+{
+    assert(cursor && "attempt to get json string but cursor is a null pointer");
+    assert(buffer && "attempt to get json string but buffer is a null pointer");
+
+    if (cursor->position == cursor->end || *cursor->position != '"') {
+        return false;
+    }
+
+    json_parser_t parser = {
+        .cursor = (char *) cursor->position + 1,
+        .end    = (char *) cursor->end,
+    };
+
+    char *output = buffer;
+
+    for (;;) {
+        const char *special = json_scan_string_special(parser.cursor, parser.end);
+        size_t      length  = (size_t) (special - parser.cursor);
+
+        if (special == parser.end || (size_t) (output - buffer) + length >= capacity) {
+            return false;
+        }
+
+        memcpy(output, parser.cursor, length);
+        output       += length;
+        parser.cursor = (char *) special + 1;
+
+        if (*special == '"') {
+            break;
+        }
+
+        char  sequence[4];
+        char *sequence_end = sequence;
+
+        if (*special != '\\' || !json_parser_unescape(&parser, &sequence_end)) {
+            return false;
+        }
+
+        if ((size_t) (output - buffer) + (size_t) (sequence_end - sequence) >= capacity) {
+            return false;
+        }
+
+        memcpy(output, sequence, (size_t) (sequence_end - sequence));
+        output += sequence_end - sequence;
+    }
+
+    *output = '\0';
+    return true;
+}
+
+bool json_cursor_get_value(const json_cursor_t *cursor, json_value_t *json, char *buffer, size_t capacity)
+{
+    assert(cursor && "attempt to get json value but cursor is a null pointer");
+    assert(json   && "attempt to get json value but json is a null pointer");
+
+    const char *position = cursor->position;
+    size_t      left     = (size_t) (cursor->end - position);
+    bool        integral = false;
+    const char *end      = json_scan_number(position, cursor->end, &integral);
+
+    if (end != NULL) {
+        if (integral && json_parse_integer(position, end, &json->as.integer)) {
+            json->type = JSON_VALUE_TYPE_INT;
+            return true;
+        }
+
+        json->type        = JSON_VALUE_TYPE_FLOAT;
+        json->as.floating = json_parse_double(position, end);
+        return true;
+    }
+
+    if (left >= strlen("null") && memcmp(position, "null", strlen("null")) == 0) {
+        json->type = JSON_VALUE_TYPE_NULL;
+        return true;
+    }
+
+    if (left >= strlen("true") && memcmp(position, "true", strlen("true")) == 0) {
+        json->type       = JSON_VALUE_TYPE_BOOL;
+        json->as.boolean = true;
+        return true;
+    }
+
+    if (left >= strlen("false") && memcmp(position, "false", strlen("false")) == 0) {
+        json->type       = JSON_VALUE_TYPE_BOOL;
+        json->as.boolean = false;
+        return true;
+    }
+
+    if (buffer != NULL && json_cursor_get_string(cursor, buffer, capacity)) {
+        json->type      = JSON_VALUE_TYPE_STRING;
+        json->as.string = buffer;
+        return true;
+    }
+
+    return false;
+}
+
+size_t json_clone_size(json_value_t *json)
+{
+    assert(json && "attempt to get the json clone size but json is a null pointer");
+
+    return json_clone_supported(json) ? json_clone_size_compute(json) : 0;
+}
+
+/*
+ Index is a flat open-addressing table with linear probing. Every slot
+ holds the upper half of the key hash and the property number plus one,
+ so mismatching keys are skipped without touching the properties.
+*/
+
+static uint64_t json_key_hash(const char *key, size_t length)
+{
+    uint64_t hash = UINT64_C(14695981039346656037);
+
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char) key[i]) * UINT64_C(1099511628211);
+    }
+
+    return hash;
+}
+
+static size_t json_object_index_slots(const json_object_t *object)
+{
+    size_t slots = JSON_INDEX_MIN_SLOTS;
+
+    while (slots < object->size * 2) {
+        slots *= 2;
+    }
+
+    return slots;
+}
+
+static bool json_key_equals(const char *key, const char *candidate, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        if (candidate[i] != key[i] || candidate[i] == '\0') {
+            return false;
+        }
+    }
+
+    return candidate[length] == '\0';
+}
+
+/* Returns the number of the first property with the key, the object size when there is none */
+static size_t json_object_find(const json_object_t *object, const char *key, size_t length)
+{
+    if (object->index == NULL) {
+        for (size_t i = 0; i < object->size; i++) {
+            if (json_key_equals(key, object->props[i]->key, length)) {
+                return i;
+            }
+        }
+
+        return object->size;
+    }
+
+    uint64_t hash = json_key_hash(key, length);
+    size_t   mask = json_object_index_slots(object) - 1;
+
+    for (size_t i = (size_t) hash & mask; object->index[i] != 0; i = (i + 1) & mask) {
+        size_t number = (size_t) (object->index[i] & ~JSON_INDEX_HASH_MASK) - 1;
+
+        if ((object->index[i] & JSON_INDEX_HASH_MASK) == (hash & JSON_INDEX_HASH_MASK) && json_key_equals(key, object->props[number]->key, length)) {
+            return number;
+        }
+    }
+
+    return object->size;
+}
+
+json_prop_t *json_object_get(json_value_t *json, const char *key, size_t length)
+{
+    assert(json && "attempt to get json property but json is a null pointer");
+    assert(key  && "attempt to get json property but key is a null pointer");
+    assert(json->type == JSON_VALUE_TYPE_OBJECT && "attempt to get json property but json is not an object");
+
+    size_t number = json_object_find(json->as.object, key, length);
+
+    return number != json->as.object->size ? json->as.object->props[number] : NULL;
+}
+
+size_t json_object_index_size(json_value_t *json)
+{
+    assert(json && "attempt to compute json index size but json is a null pointer");
+    assert(json->type == JSON_VALUE_TYPE_OBJECT && "attempt to compute json index size but json is not an object");
+
+    return json_object_index_slots(json->as.object) * sizeof(uint64_t);
+}
+
+void json_object_index_build(json_value_t *json, void *buffer)
+{
+    assert(json   && "attempt to build json index but json is a null pointer");
+    assert(buffer && "attempt to build json index but buffer is a null pointer");
+    assert(json->type == JSON_VALUE_TYPE_OBJECT && "attempt to build json index but json is not an object");
+
+    json_object_t *object = json->as.object;
+    uint64_t      *index  = buffer;
+    size_t         mask   = json_object_index_slots(object) - 1;
+
+    assert(object->size < UINT32_MAX && "attempt to build json index but object is too large");
+
+    memset(index, 0, (mask + 1) * sizeof(uint64_t));
+
+    /* Properties are inserted in order, so the first of duplicate keys is found first */
+    for (size_t i = 0; i < object->size; i++) {
+        const char *key  = object->props[i]->key;
+        uint64_t    hash = json_key_hash(key, strlen(key));
+        size_t      slot = (size_t) hash & mask;
+
+        while (index[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+
+        index[slot] = (hash & JSON_INDEX_HASH_MASK) | (uint64_t) (i + 1);
+    }
+
+    object->index = index;
+}
+
+/*
+ Diff walks both trees in step and pushes operations on the top of the pool
+ like the parser pushes entries. Nodes shared by both trees are skipped
+ without looking inside, so trees built by replacing a few nodes of the old
+ one are compared in time proportional to the replaced paths. A child path
+ is allocated before the child is compared and given back if the child
+ produced no operations.
+*/
+
+typedef struct json_diff_operation_t
+{
+    json_value_t  value;
+    json_object_t object;
+    json_prop_t  *props[3];
+    json_prop_t   op;
+    json_prop_t   path;
+    json_prop_t   entry;
+    json_value_t  name;
+    json_value_t  pointer;
+} json_diff_operation_t;
+
+typedef struct json_differ_t
+{
+    json_pool_t *pool;
+    bool         failed;
+} json_differ_t;
+
+static bool json_diff_equal(json_value_t *left, json_value_t *right)
+{
+    if (left == right) {
+        return true;
+    }
+
+    if (left->type != right->type) {
+        return false;
+    }
+
+    switch (left->type) {
+        case JSON_VALUE_TYPE_NULL:
+            return true;
+
+        case JSON_VALUE_TYPE_BOOL:
+            return left->as.boolean == right->as.boolean;
+
+        case JSON_VALUE_TYPE_INT:
+            return left->as.integer == right->as.integer;
+
+        case JSON_VALUE_TYPE_FLOAT:
+            /* Bitwise comparison keeps -0.0 and 0.0 apart since their text differs */
+            return memcmp(&left->as.floating, &right->as.floating, sizeof(double)) == 0;
+
+        case JSON_VALUE_TYPE_STRING:
+            return left->as.string == right->as.string || strcmp(left->as.string, right->as.string) == 0;
+
+        case JSON_VALUE_TYPE_ARRAY:
+            if (left->as.array == right->as.array) {
+                return true;
+            }
+
+            if (left->as.array->size != right->as.array->size) {
+                return false;
+            }
+
+            for (size_t i = 0; i < left->as.array->size; i++) {
+                if (!json_diff_equal(left->as.array->entries[i], right->as.array->entries[i])) {
+                    return false;
+                }
+            }
+
+            return true;
+
+        case JSON_VALUE_TYPE_OBJECT:
+            if (left->as.object == right->as.object) {
+                return true;
+            }
+
+            if (left->as.object->size != right->as.object->size) {
+                return false;
+            }
+
+            for (size_t i = 0; i < left->as.object->size; i++) {
+                json_prop_t *property = left->as.object->props[i];
+                json_prop_t *other    = json_object_get(right, property->key, strlen(property->key));
+
+                if (other == NULL || !json_diff_equal(property->entry, other->entry)) {
+                    return false;
+                }
+            }
+
+            return true;
+
+        case JSON_VALUE_TYPE_PADDED:
+            return left->as.padded == right->as.padded;
+
+        case JSON_VALUE_TYPE_SNAPSHOT:
+            return left->as.snapshot == right->as.snapshot;
+
+        case JSON_VALUE_TYPE_ARRAY_GENERATOR:
+            return left->as.array_generator == right->as.array_generator;
+
+        case JSON_VALUE_TYPE_OBJECT_GENERATOR:
+            return left->as.object_generator == right->as.object_generator;
+
+        case JSON_VALUE_TYPE_TABLE:
+            return left->as.table == right->as.table;
+
+        case JSON_VALUE_TYPE_COMPACT:
+            return left->as.compact == right->as.compact;
+
+        case JSON_VALUE_TYPE_BASE64:
+            return left->as.base64 == right->as.base64;
+
+        case JSON_VALUE_TYPE_OVERLAY:
+            return left->as.overlay == right->as.overlay;
+
+        case JSON_VALUE_TYPE_PROJECTION:
+            return left->as.projection == right->as.projection;
+
+        default:
+            assert(false && "attempt to diff json but it contains a value of unknown type");
+            return false;
+    }
+}
+
+static void json_diff_push(json_differ_t *differ, const char *op, const char *path, json_value_t *json)
+{
+    if (differ->failed) {
+        return;
+    }
+
+    json_diff_operation_t *operation = json_pool_alloc(differ->pool, sizeof(json_diff_operation_t));
+
+    if (operation == NULL || !json_pool_push(differ->pool, &operation->value)) {
+        differ->failed = true;
+        return;
+    }
+
+    operation->name     = (json_value_t) { .type = JSON_VALUE_TYPE_STRING, .as.string = op };
+    operation->pointer  = (json_value_t) { .type = JSON_VALUE_TYPE_STRING, .as.string = path };
+    operation->op       = (json_prop_t) { .key = "op",    .entry = &operation->name };
+    operation->path     = (json_prop_t) { .key = "path",  .entry = &operation->pointer };
+    operation->entry    = (json_prop_t) { .key = "value", .entry = json };
+    operation->props[0] = &operation->op;
+    operation->props[1] = &operation->path;
+    operation->props[2] = &operation->entry;
+    operation->object   = (json_object_t) { .size = json != NULL ? 3 : 2, .props = operation->props, .index = NULL };
+    operation->value    = (json_value_t) { .type = JSON_VALUE_TYPE_OBJECT, .as.object = &operation->object };
+}
+
+/* Json pointer tokens escape `~` as `~0` and `/` as `~1` */
+static char *json_diff_path(json_differ_t *differ, const char *parent, const char *key, size_t index)
+{
+    char   digits[24];
+    size_t length = strlen(parent) + 1;
+
+    if (key == NULL) {
+        *json_int_text_write(digits, (int64_t) index) = '\0';
+        key = digits;
+    }
+
+    for (const char *character = key; *character != '\0'; character++) {
+        length += *character == '~' || *character == '/' ? 2 : 1;
+    }
+
+    char *path = json_pool_alloc(differ->pool, length + 1);
+
+    if (path == NULL) {
+        differ->failed = true;
+        return NULL;
+    }
+
+    char *cursor = path + strlen(parent);
+
+    memcpy(path, parent, (size_t) (cursor - path));
+    *cursor++ = '/';
+
+    for (const char *character = key; *character != '\0'; character++) {
+        if (*character == '~' || *character == '/') {
+            *cursor++ = '~';
+            *cursor++ = *character == '~' ? '0' : '1';
+        } else {
+            *cursor++ = *character;
+        }
+    }
+
+    *cursor = '\0';
+    return path;
+}
+
+static void json_diff_value(json_differ_t *differ, json_value_t *from, json_value_t *to, const char *path);
+
+static void json_diff_child(json_differ_t *differ, json_value_t *from, json_value_t *to, const char *parent, const char *key, size_t index)
+{
+    if (from == to || differ->failed) {
+        return;
+    }
+
+    size_t bottom = differ->pool->bottom;
+    size_t top    = differ->pool->top;
+    char  *path   = json_diff_path(differ, parent, key, index);
+
+    if (path == NULL) {
+        return;
+    }
+
+    json_diff_value(differ, from, to, path);
+
+    if (!differ->failed && differ->pool->top == top) {
+        differ->pool->bottom = bottom;
+    }
+}
+
+static void json_diff_object(json_differ_t *differ, json_value_t *from, json_value_t *to, const char *path)
+{
+    json_object_t *before = from->as.object;
+    json_object_t *after  = to->as.object;
+
+    for (size_t i = 0; i < before->size && !differ->failed; i++) {
+        json_prop_t *property = before->props[i];
+        json_prop_t *other    = json_object_get(to, property->key, strlen(property->key));
+
+        if (other == NULL) {
+            json_diff_push(differ, "remove", json_diff_path(differ, path, property->key, 0), NULL);
+        } else {
+            json_diff_child(differ, property->entry, other->entry, path, property->key, 0);
+        }
+    }
+
+    for (size_t i = 0; i < after->size && !differ->failed; i++) {
+        json_prop_t *property = after->props[i];
+
+        if (json_object_get(from, property->key, strlen(property->key)) == NULL) {
+            json_diff_push(differ, "add", json_diff_path(differ, path, property->key, 0), property->entry);
+        }
+    }
+}
+
+/*
+ Arrays keep their common prefix and suffix, entries in between are diffed
+ pairwise and the rest is added before the suffix or removed at the same
+ index, so one inserted or removed entry produces one operation.
+*/
+
+static void json_diff_array(json_differ_t *differ, json_value_t *from, json_value_t *to, const char *path)
+{
+    json_array_t *before = from->as.array;
+    json_array_t *after  = to->as.array;
+    size_t        prefix = 0;
+    size_t        suffix = 0;
+
+    while (prefix < before->size && prefix < after->size && json_diff_equal(before->entries[prefix], after->entries[prefix])) {
+        prefix++;
+    }
+
+    while (suffix < before->size - prefix && suffix < after->size - prefix &&
+           json_diff_equal(before->entries[before->size - 1 - suffix], after->entries[after->size - 1 - suffix])) {
+        suffix++;
+    }
+
+    size_t removed = before->size - prefix - suffix;
+    size_t added   = after->size - prefix - suffix;
+    size_t common  = removed < added ? removed : added;
+
+    for (size_t i = prefix; i < prefix + common; i++) {
+        json_diff_child(differ, before->entries[i], after->entries[i], path, NULL, i);
+    }
+
+    for (size_t i = prefix + common; i < prefix + added && !differ->failed; i++) {
+        json_diff_push(differ, "add", json_diff_path(differ, path, NULL, i), after->entries[i]);
+    }
+
+    for (size_t i = prefix + common; i < prefix + removed && !differ->failed; i++) {
+        json_diff_push(differ, "remove", json_diff_path(differ, path, NULL, prefix + common), NULL);
+    }
+}
+
+static void json_diff_value(json_differ_t *differ, json_value_t *from, json_value_t *to, const char *path)
+{
+    if (from->type == JSON_VALUE_TYPE_OBJECT && to->type == JSON_VALUE_TYPE_OBJECT) {
+        if (from->as.object != to->as.object) {
+            json_diff_object(differ, from, to, path);
+        }
+    } else if (from->type == JSON_VALUE_TYPE_ARRAY && to->type == JSON_VALUE_TYPE_ARRAY) {
+        if (from->as.array != to->as.array) {
+            json_diff_array(differ, from, to, path);
+        }
+    } else if (!json_diff_equal(from, to)) {
+        json_diff_push(differ, "replace", path, to);
+    }
+}
+
+bool json_diff(json_value_t *from, json_value_t *to, json_pool_t *pool, json_value_t **patch)
+{
+    assert(from  && "attempt to diff json but old json is a null pointer");
+    assert(to    && "attempt to diff json but new json is a null pointer");
+    assert(pool  && "attempt to diff json but pool is a null pointer");
+    assert(patch && "attempt to diff json but patch is a null pointer");
+
+    json_differ_t differ = {
+        .pool   = pool,
+        .failed = false,
+    };
+
+    size_t bottom = pool->bottom;
+    size_t top    = pool->top;
+
+    json_diff_value(&differ, from, to, "");
+
+    size_t        count = (top - pool->top) / sizeof(void *);
+    json_value_t *root  = differ.failed ? NULL : json_pool_alloc(pool, sizeof(json_value_t) + sizeof(json_array_t));
+    void        **array = root != NULL ? json_pool_pop_into_array(pool, top, count) : NULL;
+
+    if (root == NULL || (array == NULL && count != 0)) {
+        pool->bottom = bottom;
+        pool->top    = top;
+        return false;
+    }
+
+    json_array_t *operations = (json_array_t *) (root + 1);
+
+    operations->size    = count;
+    operations->entries = (json_value_t **) array;
+    root->type          = JSON_VALUE_TYPE_ARRAY;
+    root->as.array      = operations;
+
+    *patch = root;
+    return true;
+}
+
+/*
+ Projection walks the selected properties only, excluded subtrees are
+ never visited. Selected values with a partial mask are wrapped into
+ temporary projection nodes, whole ones are serialized as they are.
+*/
+
+static const json_mask_t *json_mask_find(const json_mask_t *mask, const char *key)
+{
+    for (const json_mask_t *child = mask->children; child != NULL; child = child->next) {
+        if (json_key_equals(child->key, key, child->length)) {
+            return child;
+        }
+    }
+
+    return NULL;
+}
+
+static json_value_t *json_projection_wrap(json_value_t *json, const json_mask_t *mask, json_value_t *node)
+{
+    if (mask->whole) {
+        return json;
+    }
+
+    node->as.projection->json = json;
+    node->as.projection->mask = mask;
+
+    return node;
+}
+
+/* Returns the next selected property of an object or an overlay */
+static json_prop_t *json_projection_next(json_overlay_walk_t *walk, const json_mask_t *mask, const json_mask_t **selected)
+{
+    for (;;) {
+        json_prop_t *property = json_overlay_next(walk);
+
+        if (property == NULL || (*selected = json_mask_find(mask, property->key)) != NULL) {
+            return property;
+        }
+    }
+}
+
+static size_t json_projection_count(json_value_t *json, const json_mask_t *mask)
+{
+    const json_mask_t  *selected = NULL;
+    json_overlay_walk_t walk;
+    size_t              count    = 0;
+
+    json_overlay_walk_init(&walk, json);
+
+    while (json_projection_next(&walk, mask, &selected) != NULL) {
+        count++;
+    }
+
+    return count;
+}
+
+static size_t json_projection_columns_count(const json_table_t *table, const json_mask_t *mask)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < table->columns; i++) {
+        count += json_mask_find(mask, table->keys[i]) != NULL;
+    }
+
+    return count;
+}
+
+static void json_size_compute_func_for_projection(json_value_t *json, json_size_context_t *context)
+{
+    json_value_t      *target     = json->as.projection->json;
+    const json_mask_t *mask       = json->as.projection->mask;
+    json_projection_t  projection = { .json = NULL, .mask = NULL };
+    json_value_t       node       = { .type = JSON_VALUE_TYPE_PROJECTION, .as.projection = &projection };
+
+    switch (target->type) {
+    case JSON_VALUE_TYPE_OBJECT:
+    case JSON_VALUE_TYPE_OVERLAY: {
+        const json_mask_t  *selected = NULL;
+        json_prop_t        *property = NULL;
+        json_overlay_walk_t walk;
+        size_t              count    = 0;
+
+        json_overlay_walk_init(&walk, target);
+
+        while ((property = json_projection_next(&walk, mask, &selected)) != NULL) {
+            context->emitter->size_key(context, property->key);
+            json_size_compute(json_projection_wrap(property->entry, selected, &node), context);
+            count++;
+        }
+
+        context->emitter->size_frame(context, JSON_VALUE_TYPE_OBJECT, count);
+        break;
+    }
+    case JSON_VALUE_TYPE_ARRAY:
+        for (size_t i = 0; i < target->as.array->size; i++) {
+            json_size_compute(json_projection_wrap(target->as.array->entries[i], mask, &node), context);
+        }
+
+        context->emitter->size_frame(context, JSON_VALUE_TYPE_ARRAY, target->as.array->size);
+        break;
+    case JSON_VALUE_TYPE_TABLE: {
+        json_table_t *table   = target->as.table;
+        size_t        columns = json_projection_columns_count(table, mask);
+
+        context->emitter->size_frame(context, JSON_VALUE_TYPE_ARRAY, table->rows);
+
+        for (size_t row = 0; row < table->rows; row++) {
+            context->emitter->size_frame(context, JSON_VALUE_TYPE_OBJECT, columns);
+
+            for (size_t column = 0; column < table->columns; column++) {
+                const json_mask_t *selected = json_mask_find(mask, table->keys[column]);
+
+                if (selected != NULL) {
+                    context->emitter->size_key(context, table->keys[column]);
+                    json_size_compute(json_projection_wrap(&table->values[column * table->rows + row], selected, &node), context);
+                }
+            }
+        }
+        break;
+    }
+    default:
+        json_size_compute(target, context);
+        break;
+    }
+}
+
+static void json_write_func_for_projection(json_value_t *json, json_write_context_t *context)
+{
+    json_value_t      *target     = json->as.projection->json;
+    const json_mask_t *mask       = json->as.projection->mask;
+    json_projection_t  projection = { .json = NULL, .mask = NULL };
+    json_value_t       node       = { .type = JSON_VALUE_TYPE_PROJECTION, .as.projection = &projection };
+
+    switch (target->type) {
+    case JSON_VALUE_TYPE_OBJECT:
+    case JSON_VALUE_TYPE_OVERLAY: {
+        const json_mask_t  *selected = NULL;
+        json_prop_t        *property = NULL;
+        json_overlay_walk_t walk;
+        size_t              count    = 0;
+
+        context->emitter->write_begin(context, JSON_VALUE_TYPE_OBJECT,
+                                      context->emitter->write_begin_needs_count ? json_projection_count(target, mask) : 0);
+        json_overlay_walk_init(&walk, target);
+
+        while ((property = json_projection_next(&walk, mask, &selected)) != NULL) {
+            context->emitter->write_separator(context, JSON_VALUE_TYPE_OBJECT, count);
+            context->emitter->write_key(context, property->key);
+            json_write(json_projection_wrap(property->entry, selected, &node), context);
+            count++;
+        }
+
+        context->emitter->write_end(context, JSON_VALUE_TYPE_OBJECT, count);
+        break;
+    }
+    case JSON_VALUE_TYPE_ARRAY:
+        context->emitter->write_begin(context, JSON_VALUE_TYPE_ARRAY, target->as.array->size);
+
+        for (size_t i = 0; i < target->as.array->size; i++) {
+            context->emitter->write_separator(context, JSON_VALUE_TYPE_ARRAY, i);
+            json_write(json_projection_wrap(target->as.array->entries[i], mask, &node), context);
+        }
+
+        context->emitter->write_end(context, JSON_VALUE_TYPE_ARRAY, target->as.array->size);
+        break;
+    case JSON_VALUE_TYPE_TABLE: {
+        json_table_t *table   = target->as.table;
+        size_t        columns = json_projection_columns_count(table, mask);
+
+        context->emitter->write_begin(context, JSON_VALUE_TYPE_ARRAY, table->rows);
+
+        for (size_t row = 0; row < table->rows; row++) {
+            size_t count = 0;
+
+            context->emitter->write_separator(context, JSON_VALUE_TYPE_ARRAY, row);
+            context->emitter->write_begin(context, JSON_VALUE_TYPE_OBJECT, columns);
+
+            for (size_t column = 0; column < table->columns; column++) {
+                const json_mask_t *selected = json_mask_find(mask, table->keys[column]);
+
+                if (selected != NULL) {
+                    context->emitter->write_separator(context, JSON_VALUE_TYPE_OBJECT, count++);
+                    context->emitter->write_key(context, table->keys[column]);
+                    json_write(json_projection_wrap(&table->values[column * table->rows + row], selected, &node), context);
+                }
+            }
+
+            context->emitter->write_end(context, JSON_VALUE_TYPE_OBJECT, columns);
+        }
+
+        context->emitter->write_end(context, JSON_VALUE_TYPE_ARRAY, table->rows);
+        break;
+    }
+    default:
+        json_write(target, context);
+        break;
+    }
+}
+
+static size_t json_projection_slots_count(json_value_t *json, const json_mask_t *mask)
+{
+    size_t count = 0;
+
+    if (mask->whole) {
+        return json_slots_count(json);
+    }
+
+    switch (json->type) {
+    case JSON_VALUE_TYPE_OBJECT:
+    case JSON_VALUE_TYPE_OVERLAY: {
+        const json_mask_t  *selected = NULL;
+        json_prop_t        *property = NULL;
+        json_overlay_walk_t walk;
+
+        json_overlay_walk_init(&walk, json);
+
+        while ((property = json_projection_next(&walk, mask, &selected)) != NULL) {
+            count += json_projection_slots_count(property->entry, selected);
+        }
+        break;
+    }
+    case JSON_VALUE_TYPE_ARRAY:
+        for (size_t i = 0; i < json->as.array->size; i++) {
+            count += json_projection_slots_count(json->as.array->entries[i], mask);
+        }
+        break;
+    case JSON_VALUE_TYPE_TABLE:
+        for (size_t column = 0; column < json->as.table->columns; column++) {
+            const json_mask_t *selected = json_mask_find(mask, json->as.table->keys[column]);
+
+            for (size_t row = 0; selected != NULL && row < json->as.table->rows; row++) {
+                count += json_projection_slots_count(&json->as.table->values[column * json->as.table->rows + row], selected);
+            }
+        }
+        break;
+    default:
+        count += json_slots_count(json);
+        break;
+    }
+
+    return count;
+}
+
+char *json_stringify_projected(json_value_t *json, const json_mask_t *mask)
+{
+    assert(json && "attempt to stringify projected json but json is a null pointer");
+    assert(mask && "attempt to stringify projected json but mask is a null pointer");
+
+    return json_stringify(JsonProjection(json, mask));
+}
+
+size_t json_mask_nodes_count(const char *fields)
+{
+    assert(fields && "attempt to count json mask nodes but fields is a null pointer");
+
+    size_t count = 2;
+
+    for (const char *cursor = fields; *cursor != '\0'; cursor++) {
+        count += *cursor == ',' || *cursor == '.';
+    }
+
+    return count;
+}
+
+bool json_mask_compile(const char *fields, json_mask_t *nodes, size_t capacity)
+{
+    assert(fields && "attempt to compile json mask but fields is a null pointer");
+    assert(nodes  && "attempt to compile json mask but nodes is a null pointer");
+
+    size_t used = 1;
+
+    if (capacity == 0) {
+        return false;
+    }
+
+    nodes[0] = (json_mask_t) { .key = NULL, .length = 0, .whole = false, .children = NULL, .next = NULL };
+
+    if (*fields == '\0') {
+        return true;
+    }
+
+    for (const char *cursor = fields; ; cursor++) {
+        json_mask_t *parent = &nodes[0];
+
+        /* Every path descends from the root, existing nodes are shared */
+        for (;; cursor++) {
+            size_t       length = strcspn(cursor, ",.");
+            json_mask_t *child  = parent->children;
+
+            if (length == 0) {
+                return false;
+            }
+
+            while (child != NULL && (child->length != length || memcmp(child->key, cursor, length) != 0)) {
+                child = child->next;
+            }
+
+            if (child == NULL) {
+                if (used == capacity) {
+                    return false;
+                }
+
+                child  = &nodes[used++];
+                *child = (json_mask_t) { .key = cursor, .length = length, .whole = false, .children = NULL, .next = parent->children };
+
+                parent->children = child;
+            }
+
+            parent  = child;
+            cursor += length;
+
+            if (*cursor != '.') {
+                break;
+            }
+        }
+
+        /* A path selects the whole value, deeper paths under it change nothing */
+        parent->whole = true;
+
+        if (*cursor == '\0') {
+            return true;
+        }
+    }
+}
+
+json_value_t *json_clone_into(json_value_t *json, void *buffer)
+{
+    assert(json   && "attempt to clone json but json is a null pointer");
+    assert(buffer && "attempt to clone json but buffer is a null pointer");
+    assert((uintptr_t) buffer % JSON_NODE_ALIGNMENT == 0 && "attempt to clone json but buffer is not aligned");
+
+    if (!json_clone_supported(json)) {
+        return NULL;
+    }
+
+    char *cursor = buffer;
+    return json_clone_node(json, &cursor);
+}
+
+size_t json_snapshot_size(json_value_t *json)
+{
+    assert(json && "attempt to get the json snapshot size but json is a null pointer");
+
+    return sizeof(json_snapshot_t) + json_snapshot_records_size(json);
+}
+
+void json_snapshot_write(json_value_t *json, void *buffer)
+{
+    assert(json   && "attempt to save json snapshot but json is a null pointer");
+    assert(buffer && "attempt to save json snapshot but buffer is a null pointer");
+    assert((uintptr_t) buffer % JSON_NODE_ALIGNMENT == 0 && "attempt to save json snapshot but buffer is not aligned");
+
+    json_snapshot_t *snapshot = buffer;
+    size_t           offset   = sizeof(json_snapshot_t);
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    memcpy(snapshot->magic, JSON_SNAPSHOT_MAGIC, sizeof(JSON_SNAPSHOT_MAGIC));
+
+    snapshot->version    = JSON_SNAPSHOT_VERSION;
+    snapshot->byte_order = JSON_SNAPSHOT_BYTE_ORDER;
+
+    json_snapshot_write_records(json, &snapshot->root, buffer, &offset);
+    snapshot->size = offset;
+}
+
+bool json_snapshot_view(const void *data, size_t size, json_value_t *json)
+{
+    assert(data && "attempt to view json snapshot but data is a null pointer");
+    assert(json && "attempt to view json snapshot but json is a null pointer");
+
+    const json_snapshot_t *snapshot = data;
+
+    if (size < sizeof(json_snapshot_t) || (uintptr_t) data % JSON_NODE_ALIGNMENT != 0) {
+        return false;
+    }
+
+    if (memcmp(snapshot->magic, JSON_SNAPSHOT_MAGIC, sizeof(JSON_SNAPSHOT_MAGIC)) != 0 ||
+        snapshot->version    != JSON_SNAPSHOT_VERSION ||
+        snapshot->byte_order != JSON_SNAPSHOT_BYTE_ORDER ||
+        snapshot->size       != size) {
+        return false;
+    }
+
+    json->type        = JSON_VALUE_TYPE_SNAPSHOT;
+    json->as.snapshot = snapshot;
 
-    return json_size_compute(json) + 1;
+    return true;
 }
@@ -21,20 +21,60 @@
     #define STATIC_JSON_BUILDER_EXPORT
 #endif
 
+#include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 struct json_prop_t;
 struct json_object_t;
 struct json_array_t;
+struct json_padded_int_t;
 struct json_value_t;
+struct json_slot_t;
+struct json_pool_t;
+struct json_cursor_t;
+struct json_snapshot_t;
+struct json_array_generator_t;
+struct json_object_generator_t;
+struct json_table_t;
+struct json_base64_t;
+struct json_overlay_t;
+struct json_mask_t;
+struct json_projection_t;
+struct json_log_t;
 
-typedef struct json_prop_t   json_prop_t;
-typedef struct json_object_t json_object_t;
-typedef struct json_array_t  json_array_t;
-typedef struct json_value_t  json_value_t;
-typedef        json_value_t* Json;
+typedef struct json_prop_t             json_prop_t;
+typedef struct json_object_t           json_object_t;
+typedef struct json_array_t            json_array_t;
+typedef struct json_padded_int_t       json_padded_int_t;
+typedef struct json_value_t            json_value_t;
+typedef struct json_slot_t             json_slot_t;
+typedef struct json_pool_t             json_pool_t;
+typedef struct json_cursor_t           json_cursor_t;
+typedef struct json_snapshot_t         json_snapshot_t;
+typedef struct json_array_generator_t  json_array_generator_t;
+typedef struct json_object_generator_t json_object_generator_t;
+typedef struct json_table_t            json_table_t;
+typedef struct json_base64_t           json_base64_t;
+typedef struct json_overlay_t          json_overlay_t;
+typedef struct json_mask_t             json_mask_t;
+typedef struct json_projection_t       json_projection_t;
+typedef struct json_log_t              json_log_t;
+typedef        json_value_t*           Json;
+typedef        uint64_t                json_compact_t;
+
+/*
+ Generators produce entries while the json is serialized. Every pass over
+ the json pulls entries from index 0 until the function returns false,
+ so a generator must produce the same entries for the same indexes.
+ Entries are written into one scratch node which is reused for all of them,
+ the object generator sets `property->key` and fills `property->entry`.
+*/
+
+typedef bool (*json_array_next_func_t)  (void *context, size_t index, json_value_t *entry);
+typedef bool (*json_object_next_func_t) (void *context, size_t index, json_prop_t  *property);
 
 typedef enum json_value_type_t
 {
@@ -45,13 +85,28 @@ typedef enum json_value_type_t
     JSON_VALUE_TYPE_STRING,
     JSON_VALUE_TYPE_ARRAY,
     JSON_VALUE_TYPE_OBJECT,
+    JSON_VALUE_TYPE_PADDED,
+    JSON_VALUE_TYPE_SNAPSHOT,
+    JSON_VALUE_TYPE_ARRAY_GENERATOR,
+    JSON_VALUE_TYPE_OBJECT_GENERATOR,
+    JSON_VALUE_TYPE_TABLE,
+    JSON_VALUE_TYPE_COMPACT,
+    JSON_VALUE_TYPE_BASE64,
+    JSON_VALUE_TYPE_OVERLAY,
+    JSON_VALUE_TYPE_PROJECTION,
     JSON_VALUE_TYPE_MAX,
 } json_value_type_t;
 
+/*
+ Objects may carry a hash index of their keys built by
+ `json_object_index_build(...)`, it is NULL otherwise.
+*/
+
 struct json_object_t
 {
-    size_t        size;
-    json_prop_t **props;
+    size_t          size;
+    json_prop_t   **props;
+    const uint64_t *index;
 };
 
 struct json_array_t
@@ -60,17 +115,127 @@ struct json_array_t
     json_value_t **entries;
 };
 
+/*
+ Options of the string representation. Strings and keys are copied as they
+ are by default; validation rejects jsons with strings which are not valid
+ UTF-8, escaping writes every non-ASCII character as `\uXXXX` and implies
+ validation.
+*/
+
+typedef enum json_stringify_option_t
+{
+    JSON_STRINGIFY_VALIDATE_UTF8    = 1 << 0,
+    JSON_STRINGIFY_ESCAPE_NON_ASCII = 1 << 1,
+} json_stringify_option_t;
+
+typedef enum json_parse_status_t
+{
+    JSON_PARSE_OK = 0,
+    JSON_PARSE_ERROR_SYNTAX,
+    JSON_PARSE_ERROR_DEPTH,
+    JSON_PARSE_ERROR_POOL_EXHAUSTED,
+    JSON_PARSE_ERROR_NUL_CHARACTER,
+} json_parse_status_t;
+
+struct json_padded_int_t
+{
+    int64_t integer;
+    size_t  width;
+};
+
+struct json_array_generator_t
+{
+    json_array_next_func_t next;
+    void                  *context;
+};
+
+struct json_object_generator_t
+{
+    json_object_next_func_t next;
+    void                   *context;
+};
+
+/*
+ Table is an array of objects with the same keys. Values are stored by
+ columns: the value of column `c` in row `r` is `values[c * rows + r]`.
+*/
+
+struct json_table_t
+{
+    const char *const *keys;
+    json_value_t      *values;
+    size_t             columns;
+    size_t             rows;
+};
+
+struct json_base64_t
+{
+    const void *data;
+    size_t      size;
+};
+
+/*
+ Overlay is the object `base` with the properties of the object `patch`:
+ base properties keep their order, those the patch overrides take the patch
+ value in place, and the patch properties new to the base follow in their
+ order. Neither object is copied or modified.
+*/
+
+struct json_overlay_t
+{
+    json_value_t *base;
+    json_value_t *patch;
+};
+
+/*
+ Field mask is a trie of the selected field paths compiled by
+ `json_mask_compile(...)`. The root and every inner node list the selected
+ keys in `children`, a `whole` node selects its value with all the nested
+ fields. Arrays take the mask of their parent, so `items.id` selects `id`
+ of every object in the `items` array.
+*/
+
+struct json_mask_t
+{
+    const char  *key;
+    size_t       length;
+    bool         whole;
+    json_mask_t *children;
+    json_mask_t *next;
+};
+
+/*
+ Projection serializes only the fields of `json` selected by `mask`.
+ Objects, overlays, arrays and tables are filtered, other nodes are
+ serialized whole.
+*/
+
+struct json_projection_t
+{
+    json_value_t      *json;
+    const json_mask_t *mask;
+};
+
 struct json_value_t
 {
     json_value_type_t type;
     union
     {
-        bool           boolean;
-        int64_t        integer;
-        double         floating;
-        const char    *string;
-        json_object_t *object;
-        json_array_t  *array;
+        bool                     boolean;
+        int64_t                  integer;
+        double                   floating;
+        const char              *string;
+        json_object_t           *object;
+        json_array_t            *array;
+        json_padded_int_t       *padded;
+        const json_snapshot_t   *snapshot;
+        json_array_generator_t  *array_generator;
+        json_object_generator_t *object_generator;
+        json_table_t            *table;
+        json_compact_t           compact;
+        json_base64_t           *base64;
+        json_overlay_t          *overlay;
+        json_projection_t       *projection;
     } as;
 };
 
@@ -80,6 +245,37 @@ struct json_prop_t
     json_value_t *entry;
 };
 
+struct json_slot_t
+{
+    size_t offset;
+    size_t width;
+};
+
+/*
+ Caller-provided memory for parsed json trees. Nodes are allocated
+ from the bottom, temporary entries of unfinished containers are kept
+ at the top, so parsing never touches the heap.
+*/
+
+struct json_pool_t
+{
+    char   *memory;
+    size_t  capacity;
+    size_t  bottom;
+    size_t  top;
+};
+
+/*
+ Lazy read-only position inside json text. Lookups skip whole subtrees
+ by scanning for brackets and quotes without building any nodes.
+*/
+
+struct json_cursor_t
+{
+    const char *position;
+    const char *end;
+};
+
 #define JsonNull() (                  \
     &(json_value_t) {                 \
         .type = JSON_VALUE_TYPE_NULL, \
@@ -114,6 +310,89 @@ struct json_prop_t
     }                                    \
 )
 
+/*
+ Integer rendered right-aligned in a field of at least `w` characters.
+ Leading spaces are insignificant whitespace, so the output stays valid json
+ and the value can later be rewritten in place with `json_patch_slot(...)`.
+*/
+
+#define JsonPaddedInt(i,w) (                   \
+    &(json_value_t) {                          \
+        .type = JSON_VALUE_TYPE_PADDED,        \
+        .as.padded = &(json_padded_int_t) {    \
+            .integer = (i),                    \
+            .width   = (w),                    \
+        }                                      \
+    }                                          \
+)
+
+/*
+ Binary data rendered as a base64 string. The data is encoded straight
+ into the output while the json is serialized.
+*/
+
+#define JsonBase64(p,n) (                      \
+    &(json_value_t) {                          \
+        .type = JSON_VALUE_TYPE_BASE64,        \
+        .as.base64 = &(json_base64_t) {        \
+            .data = (const void *) (p),        \
+            .size = (n),                       \
+        }                                      \
+    }                                          \
+)
+
+#define JsonOverlay(b,p) (                     \
+    &(json_value_t) {                          \
+        .type = JSON_VALUE_TYPE_OVERLAY,       \
+        .as.overlay = &(json_overlay_t) {      \
+            .base  = (b),                      \
+            .patch = (p),                      \
+        }                                      \
+    }                                          \
+)
+
+#define JsonProjection(j,m) (                   \
+    &(json_value_t) {                           \
+        .type = JSON_VALUE_TYPE_PROJECTION,     \
+        .as.projection = &(json_projection_t) { \
+            .json = (j),                        \
+            .mask = (m),                        \
+        }                                       \
+    }                                           \
+)
+
+#define JsonArrayGenerator(n,c) (                          \
+    &(json_value_t) {                                      \
+        .type = JSON_VALUE_TYPE_ARRAY_GENERATOR,           \
+        .as.array_generator = &(json_array_generator_t) {  \
+            .next    = (n),                                \
+            .context = (c),                                \
+        }                                                  \
+    }                                                      \
+)
+
+#define JsonObjectGenerator(n,c) (                           \
+    &(json_value_t) {                                        \
+        .type = JSON_VALUE_TYPE_OBJECT_GENERATOR,            \
+        .as.object_generator = &(json_object_generator_t) {  \
+            .next    = (n),                                  \
+            .context = (c),                                  \
+        }                                                    \
+    }                                                        \
+)
+
+#define JsonTable(k,v,c,r) (                       \
+    &(json_value_t) {                              \
+        .type = JSON_VALUE_TYPE_TABLE,             \
+        .as.table = &(json_table_t) {              \
+            .keys    = (const char *const *) (k),  \
+            .values  = (v),                        \
+            .columns = (c),                        \
+            .rows    = (r),                        \
+        }                                          \
+    }                                              \
+)
+
 #define JsonProp(k,e) (            \
     &(json_prop_t) {               \
         .key = (const char *) (k), \
@@ -154,6 +433,94 @@ struct json_prop_t
     }                                                                                      \
 )
 
+/*
+ Compact value packs the type and the payload into one 8-byte word. Numbers
+ are stored as doubles unless they are NaN, all other values are negative
+ quiet NaNs with the tag in bits 48-50 and the payload in the low 48 bits:
+ a boolean, an integer of 48 bits or a pointer. Wider integers point to
+ their value. Containers point to one block of words, the first word is the
+ count followed by the entries, or by key and value pairs for objects.
+ A compact tree is serialized through a `JsonCompact(c)` node.
+
+ Pointers are kept in 48 bits, so compact values need user-space addresses
+ below 2^48: x86-64 and AArch64 with 4-level paging, 48-bit virtual
+ addresses and no pointer tagging (e.g. AArch64 TBI or ARM MTE). Debug
+ builds assert that every boxed pointer fits.
+*/
+
+typedef enum json_compact_tag_t
+{
+    JSON_COMPACT_TAG_NULL = 0,
+    JSON_COMPACT_TAG_BOOL,
+    JSON_COMPACT_TAG_INT,
+    JSON_COMPACT_TAG_BIG_INT,
+    JSON_COMPACT_TAG_STRING,
+    JSON_COMPACT_TAG_ARRAY,
+    JSON_COMPACT_TAG_OBJECT,
+} json_compact_tag_t;
+
+#define JSON_COMPACT_BOX          UINT64_C(0xFFF8000000000000)
+#define JSON_COMPACT_TAG_SHIFT    48
+#define JSON_COMPACT_PAYLOAD_MASK UINT64_C(0x0000FFFFFFFFFFFF)
+#define JSON_COMPACT_INT_MIN      (-INT64_C(0x800000000000))
+#define JSON_COMPACT_INT_MAX      INT64_C(0x7FFFFFFFFFFF)
+
+static inline json_compact_t json_compact_box(json_compact_tag_t tag, uint64_t payload)
+{
+    /* Integers are truncated to 48 bits on purpose, pointers must survive the mask unchanged */
+    assert(tag < JSON_COMPACT_TAG_BIG_INT || (payload & ~JSON_COMPACT_PAYLOAD_MASK) == 0);
+
+    return JSON_COMPACT_BOX | (uint64_t) tag << JSON_COMPACT_TAG_SHIFT | (payload & JSON_COMPACT_PAYLOAD_MASK);
+}
+
+static inline json_compact_t json_compact_float(double floating)
+{
+    json_compact_t value;
+
+    memcpy(&value, &floating, sizeof(value));
+
+    /* Every NaN becomes the positive one so it never looks like a boxed value */
+    return floating != floating ? UINT64_C(0x7FF8000000000000) : value;
+}
+
+static inline json_compact_t json_compact_int(const int64_t *integer)
+{
+    if (*integer < JSON_COMPACT_INT_MIN || *integer > JSON_COMPACT_INT_MAX) {
+        return json_compact_box(JSON_COMPACT_TAG_BIG_INT, (uintptr_t) integer);
+    }
+
+    return json_compact_box(JSON_COMPACT_TAG_INT, (uint64_t) *integer);
+}
+
+#define JsonCompactNull()   json_compact_box(JSON_COMPACT_TAG_NULL, 0)
+#define JsonCompactBool(b)  json_compact_box(JSON_COMPACT_TAG_BOOL, (b) ? 1 : 0)
+#define JsonCompactInt(i)   json_compact_int(&(int64_t) { (i) })
+#define JsonCompactFloat(f) json_compact_float(f)
+
+#define JsonCompactString(s) \
+    json_compact_box(JSON_COMPACT_TAG_STRING, (uintptr_t) (const char *) (s))
+
+#define JsonCompactProp(k,v) JsonCompactString(k), (v)
+
+#define JsonCompactArray(...) (                                                 \
+    json_compact_box(JSON_COMPACT_TAG_ARRAY, (uintptr_t) (json_compact_t[]) {   \
+        TYPED_VA_ARGS_LENGTH(json_compact_t, __VA_ARGS__), __VA_ARGS__          \
+    })                                                                          \
+)
+
+#define JsonCompactObject(...) (                                                \
+    json_compact_box(JSON_COMPACT_TAG_OBJECT, (uintptr_t) (json_compact_t[]) {  \
+        TYPED_VA_ARGS_LENGTH(json_compact_t, __VA_ARGS__) / 2, __VA_ARGS__      \
+    })                                                                          \
+)
+
+#define JsonCompact(c) (                 \
+    &(json_value_t) {                    \
+        .type = JSON_VALUE_TYPE_COMPACT, \
+        .as.compact = (c),               \
+    }                                    \
+)
+
 /**
  * Serializes target json into a string.
  *
@@ -169,10 +536,168 @@ char *json_stringify(json_value_t *json);
  *
  * @param json The target json to be converted into a string
  * @param buffer Buffer where you want to put the string json representation
- * @note You can find out how big the allocated buffer should be with `json_stingified_size(...)` method
+ * @return the length of the written string without the terminating zero
+ * @note You can find out how big the allocated buffer should be with `json_stingified_size(...)`
+ *       or `json_stringified_size_upper_bound(...)` methods
+ */
+STATIC_JSON_BUILDER_EXPORT
+size_t json_stringify_into_buffer(json_value_t *json, char *buffer);
+
+/**
+ * Serializes target json into a string with strings checked or escaped according to the options.
+ *
+ * @param json The target json to be converted into a string
+ * @param options Combination of json_stringify_option_t flags
+ * @return String representation of the target json or NULL on string allocation error or invalid UTF-8
+ * @note You need to release the string allocated by this method
+ */
+STATIC_JSON_BUILDER_EXPORT
+char *json_stringify_with_options(json_value_t *json, unsigned options);
+
+/**
+ * Computes the size of the string representation of the json with the options and validates its strings.
+ *
+ * @param json The target json for which you want to compute the size of the string representation
+ * @param options Combination of json_stringify_option_t flags
+ * @param size Where to put the size of the string representation including the terminating zero
+ * @return true on success or false if a string or a key is not valid UTF-8 while validation is requested
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_stringified_size_with_options(json_value_t *json, unsigned options, size_t *size);
+
+/**
+ * Serializes target json into a buffer with the options.
+ *
+ * @param json The target json to be converted into a string
+ * @param options Combination of json_stringify_option_t flags
+ * @param buffer Buffer where you want to put the string json representation
+ * @return the length of the written string without the terminating zero
+ * @note Strings must be validated first by `json_stringified_size_with_options(...)` which also gives the buffer size
+ */
+STATIC_JSON_BUILDER_EXPORT
+size_t json_stringify_into_buffer_with_options(json_value_t *json, unsigned options, char *buffer);
+
+/**
+ * Serializes the fields of target json selected by a mask into a string, without copying the json.
+ *
+ * @param json The target json to be converted into a string
+ * @param mask The root of a mask compiled by `json_mask_compile(...)`
+ * @return String representation of the projected json or NULL on string allocation error
+ * @note You need to release the string allocated by this method, other serializers
+ *       accept the projection as `JsonProjection(json, mask)` node
+ */
+STATIC_JSON_BUILDER_EXPORT
+char *json_stringify_projected(json_value_t *json, const json_mask_t *mask);
+
+/**
+ * Computes how many mask nodes are enough to compile a list of field paths.
+ *
+ * @param fields Comma separated list of dot separated field paths, e.g. "id,author.name"
+ * @return the number of nodes for `json_mask_compile(...)` method
+ */
+STATIC_JSON_BUILDER_EXPORT
+size_t json_mask_nodes_count(const char *fields);
+
+/**
+ * Compiles a list of field paths into a mask.
+ *
+ * @param fields Comma separated list of dot separated field paths, keys are compared as they are written
+ * @param nodes Array of `json_mask_nodes_count(...)` nodes, the first one becomes the root of the mask
+ * @param capacity Number of nodes in the array
+ * @return true on success or false if the list contains an empty key or there are not enough nodes
+ * @note Keys of the mask point into the fields, the list must stay alive while the mask is used
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_mask_compile(const char *fields, json_mask_t *nodes, size_t capacity);
+
+/**
+ * Serializes target json into a string if it fits into a buffer of limited capacity.
+ * The string is written in one pass, its size is computed only when it doesn't fit,
+ * the content of the buffer is unspecified then.
+ *
+ * @param json The target json to be converted into a string
+ * @param buffer Buffer where you want to put the string json representation
+ * @param capacity The size of the buffer including the terminating zero
+ * @param needed Where to put the size required for the string including the terminating zero
+ * @return true if the string has been written, false if the buffer is too small
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_stringify_into_buffer_n(json_value_t *json, char *buffer, size_t capacity, size_t *needed);
+
+/**
+ * Serializes target json into a buffer owned by the library and reused by the calling thread.
+ *
+ * @param json The target json to be converted into a string
+ * @param length Where to put the length of the string without the terminating zero
+ * @return String representation of the target json or NULL on buffer allocation error
+ * @note The string stays valid until the next call of this method on the same thread,
+ *       don't release it; call `json_release_reusable_buffer()` before the thread exits,
+ *       otherwise the buffer leaks unless the library is built with STATIC_JSON_BUILDER_THREADS,
+ *       which releases it at the thread exit
+ */
+STATIC_JSON_BUILDER_EXPORT
+const char *json_stringify_reusable(json_value_t *json, size_t *length);
+
+/**
+ * Releases the reusable buffer of the calling thread.
+ */
+STATIC_JSON_BUILDER_EXPORT
+void json_release_reusable_buffer(void);
+
+/*
+ Writers running a background thread need OS threads and are only available
+ when STATIC_JSON_BUILDER_THREADS is defined, the meson option `threads`
+ defines it for the library and its users.
+*/
+
+#if defined(STATIC_JSON_BUILDER_THREADS)
+
+/**
+ * Serializes target json into a file descriptor while a background thread writes the serialized chunks.
+ * Serialization continues into a free chunk of the ring while the previous chunks are being written.
+ *
+ * @param json The target json to be converted into a string
+ * @param fd File descriptor where you want to write the string json representation
+ * @param chunk_size Size of each chunk of the ring in bytes, at least 4096
+ * @param chunks_count Number of chunks in the ring, at least 2
+ * @return true on success, false on allocation, thread or write error
+ * @note The string is written without the terminating zero
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_stringify_to_fd_pipelined(json_value_t *json, int fd, size_t chunk_size, size_t chunks_count);
+
+/**
+ * Starts a log which writes json records as NDJSON lines into a file descriptor from a background thread.
+ *
+ * @param fd File descriptor where you want to write the records
+ * @param capacity Size of the ring of records in bytes, rounded up to a power of two of at least 64 KiB
+ * @return the log or NULL on allocation or thread error
+ * @note The batch of records written at once is as large as the ring
  */
 STATIC_JSON_BUILDER_EXPORT
-void json_stringify_into_buffer(json_value_t *json, char *buffer);
+json_log_t *json_log_open(int fd, size_t capacity);
+
+/**
+ * Serializes target json into the log as one record, the method can be called from many threads at once.
+ * It waits while the ring is full, no lock is taken.
+ *
+ * @param log The log opened by `json_log_open(...)`
+ * @param json The target json to be written as a record
+ * @return true on success or false if the record takes more than a half of the ring
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_log_write(json_log_t *log, json_value_t *json);
+
+/**
+ * Writes the remaining records, stops the log thread and releases the log.
+ *
+ * @param log The log opened by `json_log_open(...)`, no thread may write into it anymore
+ * @return true on success or false if a write into the file descriptor failed
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_log_close(json_log_t *log);
+
+#endif
 
 /**
  * Computes the size of the string representation of the json.
@@ -183,4 +708,445 @@ void json_stringify_into_buffer(json_value_t *json, char *buffer);
 STATIC_JSON_BUILDER_EXPORT
 size_t json_stingified_size(json_value_t *json);
 
+/**
+ * Computes a size which is enough for the string representation of the json.
+ * Numbers are counted with their widest representation instead of being formatted.
+ *
+ * @param json The target json for which you want to compute the size bound
+ * @return the size not less than `json_stingified_size(...)` of the target json
+ */
+STATIC_JSON_BUILDER_EXPORT
+size_t json_stringified_size_upper_bound(json_value_t *json);
+
+/**
+ * Counts the padded integers of the json that become patchable slots.
+ *
+ * @param json The target json in which you want to count patchable slots
+ * @return the number of slots filled by `json_render_patchable(...)` method
+ */
+STATIC_JSON_BUILDER_EXPORT
+size_t json_patchable_slots_count(json_value_t *json);
+
+/**
+ * Serializes target json into a buffer and reports where its padded integers were written.
+ *
+ * @param json The target json to be converted into a string
+ * @param buffer Buffer where you want to put the string json representation
+ * @param slots Array of `json_patchable_slots_count(...)` slots filled in document order
+ * @note You can find out how big the allocated buffer should be with `json_stingified_size(...)` method
+ */
+STATIC_JSON_BUILDER_EXPORT
+void json_render_patchable(json_value_t *json, char *buffer, json_slot_t *slots);
+
+/**
+ * Rewrites the value of a slot inside a buffer filled by `json_render_patchable(...)`.
+ *
+ * @param buffer Buffer previously filled by `json_render_patchable(...)` method
+ * @param slot The slot which value you want to replace
+ * @param value The new value of the slot
+ * @return true on success or false if the value does not fit into the slot width
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_patch_slot(char *buffer, const json_slot_t *slot, int64_t value);
+
+/**
+ * Encodes target json into a MessagePack binary representation.
+ *
+ * @param json The target json to be encoded
+ * @param size Where to put the size of the encoded data in bytes
+ * @return MessagePack representation of the target json or NULL on buffer allocation error
+ * @note You need to release the buffer allocated by this method
+ */
+STATIC_JSON_BUILDER_EXPORT
+uint8_t *json_encode_msgpack(json_value_t *json, size_t *size);
+
+/**
+ * Encodes target json into a MessagePack binary representation and puts the result into a buffer.
+ *
+ * @param json The target json to be encoded
+ * @param buffer Buffer where you want to put the MessagePack representation
+ * @note You can find out how big the allocated buffer should be with `json_encode_msgpack_size(...)` method
+ */
+STATIC_JSON_BUILDER_EXPORT
+void json_encode_msgpack_into_buffer(json_value_t *json, uint8_t *buffer);
+
+/**
+ * Computes the exact size of the MessagePack representation of the json.
+ *
+ * @param json The target json for which you want to compute the size of the MessagePack representation
+ * @return the size of the MessagePack representation of the target json in bytes
+ */
+STATIC_JSON_BUILDER_EXPORT
+size_t json_encode_msgpack_size(json_value_t *json);
+
+/**
+ * Prepares a pool which allocates parsed json trees from the provided memory.
+ *
+ * @param pool The pool to be initialized
+ * @param memory Memory from which the pool allocates nodes
+ * @param capacity Size of the memory in bytes
+ */
+STATIC_JSON_BUILDER_EXPORT
+void json_pool_init(json_pool_t *pool, void *memory, size_t capacity);
+
+/**
+ * Parses json text into a tree allocated from the pool.
+ *
+ * @param text Json text, strings are unescaped in place so the text must stay alive with the tree
+ * @param length Length of the json text in bytes
+ * @param pool The pool from which all nodes of the tree are allocated
+ * @param json Where to put the root of the parsed tree
+ * @return JSON_PARSE_OK on success or the reason why the text can't be parsed
+ * @note Numbers without fraction and exponent that fit into int64_t become JSON_VALUE_TYPE_INT
+ * @note Strings are zero terminated, so a string containing the valid escape `\u0000` can't be
+ *       represented and fails with JSON_PARSE_ERROR_NUL_CHARACTER
+ */
+STATIC_JSON_BUILDER_EXPORT
+json_parse_status_t json_parse(char *text, size_t length, json_pool_t *pool, json_value_t **json);
+
+/**
+ * Places a cursor on the root value of json text.
+ *
+ * @param cursor The cursor to be initialized
+ * @param text Json text which must stay alive while the cursor is used
+ * @param length Length of the json text in bytes
+ */
+STATIC_JSON_BUILDER_EXPORT
+void json_cursor_init(json_cursor_t *cursor, const char *text, size_t length);
+
+/**
+ * Moves a cursor placed on an object to the value of one of its properties.
+ *
+ * @param cursor The cursor placed on an object
+ * @param key Key of the property, compared with keys exactly as they are written in the text
+ * @return true if the property was found or false if the cursor stays where it was
+ * @note Copy the cursor before the call to look up several properties of the same object
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_cursor_find_key(json_cursor_t *cursor, const char *key);
+
+/**
+ * Moves a cursor placed on an array to one of its entries.
+ *
+ * @param cursor The cursor placed on an array
+ * @param index Index of the entry
+ * @return true if the entry was found or false if the cursor stays where it was
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_cursor_find_index(json_cursor_t *cursor, size_t index);
+
+/**
+ * Reads an integer at the cursor position.
+ *
+ * @param cursor The cursor placed on a number without fraction and exponent
+ * @param integer Where to put the value
+ * @return true on success or false if there is no integer fitting into int64_t at the cursor
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_cursor_get_int(const json_cursor_t *cursor, int64_t *integer);
+
+/**
+ * Reads a string at the cursor position and unescapes it into a buffer.
+ *
+ * @param cursor The cursor placed on a string
+ * @param buffer Buffer where you want to put the zero terminated string
+ * @param capacity Size of the buffer in bytes
+ * @return true on success or false if there is no valid string at the cursor, it doesn't fit
+ *         or it contains `\u0000` which a zero terminated string can't hold
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_cursor_get_string(const json_cursor_t *cursor, char *buffer, size_t capacity);
+
+/**
+ * Reads a scalar value at the cursor position.
+ *
+ * @param cursor The cursor placed on null, bool, number or string
+ * @param json Where to put the value
+ * @param buffer Buffer for the string value, the value points into it
+ * @param capacity Size of the buffer in bytes
+ * @return true on success or false if there is no valid scalar at the cursor
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_cursor_get_value(const json_cursor_t *cursor, json_value_t *json, char *buffer, size_t capacity);
+
+/**
+ * Finds a property of an object by its key.
+ *
+ * @param json The object in which you want to find the property
+ * @param key Key of the property, it doesn't need to be zero terminated
+ * @param length Length of the key in bytes
+ * @return the first property with the key or NULL if there is no such property
+ * @note Objects with an index built by `json_object_index_build(...)` are searched in constant time,
+ *       other objects are scanned
+ */
+STATIC_JSON_BUILDER_EXPORT
+json_prop_t *json_object_get(json_value_t *json, const char *key, size_t length);
+
+/**
+ * Computes the size of the hash index of an object.
+ *
+ * @param json The object for which you want to build the index
+ * @return the size of the buffer for `json_object_index_build(...)` method in bytes
+ */
+STATIC_JSON_BUILDER_EXPORT
+size_t json_object_index_size(json_value_t *json);
+
+/**
+ * Builds the hash index of object keys into a buffer and attaches it to the object.
+ *
+ * @param json The object for which you want to build the index
+ * @param buffer Buffer of `json_object_index_size(...)` bytes aligned at least to 8 bytes
+ * @note The buffer must stay alive while the object is used, rebuild the index after changing
+ *       the keys or the order of properties; properties entries can be replaced freely
+ */
+STATIC_JSON_BUILDER_EXPORT
+void json_object_index_build(json_value_t *json, void *buffer);
+
+/**
+ * Computes a JSON Patch (RFC 6902) which turns one json into another and builds it as a json tree.
+ *
+ * @param from The old json
+ * @param to The new json
+ * @param pool The pool from which the operations and their paths are allocated
+ * @param patch Where to put the array of operations
+ * @return true on success or false if the pool is exhausted, the pool is left unchanged then
+ * @note Nodes shared by both jsons are skipped without comparing them, values of the operations
+ *       are nodes of the new json, so it must stay alive with the patch; values other than
+ *       plain scalars, arrays and objects are equal only when they share the same data
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_diff(json_value_t *from, json_value_t *to, json_pool_t *pool, json_value_t **patch);
+
+/**
+ * Computes the size of a block that holds a deep copy of the json.
+ *
+ * @param json The target json to be cloned
+ * @return the size of the block for `json_clone_into(...)` method in bytes,
+ *         0 if the json holds snapshot views or generators
+ */
+STATIC_JSON_BUILDER_EXPORT
+size_t json_clone_size(json_value_t *json);
+
+/**
+ * Copies the json with all its nodes, keys and strings into one contiguous block.
+ *
+ * @param json The target json to be cloned
+ * @param buffer Block of `json_clone_size(...)` bytes aligned at least to 8 bytes, as malloc returns
+ * @return the root of the clone placed at the beginning of the block,
+ *         NULL if the json holds snapshot views or generators
+ * @note The clone doesn't reference the original tree, projection masks are copied too,
+ *       so releasing the block releases the whole clone
+ */
+STATIC_JSON_BUILDER_EXPORT
+json_value_t *json_clone_into(json_value_t *json, void *buffer);
+
+/**
+ * Computes the size of the binary snapshot of the json.
+ *
+ * @param json The target json to be saved
+ * @return the size of the snapshot in bytes
+ */
+STATIC_JSON_BUILDER_EXPORT
+size_t json_snapshot_size(json_value_t *json);
+
+/**
+ * Saves the json into a relocatable binary snapshot which uses offsets instead of pointers.
+ *
+ * @param json The target json to be saved
+ * @param buffer Buffer of `json_snapshot_size(...)` bytes aligned at least to 8 bytes
+ * @note Snapshots are native-endian, a snapshot can be viewed only on a machine with the same byte order
+ */
+STATIC_JSON_BUILDER_EXPORT
+void json_snapshot_write(json_value_t *json, void *buffer);
+
+/**
+ * Makes a json node that reads the snapshot in place, without parsing or copying.
+ *
+ * @param data Snapshot data, e.g. a file mapped into memory, aligned at least to 8 bytes
+ * @param size Size of the snapshot data in bytes
+ * @param json Node that becomes the root of the snapshot, accepted by all serialization methods
+ * @return true on success or false if the data is not a snapshot of a compatible format
+ * @note The snapshot content is trusted, only its header is validated
+ */
+STATIC_JSON_BUILDER_EXPORT
+bool json_snapshot_view(const void *data, size_t size, json_value_t *json);
+
+/**
+ * Computes the length of the json representation of an integer.
+ *
+ * @param integer The target integer
+ * @return the length of the integer representation
+ */
+STATIC_JSON_BUILDER_EXPORT
+size_t json_int_text_size(int64_t integer);
+
+/**
+ * Writes the json representation of an integer.
+ *
+ * @param cursor Where to write the integer representation
+ * @param integer The target integer
+ * @return the position right after the written representation
+ */
+STATIC_JSON_BUILDER_EXPORT
+char *json_int_text_write(char *cursor, int64_t integer);
+
+/**
+ * Computes the length of the json representation of a floating point number.
+ *
+ * @param floating The target number
+ * @return the length of the number representation
+ */
+STATIC_JSON_BUILDER_EXPORT
+size_t json_float_text_size(double floating);
+
+/**
+ * Writes the json representation of a floating point number.
+ *
+ * @param cursor Where to write the number representation
+ * @param floating The target number
+ * @return the position right after the written representation
+ */
+STATIC_JSON_BUILDER_EXPORT
+char *json_float_text_write(char *cursor, double floating);
+
+/**
+ * Computes the length of the json representation of a string including quotes and escapes.
+ *
+ * @param string The target string
+ * @return the length of the string representation
+ */
+STATIC_JSON_BUILDER_EXPORT
+size_t json_string_text_size(const char *string);
+
+/**
+ * Writes the json representation of a string including quotes and escapes.
+ *
+ * @param cursor Where to write the string representation
+ * @param string The target string
+ * @return the position right after the written representation
+ */
+STATIC_JSON_BUILDER_EXPORT
+char *json_string_text_write(char *cursor, const char *string);
+
+/*
+ Struct description generates serializers of a struct without building a tree:
+
+     JSON_DESCRIBE(order_t,
+         JSON_FIELD_INT(id),
+         JSON_FIELD_STRING(symbol),
+         JSON_FIELD_NAMED(FLOAT, price, "px"),
+         JSON_FIELD_OBJECT(trade, trade_t)
+     )
+
+ expands into `json_stringified_size_order_t(const order_t *)` and
+ `json_stringify_order_t_into_buffer(const order_t *, char *)` which work
+ like `json_stingified_size(...)` and `json_stringify_into_buffer(...)`
+ of the equivalent object. Keys are rendered at compile time together with
+ their punctuation, names must not need escaping. Kinds are INT, FLOAT, BOOL,
+ STRING and OBJECT (a struct described before), up to 32 fields per struct
+ listed without a trailing comma.
+*/
+
+#define JSON_FIELD_INT(m)           (INT,    m, #m, )
+#define JSON_FIELD_FLOAT(m)         (FLOAT,  m, #m, )
+#define JSON_FIELD_BOOL(m)          (BOOL,   m, #m, )
+#define JSON_FIELD_STRING(m)        (STRING, m, #m, )
+#define JSON_FIELD_OBJECT(m, t)     (OBJECT, m, #m, t)
+#define JSON_FIELD_NAMED(k, m, n)   (k,      m, n,  )
+
+#define JSON_DESCRIBE_KEY(n) ",\"" n "\":"
+
+#define JSON_DESCRIBE_SIZE_INT(v, t)    json_int_text_size(v)
+#define JSON_DESCRIBE_SIZE_FLOAT(v, t)  json_float_text_size(v)
+#define JSON_DESCRIBE_SIZE_BOOL(v, t)   ((v) ? strlen("true") : strlen("false"))
+#define JSON_DESCRIBE_SIZE_STRING(v, t) json_string_text_size(v)
+#define JSON_DESCRIBE_SIZE_OBJECT(v, t) json_described_size_##t(&(v))
+
+#define JSON_DESCRIBE_WRITE_INT(c, v, t)    json_int_text_write(c, v)
+#define JSON_DESCRIBE_WRITE_FLOAT(c, v, t)  json_float_text_write(c, v)
+#define JSON_DESCRIBE_WRITE_BOOL(c, v, t)   ((v) ? (char *) memcpy(c, "true", 4) + 4 : (char *) memcpy(c, "false", 5) + 5)
+#define JSON_DESCRIBE_WRITE_STRING(c, v, t) json_string_text_write(c, v)
+#define JSON_DESCRIBE_WRITE_OBJECT(c, v, t) json_described_write_##t(&(v), c)
+
+#define JSON_DESCRIBE_SIZE_FIELD(k, m, n, t) \
+    size += strlen(JSON_DESCRIBE_KEY(n)) + JSON_DESCRIBE_SIZE_##k(value->m, t);
+
+#define JSON_DESCRIBE_WRITE_FIELD(k, m, n, t)                                        \
+    memcpy(cursor, JSON_DESCRIBE_KEY(n) + skip, strlen(JSON_DESCRIBE_KEY(n)) - skip); \
+    cursor += strlen(JSON_DESCRIBE_KEY(n)) - skip;                                   \
+    cursor  = JSON_DESCRIBE_WRITE_##k(cursor, value->m, t);                          \
+    skip    = 0;
+
+#define JSON_DESCRIBE_EXPAND(x) x
+#define JSON_DESCRIBE_CONCAT(a, b) JSON_DESCRIBE_CONCAT_(a, b)
+#define JSON_DESCRIBE_CONCAT_(a, b) a##b
+
+#define JSON_DESCRIBE_COUNT(...) JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_COUNT_(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define JSON_DESCRIBE_COUNT_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+
+#define JSON_DESCRIBE_FOR_EACH(m, ...) \
+    JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_CONCAT(JSON_DESCRIBE_FOR_EACH_, JSON_DESCRIBE_COUNT(__VA_ARGS__))(m, __VA_ARGS__))
+
+#define JSON_DESCRIBE_FOR_EACH_1(m, x) m x
+#define JSON_DESCRIBE_FOR_EACH_2(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_1(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_3(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_2(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_4(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_3(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_5(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_4(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_6(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_5(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_7(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_6(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_8(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_7(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_9(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_8(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_10(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_9(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_11(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_10(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_12(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_11(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_13(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_12(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_14(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_13(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_15(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_14(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_16(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_15(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_17(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_16(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_18(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_17(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_19(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_18(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_20(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_19(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_21(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_20(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_22(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_21(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_23(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_22(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_24(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_23(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_25(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_24(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_26(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_25(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_27(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_26(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_28(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_27(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_29(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_28(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_30(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_29(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_31(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_30(m, __VA_ARGS__))
+#define JSON_DESCRIBE_FOR_EACH_32(m, x, ...) m x JSON_DESCRIBE_EXPAND(JSON_DESCRIBE_FOR_EACH_31(m, __VA_ARGS__))
+
+#define JSON_DESCRIBE(type, ...)                                                              \
+    static inline size_t json_described_size_##type(const type *value)                        \
+    {                                                                                         \
+        size_t size = strlen("{}") - strlen(",");                                             \
+        JSON_DESCRIBE_FOR_EACH(JSON_DESCRIBE_SIZE_FIELD, __VA_ARGS__)                         \
+        return size;                                                                          \
+    }                                                                                         \
+                                                                                              \
+    static inline char *json_described_write_##type(const type *value, char *cursor)          \
+    {                                                                                         \
+        size_t skip = strlen(",");                                                            \
+        *cursor++ = '{';                                                                      \
+        JSON_DESCRIBE_FOR_EACH(JSON_DESCRIBE_WRITE_FIELD, __VA_ARGS__)                        \
+        *cursor++ = '}';                                                                      \
+        return cursor;                                                                        \
+    }                                                                                         \
+                                                                                              \
+    static inline size_t json_stringified_size_##type(const type *value)                      \
+    {                                                                                         \
+        return json_described_size_##type(value) + 1;                                         \
+    }                                                                                         \
+                                                                                              \
+    static inline size_t json_stringify_##type##_into_buffer(const type *value, char *buffer) \
+    {                                                                                         \
+        char *end = json_described_write_##type(value, buffer);                               \
+        *end = '\0';                                                                          \
+        return (size_t) (end - buffer);                                                       \
+    }
+
 #endif /* STATIC_JSON_BUILDER_H */
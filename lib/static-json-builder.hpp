@@ -0,0 +1,736 @@
+#ifndef STATIC_JSON_BUILDER_HPP
+#define STATIC_JSON_BUILDER_HPP
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+/*
+ C++20 companion of static-json-builder.h. Builders are constexpr functions
+ returning typed nodes, so a tree made only of constants is stringified by
+ `render(...)` at compile time into a static character array. The output is
+ identical to `json_stringify(...)` of the same tree built with the C macros.
+
+ Rendered documents can be embedded into trees built at runtime with `Raw(...)`,
+ then only the dynamic leaves of such trees are formatted at runtime. Keys
+ and strings given as string literals are measured for escaping at compile
+ time even in runtime trees, so a `const char` array passed to `Prop(...)`
+ or `String(...)` must be usable in constant expressions; wrap other arrays
+ in `std::string_view`.
+*/
+
+namespace static_json_builder
+{
+
+namespace detail
+{
+
+/*
+ Longest "%" PRId64 and "%f" representations, the same as in the C library.
+*/
+
+inline constexpr std::size_t int_max_length   = 20;
+inline constexpr std::size_t float_max_length = 317;
+
+constexpr char *write_raw(char *cursor, std::string_view text)
+{
+    if (!std::is_constant_evaluated()) {
+        std::memcpy(cursor, text.data(), text.size());
+        return cursor + text.size();
+    }
+
+    for (char character : text) {
+        *cursor++ = character;
+    }
+
+    return cursor;
+}
+
+constexpr char *write_unsigned(char *cursor, std::uint64_t value)
+{
+    char        digits[int_max_length];
+    std::size_t count = 0;
+
+    do {
+        digits[count++] = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    while (count != 0) {
+        *cursor++ = digits[--count];
+    }
+
+    return cursor;
+}
+
+constexpr char *write_int(char *cursor, std::int64_t value)
+{
+    if (value < 0) {
+        *cursor++ = '-';
+        return write_unsigned(cursor, 0 - (std::uint64_t) value);
+    }
+
+    return write_unsigned(cursor, (std::uint64_t) value);
+}
+
+/*
+ Big unsigned integer wide enough for the largest double multiplied by 10^6,
+ it's used to format doubles exactly like "%f" does during constant evaluation.
+*/
+
+struct big_uint
+{
+    static constexpr std::size_t words_count = 36;
+
+    std::uint32_t words[words_count] = {};
+
+    constexpr void multiply(std::uint32_t factor)
+    {
+        std::uint64_t carry = 0;
+
+        for (std::uint32_t &word : words) {
+            std::uint64_t product = (std::uint64_t) word * factor + carry;
+
+            word  = (std::uint32_t) product;
+            carry = product >> 32;
+        }
+    }
+
+    constexpr void add(std::uint32_t value)
+    {
+        for (std::uint32_t &word : words) {
+            std::uint64_t sum = (std::uint64_t) word + value;
+
+            word  = (std::uint32_t) sum;
+            value = (std::uint32_t) (sum >> 32);
+
+            if (value == 0) {
+                break;
+            }
+        }
+    }
+
+    constexpr std::uint32_t divide(std::uint32_t divisor)
+    {
+        std::uint64_t remainder = 0;
+
+        for (std::size_t i = words_count; i-- > 0;) {
+            std::uint64_t current = (remainder << 32) | words[i];
+
+            words[i]  = (std::uint32_t) (current / divisor);
+            remainder = current % divisor;
+        }
+
+        return (std::uint32_t) remainder;
+    }
+
+    constexpr void shift_left(std::size_t bits)
+    {
+        for (; bits >= 32; bits -= 32) {
+            for (std::size_t i = words_count; i-- > 1;) {
+                words[i] = words[i - 1];
+            }
+
+            words[0] = 0;
+        }
+
+        for (std::size_t i = words_count; bits != 0 && i-- > 0;) {
+            words[i] = (words[i] << bits) | (i != 0 ? words[i - 1] >> (32 - bits) : 0);
+        }
+    }
+
+    constexpr void shift_right(std::size_t bits)
+    {
+        for (; bits >= 32; bits -= 32) {
+            for (std::size_t i = 0; i + 1 < words_count; i++) {
+                words[i] = words[i + 1];
+            }
+
+            words[words_count - 1] = 0;
+        }
+
+        for (std::size_t i = 0; bits != 0 && i < words_count; i++) {
+            words[i] = (words[i] >> bits) | (i + 1 < words_count ? words[i + 1] << (32 - bits) : 0);
+        }
+    }
+
+    constexpr bool bit(std::size_t index) const
+    {
+        return index / 32 < words_count && (words[index / 32] >> (index % 32)) & 1;
+    }
+
+    constexpr bool any_below(std::size_t index) const
+    {
+        for (std::size_t i = 0; i < index; i++) {
+            if (bit(i)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    constexpr bool is_zero() const
+    {
+        for (std::uint32_t word : words) {
+            if (word != 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+/*
+ The double is mantissa * 2^exponent, so the value multiplied by 10^6
+ is an exact big integer when the exponent isn't negative. Otherwise the
+ dropped bits decide the rounding: to nearest, ties to even.
+*/
+
+constexpr char *write_float_exact(char *cursor, double value)
+{
+    std::uint64_t bits     = std::bit_cast<std::uint64_t>(value);
+    std::uint64_t fraction = bits & (((std::uint64_t) 1 << 52) - 1);
+    int           biased   = (int) ((bits >> 52) & 0x7ff);
+
+    if (bits >> 63) {
+        *cursor++ = '-';
+    }
+
+    if (biased == 0x7ff) {
+        return write_raw(cursor, fraction != 0 ? "nan" : "inf");
+    }
+
+    std::uint64_t mantissa = biased != 0 ? fraction | (std::uint64_t) 1 << 52 : fraction;
+    int           exponent = biased != 0 ? biased - 1075 : -1074;
+    big_uint      scaled;
+
+    scaled.words[0] = (std::uint32_t) mantissa;
+    scaled.words[1] = (std::uint32_t) (mantissa >> 32);
+    scaled.multiply(1000000);
+
+    if (exponent >= 0) {
+        scaled.shift_left((std::size_t) exponent);
+    } else {
+        std::size_t dropped = (std::size_t) -exponent;
+        bool        half    = scaled.bit(dropped - 1);
+        bool        sticky  = scaled.any_below(dropped - 1);
+
+        scaled.shift_right(dropped);
+
+        if (half && (sticky || scaled.bit(0))) {
+            scaled.add(1);
+        }
+    }
+
+    char        digits[float_max_length];
+    std::size_t count = 0;
+
+    do {
+        digits[count++] = (char) ('0' + scaled.divide(10));
+    } while (!scaled.is_zero() || count < 7);
+
+    while (count > 6) {
+        *cursor++ = digits[--count];
+    }
+
+    *cursor++ = '.';
+
+    while (count != 0) {
+        *cursor++ = digits[--count];
+    }
+
+    return cursor;
+}
+
+/*
+ Doubles below about 1.8e13 are formatted in 64-bit arithmetic: the value
+ multiplied by 10^6 is mantissa * 5^6 * 2^(exponent + 6), a product below
+ 2^67 kept in two words and shifted with the same rounding as the exact
+ formatter. Other doubles fall back to it. Neither uses "%f" of the C
+ runtime, which follows LC_NUMERIC and would write a decimal comma in
+ some locales.
+*/
+
+constexpr bool write_float_fast(char *&cursor, double value)
+{
+    std::uint64_t bits     = std::bit_cast<std::uint64_t>(value);
+    std::uint64_t fraction = bits & (((std::uint64_t) 1 << 52) - 1);
+    int           biased   = (int) ((bits >> 52) & 0x7ff);
+
+    if (biased == 0x7ff) {
+        return false;
+    }
+
+    std::uint64_t mantissa = biased != 0 ? fraction | (std::uint64_t) 1 << 52 : fraction;
+    int           shift    = (biased != 0 ? biased - 1075 : -1074) + 6;
+    std::uint64_t low      = (mantissa & 0xffffffff) * 15625;
+    std::uint64_t middle   = (mantissa >> 32) * 15625 + (low >> 32);
+    std::uint64_t high     = middle >> 32;
+    std::uint64_t scaled   = middle << 32 | (low & 0xffffffff);
+
+    if (shift >= 0) {
+        if (high != 0 || shift >= 64 || (shift != 0 && scaled >> (64 - shift) != 0)) {
+            return false;
+        }
+
+        scaled <<= shift;
+    } else if (shift <= -68) {
+        /* The product is below 2^67, so even its half bit is dropped */
+        scaled = 0;
+    } else {
+        int           dropped = -shift;
+        std::uint64_t below   = dropped <= 64 ? scaled & (((std::uint64_t) 2 << (dropped - 1)) - 1) : scaled;
+        std::uint64_t halfway = dropped <= 64 ? (std::uint64_t) 1 << (dropped - 1) : 0;
+        bool          half    = dropped <= 64 ? (below & halfway) != 0 : (high >> (dropped - 65)) & 1;
+        bool          sticky  = dropped <= 64 ? (below & (halfway - 1)) != 0
+                                              : below != 0 || (high & (((std::uint64_t) 1 << (dropped - 65)) - 1)) != 0;
+
+        if (dropped < 64 && high >> dropped != 0) {
+            return false;
+        }
+
+        scaled = dropped < 64 ? scaled >> dropped | (high << 1 << (63 - dropped)) : high >> (dropped - 64);
+
+        if (scaled == UINT64_MAX) {
+            return false;
+        }
+
+        if (half && (sticky || (scaled & 1))) {
+            scaled++;
+        }
+    }
+
+    char        digits[int_max_length];
+    std::size_t count = 0;
+
+    if (bits >> 63) {
+        *cursor++ = '-';
+    }
+
+    do {
+        digits[count++] = (char) ('0' + scaled % 10);
+        scaled /= 10;
+    } while (scaled != 0 || count < 7);
+
+    while (count > 6) {
+        *cursor++ = digits[--count];
+    }
+
+    *cursor++ = '.';
+
+    while (count != 0) {
+        *cursor++ = digits[--count];
+    }
+
+    return true;
+}
+
+constexpr char *write_float(char *cursor, double value)
+{
+    return write_float_fast(cursor, value) ? cursor : write_float_exact(cursor, value);
+}
+
+constexpr std::size_t float_length(double value)
+{
+    char buffer[float_max_length + 1] = {};
+    return (std::size_t) (write_float(buffer, value) - buffer);
+}
+
+constexpr std::size_t int_length(std::int64_t value)
+{
+    char buffer[int_max_length] = {};
+    return (std::size_t) (write_int(buffer, value) - buffer);
+}
+
+constexpr std::string_view escape_sequence(char character)
+{
+    switch (character) {
+    case '"':  return "\\\"";
+    case '\\': return "\\\\";
+    case '\b': return "\\b";
+    case '\f': return "\\f";
+    case '\n': return "\\n";
+    case '\r': return "\\r";
+    case '\t': return "\\t";
+    default:   return {};
+    }
+}
+
+constexpr bool is_control(char character)
+{
+    return (unsigned char) character < 0x20;
+}
+
+constexpr std::size_t escaped_size(std::string_view string)
+{
+    std::size_t size = 0;
+
+    for (char character : string) {
+        if (!escape_sequence(character).empty()) {
+            size += escape_sequence(character).size();
+        } else {
+            size += is_control(character) ? std::string_view("\\u0000").size() : 1;
+        }
+    }
+
+    return size;
+}
+
+constexpr char *write_escaped(char *cursor, std::string_view string)
+{
+    constexpr std::string_view hex = "0123456789abcdef";
+
+    for (char character : string) {
+        if (!escape_sequence(character).empty()) {
+            cursor = write_raw(cursor, escape_sequence(character));
+        } else if (is_control(character)) {
+            cursor = write_raw(cursor, "\\u00");
+            *cursor++ = hex[(unsigned char) character >> 4];
+            *cursor++ = hex[(unsigned char) character & 0xf];
+        } else {
+            *cursor++ = character;
+        }
+    }
+
+    return cursor;
+}
+
+} // namespace detail
+
+/*
+ Keys and strings keep the size of their escaped text. String literals are
+ measured by a consteval constructor, so they cost a plain copy in trees built
+ at runtime. Other text is measured when its node is built.
+*/
+
+struct escaped_text
+{
+    std::string_view value;
+    std::size_t      size;
+
+    template <std::size_t Length>
+    consteval escaped_text(const char (&literal)[Length])
+        : value(literal), size(detail::escaped_size(value))
+    {
+    }
+
+    template <class Text>
+        requires std::is_convertible_v<Text, std::string_view> &&
+                 (!std::is_array_v<std::remove_reference_t<Text>> ||
+                  !std::is_const_v<std::remove_extent_t<std::remove_reference_t<Text>>>)
+    constexpr escaped_text(Text &&text)
+        : value(std::string_view(text)), size(detail::escaped_size(value))
+    {
+    }
+
+    constexpr bool plain() const
+    {
+        return size == value.size();
+    }
+};
+
+struct null_node
+{
+};
+
+struct bool_node
+{
+    bool value;
+};
+
+struct int_node
+{
+    std::int64_t value;
+};
+
+struct float_node
+{
+    double value;
+};
+
+struct string_node
+{
+    escaped_text value;
+};
+
+struct raw_node
+{
+    std::string_view text;
+};
+
+template <class Entry>
+struct prop_node
+{
+    escaped_text key;
+    Entry        entry;
+};
+
+template <class... Entries>
+struct array_node
+{
+    std::tuple<Entries...> entries;
+};
+
+template <class... Props>
+struct object_node
+{
+    std::tuple<Props...> props;
+};
+
+template <std::size_t Length>
+struct rendered_json
+{
+    std::array<char, Length + 1> data;
+
+    constexpr const char *c_str() const
+    {
+        return data.data();
+    }
+
+    constexpr std::string_view view() const
+    {
+        return std::string_view(data.data(), Length);
+    }
+
+    constexpr std::size_t size() const
+    {
+        return Length;
+    }
+};
+
+
+constexpr null_node Null()
+{
+    return {};
+}
+
+constexpr bool_node Bool(bool value)
+{
+    return { value };
+}
+
+constexpr int_node Int(std::int64_t value)
+{
+    return { value };
+}
+
+constexpr float_node Float(double value)
+{
+    return { value };
+}
+
+constexpr string_node String(escaped_text value)
+{
+    return { value };
+}
+
+constexpr raw_node Raw(std::string_view text)
+{
+    return { text };
+}
+
+template <std::size_t Length>
+constexpr raw_node Raw(const rendered_json<Length> &rendered)
+{
+    return { rendered.view() };
+}
+
+template <class Entry>
+constexpr prop_node<Entry> Prop(escaped_text key, Entry entry)
+{
+    return { key, entry };
+}
+
+template <class... Entries>
+constexpr array_node<Entries...> Array(Entries... entries)
+{
+    return { std::tuple<Entries...>(entries...) };
+}
+
+template <class... Props>
+constexpr object_node<Props...> Object(Props... props)
+{
+    return { std::tuple<Props...>(props...) };
+}
+
+constexpr std::size_t size(const null_node &)
+{
+    return std::string_view("null").size();
+}
+
+constexpr std::size_t size(const bool_node &json)
+{
+    return json.value ? std::string_view("true").size() : std::string_view("false").size();
+}
+
+constexpr std::size_t size(const int_node &json)
+{
+    return detail::int_length(json.value);
+}
+
+constexpr std::size_t size(const float_node &json)
+{
+    return detail::float_length(json.value);
+}
+
+constexpr std::size_t size(const string_node &json)
+{
+    return 2 + json.value.size;
+}
+
+constexpr std::size_t size(const raw_node &json)
+{
+    return json.text.size();
+}
+
+template <class Entry>
+constexpr std::size_t size(const prop_node<Entry> &json)
+{
+    return 2 + json.key.size + 1 + size(json.entry);
+}
+
+template <class... Entries>
+constexpr std::size_t size(const array_node<Entries...> &json)
+{
+    return std::apply([](const auto &...entries) {
+        return 2 + (sizeof...(entries) != 0 ? sizeof...(entries) - 1 : 0) + (std::size_t(0) + ... + size(entries));
+    }, json.entries);
+}
+
+template <class... Props>
+constexpr std::size_t size(const object_node<Props...> &json)
+{
+    return std::apply([](const auto &...props) {
+        return 2 + (sizeof...(props) != 0 ? sizeof...(props) - 1 : 0) + (std::size_t(0) + ... + size(props));
+    }, json.props);
+}
+
+constexpr char *write(const null_node &, char *cursor)
+{
+    return detail::write_raw(cursor, "null");
+}
+
+constexpr char *write(const bool_node &json, char *cursor)
+{
+    return detail::write_raw(cursor, json.value ? "true" : "false");
+}
+
+constexpr char *write(const int_node &json, char *cursor)
+{
+    return detail::write_int(cursor, json.value);
+}
+
+constexpr char *write(const float_node &json, char *cursor)
+{
+    return detail::write_float(cursor, json.value);
+}
+
+constexpr char *write(const string_node &json, char *cursor)
+{
+    *cursor++ = '"';
+    cursor    = json.value.plain() ? detail::write_raw(cursor, json.value.value) : detail::write_escaped(cursor, json.value.value);
+    *cursor++ = '"';
+
+    return cursor;
+}
+
+constexpr char *write(const raw_node &json, char *cursor)
+{
+    return detail::write_raw(cursor, json.text);
+}
+
+template <class Entry>
+constexpr char *write(const prop_node<Entry> &json, char *cursor)
+{
+    *cursor++ = '"';
+    cursor    = json.key.plain() ? detail::write_raw(cursor, json.key.value) : detail::write_escaped(cursor, json.key.value);
+    cursor    = detail::write_raw(cursor, "\":");
+
+    return write(json.entry, cursor);
+}
+
+template <class... Entries>
+constexpr char *write(const array_node<Entries...> &json, char *cursor)
+{
+    std::size_t index = 0;
+
+    *cursor++ = '[';
+    std::apply([&](const auto &...entries) {
+        ((cursor = write(entries, index++ != 0 ? detail::write_raw(cursor, ",") : cursor)), ...);
+    }, json.entries);
+    *cursor++ = ']';
+
+    return cursor;
+}
+
+template <class... Props>
+constexpr char *write(const object_node<Props...> &json, char *cursor)
+{
+    std::size_t index = 0;
+
+    *cursor++ = '{';
+    std::apply([&](const auto &...props) {
+        ((cursor = write(props, index++ != 0 ? detail::write_raw(cursor, ",") : cursor)), ...);
+    }, json.props);
+    *cursor++ = '}';
+
+    return cursor;
+}
+
+/**
+ * Computes the size of the string representation of the json.
+ *
+ * @param json The target json for which you want to compute the size of the string representation
+ * @return the size of the string representation of the target json including the terminating zero
+ */
+template <class Json>
+constexpr std::size_t stringified_size(const Json &json)
+{
+    return size(json) + 1;
+}
+
+/**
+ * Serializes target json into a string and puts the result into a buffer.
+ *
+ * @param json The target json to be converted into a string
+ * @param buffer Buffer of at least `stringified_size(json)` characters
+ * @return the length of the written string without the terminating zero
+ */
+template <class Json>
+constexpr std::size_t stringify_into_buffer(const Json &json, char *buffer)
+{
+    char *end = write(json, buffer);
+    *end = '\0';
+
+    return (std::size_t) (end - buffer);
+}
+
+/**
+ * Serializes a constant json at compile time.
+ *
+ * @param build Captureless lambda returning the json built only from constants
+ * @return Zero terminated string representation of the json
+ * @note Use as `static constexpr auto health = render([] { return Object(Prop("ok", Bool(true))); });`
+ */
+template <class Build>
+consteval auto render(Build)
+{
+    constexpr auto json   = Build{}();
+    constexpr auto length = size(json);
+
+    rendered_json<length> rendered = {};
+    stringify_into_buffer(json, rendered.data.data());
+
+    return rendered;
+}
+
+} // namespace static_json_builder
+
+#endif /* STATIC_JSON_BUILDER_HPP */
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <munit.h>
+#include <static-json-builder.h>
+#include "sjb-codegen-sample.h"
+#include "sjb-codegen-constant.h"
+
+#define MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data) \
+    do {                                             \
+        (void) (params);                             \
+        (void) (data);                               \
+    } while (0)
+
+#define MUNIT_SIMPLE_TEST_CASE(name, function) \
+    { (char*) (name), (function), NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+
+#define MUNIT_SIMPLE_TEST_SUITE(name, test_cases) \
+    { (char*) (name), (test_cases), NULL, 1, MUNIT_SUITE_OPTION_NONE }
+
+static MunitResult codegen_sample(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    order_t orders[] = {
+        { 1, "ACME", 1.5, true, 0.25, 2, "NYSE", 0, -3, false },
+        { INT64_MIN, "", -0.0, false, 1e300, INT64_MAX, "tab\t\"quote\" \xc3\xa9", 42, 0, true },
+        { -7, "line\nbreak\\", 123456.789, true, -1e-7, -1, "?\?=", 1, 2, false },
+    };
+
+    for (size_t i = 0; i < sizeof(orders) / sizeof(orders[0]); i++) {
+        const order_t *order = &orders[i];
+
+        Json json = JsonObject(
+            JsonProp("id",     JsonInt(order->id)),
+            JsonProp("symbol", JsonString(order->symbol)),
+            JsonProp("price",  JsonFloat(order->price)),
+            JsonProp("active", JsonBool(order->active)),
+            JsonProp("note",   JsonNull()),
+            JsonProp("order",  JsonObject(
+                JsonProp("fills",       JsonArray(JsonFloat(order->order_fills_0), JsonInt(order->order_fills_1))),
+                JsonProp("venue \"x\"", JsonString(order->order_venue__x_)),
+                JsonProp("int",         JsonInt(order->order_int)),
+                JsonProp("empty",       JsonObject()),
+                JsonProp("none",        JsonArray()),
+            )),
+            JsonProp("order_int", JsonInt(order->order_int_2)),
+            JsonProp("9lives",    JsonBool(order->_9lives)),
+        );
+
+        char  *expected = json_stringify(json);
+        size_t size     = json_stringified_size_order_t(order);
+        char  *actual   = malloc(size);
+
+        munit_assert_size(size, ==, json_stingified_size(json));
+        munit_assert_size(json_stringify_order_t_into_buffer(order, actual), ==, size - 1);
+        munit_assert_string_equal(actual, expected);
+
+        free(expected);
+        free(actual);
+    }
+
+    return MUNIT_OK;
+}
+
+static MunitResult codegen_constant(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    constant_t constant = { 0 };
+    char       actual[64];
+
+    munit_assert_size(json_stringified_size_constant_t(&constant), ==, sizeof("{\"a\":null,\"b\":[],\"c\":{\"d\":[null,{}]}}"));
+    munit_assert_size(json_stringify_constant_t_into_buffer(&constant, actual), ==, sizeof("{\"a\":null,\"b\":[],\"c\":{\"d\":[null,{}]}}") - 1);
+    munit_assert_string_equal(actual, "{\"a\":null,\"b\":[],\"c\":{\"d\":[null,{}]}}");
+
+    return MUNIT_OK;
+}
+
+static MunitTest tests[] = {
+    MUNIT_SIMPLE_TEST_CASE("/codegen/sample",   codegen_sample  ),
+    MUNIT_SIMPLE_TEST_CASE("/codegen/constant", codegen_constant),
+    MUNIT_SIMPLE_TEST_CASE(NULL,                NULL            ),
+};
+
+static const MunitSuite suite = MUNIT_SIMPLE_TEST_SUITE("/json", tests);
+
+int main(int argc, char* argv[])
+{
+    return munit_suite_main(&suite, (void*) "sjb-codegen", argc, argv);
+}
@@ -0,0 +1,206 @@
+#include <bit>
+#include <cfloat>
+#include <clocale>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <munit.h>
+#include <static-json-builder.hpp>
+
+extern "C" {
+    #include <static-json-builder.h>
+}
+
+#define MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data) \
+    do {                                             \
+        (void) (params);                             \
+        (void) (data);                               \
+    } while (0)
+
+#define MUNIT_SIMPLE_TEST_CASE(name, function) \
+    { (char*) (name), (function), NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+
+#define MUNIT_SIMPLE_TEST_SUITE(name, test_cases) \
+    { (char*) (name), (test_cases), NULL, 1, MUNIT_SUITE_OPTION_NONE }
+
+using namespace static_json_builder;
+
+/* ---------------------------------- */
+
+static_assert(render([] { return String("q\"b\\s\b\f\n\r\t"); }).view() == "\"q\\\"b\\\\s\\b\\f\\n\\r\\t\"");
+static_assert(render([] { return String(std::string_view("\x00\x01\x1f\x7f", 4)); }).view() == "\"\\u0000\\u0001\\u001f\x7f\"");
+static_assert(render([] { return Prop("\x02k", Null()); }).view() == "\"\\u0002k\":null");
+
+/* Literal keys and strings are measured when the tree is built, escapes included */
+static_assert(Prop("q\"b", Null()).key.size == 4 && !Prop("q\"b", Null()).key.plain());
+static_assert(String("plain").value.size == 5 && String("plain").value.plain());
+
+static_assert(render([] { return Int(INT64_MIN); }).view() == "-9223372036854775808");
+static_assert(render([] { return Int(INT64_MAX); }).view() == "9223372036854775807");
+
+static_assert(render([] { return Float(-0.0); }).view() == "-0.000000");
+static_assert(render([] { return Float(0.0000025); }).view() == "0.000003");
+static_assert(render([] { return Float(0.0000005); }).view() == "0.000000");
+static_assert(render([] { return Float(DBL_TRUE_MIN); }).view() == "0.000000");
+static_assert(render([] { return Float(-DBL_MIN / 2); }).view() == "-0.000000");
+
+static_assert(render([] { return Float(1e300); }).view() ==
+    "1000000000000000052504760255204420248704468581108159154915854115511802457988908195786371375080447864043704443832883878176942523235360430575644792184786706982848387200926575803737830233794788090059368953234970799945081119038967640880074652742780142494579258788820056842838115669472196386865459400540160.000000");
+
+static_assert(render([] { return Float(DBL_MAX); }).view() ==
+    "179769313486231570814527423731704356798070567525844996598917476803157260780028538760589558632766878171540458953514382464234321326889464182768467546703537516986049910576551282076245490090389328944075868508455133942304583236903222948165808559332123348274797826204144723168738177180919299881250404026184124858368.000000");
+
+static_assert(render([] { return Object(Prop("a", Array(Int(1), Bool(false), Null())), Prop("b", Object())); }).view() ==
+    "{\"a\":[1,false,null],\"b\":{}}");
+
+/* ---------------------------------- */
+
+static json_value_t json_float_value(double floating)
+{
+    json_value_t value = {};
+
+    value.type        = JSON_VALUE_TYPE_FLOAT;
+    value.as.floating = floating;
+
+    return value;
+}
+
+/*
+ Formats the same double with the C library and the C++ header at runtime,
+ returns false when the outputs differ.
+*/
+
+static bool json_float_matches(double floating)
+{
+    json_value_t value = json_float_value(floating);
+    char        *c     = json_stringify(&value);
+    char         cpp[512];
+
+    std::size_t length  = stringify_into_buffer(Float(floating), cpp);
+    bool        matches = c != NULL && length == size(Float(floating)) && std::strcmp(c, cpp) == 0;
+
+    std::free(c);
+    return matches;
+}
+
+static MunitResult json_hpp_runtime_floats(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    const double fixed[] = {
+        0.0, -0.0, 0.1, 123456.789, 0.0000005, 0.0000025, 1e22, 1e300,
+        DBL_MAX, -DBL_MAX, DBL_MIN, DBL_TRUE_MIN, NAN, -NAN, INFINITY, -INFINITY,
+    };
+
+    for (double floating : fixed) {
+        munit_assert_true(json_float_matches(floating));
+    }
+
+    std::uint64_t state = 0x9e3779b97f4a7c15;
+
+    for (std::size_t i = 0; i < 20000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        /* Exponents around the decimal point are the interesting ones for rounding */
+        std::uint64_t bits = i % 2 ? state : (state & 0x800fffffffffffff) | (std::uint64_t) (0x3c0 + state % 0x80) << 52;
+
+        munit_assert_true(json_float_matches(std::bit_cast<double>(bits)));
+    }
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_hpp_runtime_tree(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    const char *text = "tab\t\"quote\" \x01 \xc3\xa9";
+    auto        json = Object(Prop("id", Int(INT64_MIN)), Prop("list", Array(Float(2.5), String(text), Bool(true), Null())));
+    char        cpp[256];
+
+    json_value_t id       = {};
+    json_value_t floating = json_float_value(2.5);
+    json_value_t string   = {};
+    json_value_t boolean  = {};
+    json_value_t null     = {};
+    json_value_t list     = {};
+    json_value_t root     = {};
+
+    id.type            = JSON_VALUE_TYPE_INT;
+    id.as.integer      = INT64_MIN;
+    string.type        = JSON_VALUE_TYPE_STRING;
+    string.as.string   = text;
+    boolean.type       = JSON_VALUE_TYPE_BOOL;
+    boolean.as.boolean = true;
+    null.type          = JSON_VALUE_TYPE_NULL;
+
+    json_value_t *entries[] = { &floating, &string, &boolean, &null };
+    json_array_t  array     = { 4, entries };
+
+    list.type     = JSON_VALUE_TYPE_ARRAY;
+    list.as.array = &array;
+
+    json_prop_t   id_prop   = { "id", &id };
+    json_prop_t   list_prop = { "list", &list };
+    json_prop_t  *props[]   = { &id_prop, &list_prop };
+    json_object_t object    = { 2, props, NULL };
+
+    root.type      = JSON_VALUE_TYPE_OBJECT;
+    root.as.object = &object;
+
+    char *c = json_stringify(&root);
+
+    munit_assert_not_null(c);
+    munit_assert_size(stringify_into_buffer(json, cpp), ==, std::strlen(c));
+    munit_assert_size(stringified_size(json), ==, json_stingified_size(&root));
+    munit_assert_string_equal(cpp, c);
+
+    std::free(c);
+
+    /* Runtime text is measured when its node is built */
+    char key[] = "k\"ey";
+
+    stringify_into_buffer(Object(Prop(key, String(key)), Prop(std::string_view(text, 3), Null())), cpp);
+    munit_assert_string_equal(cpp, "{\"k\\\"ey\":\"k\\\"ey\",\"tab\":null}");
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_hpp_runtime_locale(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    const char *locales[] = { "de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "ru_RU.UTF-8", "German_Germany" };
+    char        cpp[64];
+
+    for (const char *locale : locales) {
+        if (std::setlocale(LC_NUMERIC, locale) != NULL) {
+            break;
+        }
+    }
+
+    stringify_into_buffer(Float(2.75), cpp);
+    std::setlocale(LC_NUMERIC, "C");
+
+    munit_assert_string_equal(cpp, "2.750000");
+
+    return MUNIT_OK;
+}
+
+static MunitTest tests[] = {
+    MUNIT_SIMPLE_TEST_CASE("/hpp/runtime-floats", json_hpp_runtime_floats),
+    MUNIT_SIMPLE_TEST_CASE("/hpp/runtime-tree",   json_hpp_runtime_tree  ),
+    MUNIT_SIMPLE_TEST_CASE("/hpp/runtime-locale", json_hpp_runtime_locale),
+    MUNIT_SIMPLE_TEST_CASE(NULL,                  NULL                   ),
+};
+
+static const MunitSuite suite = MUNIT_SIMPLE_TEST_SUITE("/json", tests);
+
+int main(int argc, char* argv[])
+{
+    return munit_suite_main(&suite, (void*) "static-json-builder-hpp", argc, argv);
+}
@@ -1,6 +1,21 @@
+#if !defined(_WIN32)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <locale.h>
+#include <float.h>
+#include <math.h>
 #include <munit.h>
 #include <static-json-builder.h>
 
+#if defined(STATIC_JSON_BUILDER_THREADS) && defined(_WIN32)
+    #include <windows.h>
+#elif defined(STATIC_JSON_BUILDER_THREADS)
+    #include <pthread.h>
+#endif
+
 #define MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data) \
     do {                                             \
         (void) (params);                             \
@@ -245,6 +260,19 @@ static MunitResult json_object_complete(const MunitParameter params[], void *dat
     return MUNIT_OK;
 }
 
+static MunitResult json_padded_int(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json json = JsonPaddedInt(-42, 8);
+
+    munit_assert(json->type == JSON_VALUE_TYPE_PADDED);
+    munit_assert_int64(json->as.padded->integer, ==, -42);
+    munit_assert_size(json->as.padded->width, ==, 8);
+
+    return MUNIT_OK;
+}
+
 static MunitResult json_stringify_null(const MunitParameter params[], void *data)
 {
     MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
@@ -463,6 +491,48 @@ static MunitResult json_stringify_object_complete(const MunitParameter params[],
     return MUNIT_OK;
 }
 
+static MunitResult json_stringify_padded_int(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json  json   = JsonPaddedInt(-42, 8);
+    char *string = json_stringify(json);
+
+    munit_assert_string_equal(string, "     -42");
+    free(string);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_stringify_padded_wide(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json  json   = JsonPaddedInt(12345678, 4);
+    char *string = json_stringify(json);
+
+    munit_assert_string_equal(string, "12345678");
+    free(string);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_stringify_string_escaped(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json json = JsonObject(
+        JsonProp("quote\"", JsonString("\"back\\slash\"\n\t\x01")),
+    );
+    char *string = json_stringify(json);
+
+    munit_assert_string_equal(string, "{\"quote\\\"\":\"\\\"back\\\\slash\\\"\\n\\t\\u0001\"}");
+    munit_assert_size(json_stingified_size(json), ==, strlen(string) + 1);
+    free(string);
+
+    return MUNIT_OK;
+}
+
 /* ---------------------------------- */
 
 static MunitResult json_size_null(const MunitParameter params[], void *data)
@@ -537,6 +607,34 @@ static MunitResult json_size_int_positive(const MunitParameter params[], void *d
     return MUNIT_OK;
 }
 
+static MunitResult json_size_upper_bound(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json json = JsonObject(
+        JsonProp("min",    JsonInt(INT64_MIN)),
+        JsonProp("max",    JsonFloat(-1.7976931348623157e308)),
+        JsonProp("flag",   JsonBool(false)),
+        JsonProp("text",   JsonString("a\"b\x01")),
+        JsonProp("padded", JsonPaddedInt(5, 32)),
+        JsonProp("items",  JsonArray(JsonNull(), JsonInt(0), JsonFloat(0.5))),
+    );
+
+    size_t bound  = json_stringified_size_upper_bound(json);
+    char  *buffer = malloc(bound);
+    size_t length = json_stringify_into_buffer(json, buffer);
+
+    munit_assert_size(bound, >=, json_stingified_size(json));
+    munit_assert_size(length + 1, ==, json_stingified_size(json));
+    munit_assert_size(strlen(buffer), ==, length);
+    munit_assert_size(json_stringified_size_upper_bound(JsonPaddedInt(5, 32)), ==, 32 + 1);
+    munit_assert_size(json_stringified_size_upper_bound(JsonString("a\n")), ==, strlen("\"a\\n\"") + 1);
+
+    free(buffer);
+
+    return MUNIT_OK;
+}
+
 static MunitResult json_size_float_negative(const MunitParameter params[], void *data)
 {
     MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
@@ -659,6 +757,1810 @@ static MunitResult json_size_object_complete(const MunitParameter params[], void
     return MUNIT_OK;
 }
 
+static MunitResult json_size_padded_int(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json   json = JsonPaddedInt(-42, 8);
+    size_t size = json_stingified_size(json);
+
+    munit_assert_size(size, ==, 8 + 1);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_stringify_capacity(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json json = JsonObject(
+        JsonProp("id",    JsonInt(12)),
+        JsonProp("items", JsonArray(JsonFloat(1.5), JsonString("x"))),
+    );
+
+    const char *expected = "{\"id\":12,\"items\":[1.500000,\"x\"]}";
+
+    char   buffer[4096];
+    char   small[sizeof("{\"id\":12,\"items\":[1.500000,\"x\"]}")];
+    size_t needed = 0;
+
+    munit_assert(json_stringify_into_buffer_n(json, buffer, sizeof(buffer), &needed));
+    munit_assert_string_equal(buffer, expected);
+    munit_assert_size(needed, ==, strlen(expected) + 1);
+
+    memset(small, '#', sizeof(small));
+    munit_assert(json_stringify_into_buffer_n(json, small, sizeof(small), &needed));
+    munit_assert_string_equal(small, expected);
+
+    munit_assert(!json_stringify_into_buffer_n(json, small, sizeof(small) - 1, &needed));
+    munit_assert_size(needed, ==, sizeof(small));
+
+    /* Every capacity around the scratch tail, heap copies let sanitizers catch writes past the capacity */
+    static char    text[1500];
+    static uint8_t bytes[700];
+    json_value_t   floats[64];
+    json_value_t  *entries[64];
+    json_array_t   list  = { .size = 64, .entries = entries };
+    json_value_t   array = { .type = JSON_VALUE_TYPE_ARRAY, .as.array = &list };
+
+    for (size_t i = 0; i < sizeof(text) - 1; i++) {
+        text[i] = i % 50 == 0 ? '"' : (char) ('a' + i % 26);
+    }
+
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        bytes[i] = (uint8_t) (i * 31);
+    }
+
+    for (size_t i = 0; i < 64; i++) {
+        floats[i]  = *JsonFloat((double) i * 1e10 / 3);
+        entries[i] = &floats[i];
+    }
+
+    Json large = JsonObject(
+        JsonProp("floats", &array),
+        JsonProp("text",   JsonString(text)),
+        JsonProp("blob",   JsonBase64(bytes, sizeof(bytes))),
+        JsonProp("padded", JsonPaddedInt(7, 600)),
+    );
+
+    char  *reference = json_stringify(large);
+    size_t length    = strlen(reference);
+
+    for (size_t capacity = 0; capacity <= length + 2; capacity += capacity < 700 || capacity + 700 > length ? 1 : 97) {
+        char *target = malloc(capacity + 1);
+        bool  fits   = json_stringify_into_buffer_n(large, target, capacity, &needed);
+
+        munit_assert(fits == (capacity > length));
+        munit_assert_size(needed, ==, length + 1);
+
+        if (fits) {
+            munit_assert_string_equal(target, reference);
+        }
+
+        free(target);
+    }
+
+    free(reference);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_stringify_reusable_buffer(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    char large[10000];
+    memset(large, 'x', sizeof(large) - 1);
+    large[sizeof(large) - 1] = '\0';
+
+    size_t      length = 0;
+    const char *first  = json_stringify_reusable(JsonArray(JsonInt(1)), &length);
+
+    munit_assert_string_equal(first, "[1]");
+    munit_assert_size(length, ==, 3);
+    munit_assert_ptr_equal(json_stringify_reusable(JsonNull(), &length), first);
+
+    const char *grown = json_stringify_reusable(JsonString(large), &length);
+
+    munit_assert_size(length, ==, sizeof(large) + 1);
+    munit_assert_char(grown[0], ==, '"');
+    munit_assert_ptr_equal(json_stringify_reusable(JsonNull(), &length), grown);
+    munit_assert_string_equal(grown, "null");
+
+    for (size_t i = 0; i < 1024; i++) {
+        munit_assert_not_null(json_stringify_reusable(JsonBool(true), &length));
+    }
+
+    munit_assert_string_equal(json_stringify_reusable(JsonBool(false), &length), "false");
+    json_release_reusable_buffer();
+
+    return MUNIT_OK;
+}
+
+#if defined(STATIC_JSON_BUILDER_THREADS)
+
+#if defined(_WIN32)
+static DWORD WINAPI json_reusable_thread(void *data)
+#else
+static void *json_reusable_thread(void *data)
+#endif
+{
+    size_t length = 0;
+
+    /* Left to the thread exit, leak checkers report the buffer if it isn't released */
+    *(bool *) data = json_stringify_reusable(JsonArray(JsonInt(1), JsonString("thread")), &length) != NULL && length == 12;
+
+#if defined(_WIN32)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static MunitResult json_stringify_reusable_thread(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    bool written = false;
+
+#if defined(_WIN32)
+    HANDLE thread = CreateThread(NULL, 0, json_reusable_thread, &written, 0, NULL);
+
+    munit_assert_not_null(thread);
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_t thread;
+
+    munit_assert_int(pthread_create(&thread, NULL, json_reusable_thread, &written), ==, 0);
+    pthread_join(thread, NULL);
+#endif
+
+    munit_assert_true(written);
+
+    return MUNIT_OK;
+}
+
+#endif
+
+/* ---------------------------------- */
+
+static MunitResult json_patch_render(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json json = JsonObject(
+        JsonProp("name",     JsonString("status")),
+        JsonProp("requests", JsonPaddedInt(7, 6)),
+        JsonProp("history",  JsonArray(JsonInt(1), JsonPaddedInt(-3, 4))),
+    );
+
+    json_slot_t slots[2];
+    char        buffer[64];
+
+    munit_assert_size(json_patchable_slots_count(json), ==, 2);
+    json_render_patchable(json, buffer, slots);
+
+    munit_assert_string_equal(buffer, "{\"name\":\"status\",\"requests\":     7,\"history\":[1,  -3]}");
+    munit_assert_size(slots[0].offset, ==, 28);
+    munit_assert_size(slots[0].width,  ==, 6);
+    munit_assert_size(slots[1].offset, ==, 48);
+    munit_assert_size(slots[1].width,  ==, 4);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_patch_slot_value(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json json = JsonArray(JsonPaddedInt(0, 5), JsonPaddedInt(0, 3));
+
+    json_slot_t slots[2];
+    char        buffer[16];
+
+    json_render_patchable(json, buffer, slots);
+
+    munit_assert(json_patch_slot(buffer, &slots[0], 12345));
+    munit_assert(json_patch_slot(buffer, &slots[1], -9));
+    munit_assert_string_equal(buffer, "[12345, -9]");
+
+    munit_assert(json_patch_slot(buffer, &slots[0], -1));
+    munit_assert_string_equal(buffer, "[   -1, -9]");
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_patch_slot_overflow(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json json = JsonArray(JsonPaddedInt(1, 2));
+
+    json_slot_t slots[1];
+    char        buffer[8];
+
+    json_render_patchable(json, buffer, slots);
+
+    munit_assert(!json_patch_slot(buffer, &slots[0], 100));
+    munit_assert_string_equal(buffer, "[ 1]");
+
+    return MUNIT_OK;
+}
+
+/* ---------------------------------- */
+
+static MunitResult json_msgpack_scalars(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json json = JsonArray(
+        JsonNull(),
+        JsonBool(false),
+        JsonBool(true),
+        JsonInt(5),
+        JsonInt(-3),
+        JsonInt(200),
+        JsonInt(-200),
+        JsonInt(70000),
+        JsonInt(-5000000000),
+        JsonFloat(1.5),
+        JsonPaddedInt(7, 4)
+    );
+
+    const uint8_t expected[] = {
+        0x9b,
+        0xc0,
+        0xc2,
+        0xc3,
+        0x05,
+        0xfd,
+        0xcc, 0xc8,
+        0xd1, 0xff, 0x38,
+        0xce, 0x00, 0x01, 0x11, 0x70,
+        0xd3, 0xff, 0xff, 0xff, 0xfe, 0xd5, 0xfa, 0x0e, 0x00,
+        0xcb, 0x3f, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x07,
+    };
+
+    size_t   size   = 0;
+    uint8_t *buffer = json_encode_msgpack(json, &size);
+
+    munit_assert_size(size, ==, sizeof(expected));
+    munit_assert_size(json_encode_msgpack_size(json), ==, sizeof(expected));
+    munit_assert_memory_equal(sizeof(expected), buffer, expected);
+    free(buffer);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_msgpack_object(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json json = JsonObject(
+        JsonProp("a",     JsonString("xyz")),
+        JsonProp("empty", JsonArray()),
+        JsonProp("obj",   JsonObject()),
+    );
+
+    const uint8_t expected[] = {
+        0x83,
+        0xa1, 'a', 0xa3, 'x', 'y', 'z',
+        0xa5, 'e', 'm', 'p', 't', 'y', 0x90,
+        0xa3, 'o', 'b', 'j', 0x80,
+    };
+
+    uint8_t buffer[sizeof(expected)];
+
+    munit_assert_size(json_encode_msgpack_size(json), ==, sizeof(expected));
+    json_encode_msgpack_into_buffer(json, buffer);
+    munit_assert_memory_equal(sizeof(expected), buffer, expected);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_msgpack_long_string(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    char string[301];
+    memset(string, 'x', sizeof(string) - 1);
+    string[sizeof(string) - 1] = '\0';
+
+    Json     json   = JsonString(string);
+    size_t   size   = 0;
+    uint8_t *buffer = json_encode_msgpack(json, &size);
+
+    munit_assert_size(size, ==, 3 + 300);
+    munit_assert_uint8(buffer[0], ==, 0xda);
+    munit_assert_uint8(buffer[1], ==, 0x01);
+    munit_assert_uint8(buffer[2], ==, 0x2c);
+    munit_assert_memory_equal(300, buffer + 3, string);
+    free(buffer);
+
+    return MUNIT_OK;
+}
+
+/* ---------------------------------- */
+
+static MunitResult json_parse_scalars(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    char         text[] = " [null, true, false, -12, 0, 1.5e2, 9223372036854775808, \"str\"] ";
+    char         memory[1024];
+    json_pool_t  pool;
+    Json         json = NULL;
+
+    json_pool_init(&pool, memory, sizeof(memory));
+    munit_assert_int(json_parse(text, strlen(text), &pool, &json), ==, JSON_PARSE_OK);
+
+    munit_assert(json->type == JSON_VALUE_TYPE_ARRAY);
+    munit_assert_size(json->as.array->size, ==, 8);
+    munit_assert(json->as.array->entries[0]->type == JSON_VALUE_TYPE_NULL);
+    munit_assert(json->as.array->entries[1]->as.boolean == true);
+    munit_assert(json->as.array->entries[2]->as.boolean == false);
+    munit_assert_int64(json->as.array->entries[3]->as.integer, ==, -12);
+    munit_assert_int64(json->as.array->entries[4]->as.integer, ==, 0);
+    munit_assert(json->as.array->entries[5]->type == JSON_VALUE_TYPE_FLOAT);
+    munit_assert_double_equal(json->as.array->entries[5]->as.floating, 150.0, 6);
+    munit_assert(json->as.array->entries[6]->type == JSON_VALUE_TYPE_FLOAT);
+    munit_assert_string_equal(json->as.array->entries[7]->as.string, "str");
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_parse_round_trip(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    char         text[] = "{ \"id\" : 7, \"tags\": [\"a\\\"b\", \"\\u00e9\\ud83d\\ude00\\n\"], \"nested\": {\"empty\": {}, \"list\": []} }";
+    char         memory[1024];
+    json_pool_t  pool;
+    Json         json = NULL;
+
+    json_pool_init(&pool, memory, sizeof(memory));
+    munit_assert_int(json_parse(text, strlen(text), &pool, &json), ==, JSON_PARSE_OK);
+
+    munit_assert_string_equal(json->as.object->props[1]->entry->as.array->entries[0]->as.string, "a\"b");
+    munit_assert_string_equal(json->as.object->props[1]->entry->as.array->entries[1]->as.string, "\xc3\xa9\xf0\x9f\x98\x80\n");
+
+    json->as.object->props[0]->entry->as.integer = 8;
+
+    char *string = json_stringify(json);
+    munit_assert_string_equal(string, "{\"id\":8,\"tags\":[\"a\\\"b\",\"\xc3\xa9\xf0\x9f\x98\x80\\n\"],\"nested\":{\"empty\":{},\"list\":[]}}");
+    free(string);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_parse_errors(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    const char *invalid[] = { "", "[1,]", "{\"a\" 1}", "01", "[1] 2", "\"\\x\"", "\"open", "tru", "-", "1.", "\"\\ud800\"" };
+    char        memory[256];
+    json_pool_t pool;
+    Json        json = NULL;
+
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        char text[32];
+        strcpy(text, invalid[i]);
+
+        json_pool_init(&pool, memory, sizeof(memory));
+        munit_assert_int(json_parse(text, strlen(text), &pool, &json), ==, JSON_PARSE_ERROR_SYNTAX);
+        munit_assert_size(pool.bottom, ==, 0);
+    }
+
+    /* Valid json, but the zero character can't be held by a zero terminated string */
+    char          zero[] = "[\"a\\u0000b\"]";
+    json_cursor_t cursor;
+    char          string[8];
+
+    json_pool_init(&pool, memory, sizeof(memory));
+    munit_assert_int(json_parse(zero, strlen(zero), &pool, &json), ==, JSON_PARSE_ERROR_NUL_CHARACTER);
+
+    json_cursor_init(&cursor, "[\"a\\u0000b\"]", strlen("[\"a\\u0000b\"]"));
+    munit_assert_true(json_cursor_find_index(&cursor, 0));
+    munit_assert_false(json_cursor_get_string(&cursor, string, sizeof(string)));
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_parse_limits(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    static char deep_memory[65536];
+    char        deep[2048];
+    char        text[] = "[1, 2, 3, 4, 5, 6, 7, 8]";
+    char        memory[64];
+    json_pool_t pool;
+    Json        json = NULL;
+
+    memset(deep, '[', sizeof(deep));
+
+    json_pool_init(&pool, deep_memory, sizeof(deep_memory));
+    munit_assert_int(json_parse(deep, sizeof(deep), &pool, &json), ==, JSON_PARSE_ERROR_DEPTH);
+
+    json_pool_init(&pool, memory, sizeof(memory));
+    munit_assert_int(json_parse(text, strlen(text), &pool, &json), ==, JSON_PARSE_ERROR_POOL_EXHAUSTED);
+
+    return MUNIT_OK;
+}
+
+/* ---------------------------------- */
+
+static MunitResult json_parse_locale(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    /* Comma-decimal locales are tried in turn, the checks still run in "C" if none is installed */
+    const char *locales[] = { "de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "ru_RU.UTF-8", "German_Germany" };
+
+    for (size_t i = 0; i < sizeof(locales) / sizeof(locales[0]); i++) {
+        if (setlocale(LC_NUMERIC, locales[i]) != NULL) {
+            break;
+        }
+    }
+
+    char          text[]   = "[1.5,-0.25e1,3E-2,0.1]";
+    char          memory[1024];
+    json_pool_t   pool;
+    json_cursor_t cursor;
+    json_value_t  value;
+    Json          json     = NULL;
+
+    json_pool_init(&pool, memory, sizeof(memory));
+    munit_assert_int(json_parse(text, strlen(text), &pool, &json), ==, JSON_PARSE_OK);
+    munit_assert_double(json->as.array->entries[0]->as.floating, ==, 1.5);
+    munit_assert_double(json->as.array->entries[1]->as.floating, ==, -2.5);
+    munit_assert_double(json->as.array->entries[2]->as.floating, ==, 0.03);
+    munit_assert_double(json->as.array->entries[3]->as.floating, ==, 0.1);
+
+    json_cursor_init(&cursor, "[2.75]", strlen("[2.75]"));
+    munit_assert(json_cursor_find_index(&cursor, 0));
+    munit_assert(json_cursor_get_value(&cursor, &value, NULL, 0));
+    munit_assert_double(value.as.floating, ==, 2.75);
+
+    char *string = json_stringify(json);
+    munit_assert_string_equal(string, "[1.500000,-2.500000,0.030000,0.100000]");
+    free(string);
+
+    setlocale(LC_NUMERIC, "C");
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_parse_floats(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    /* Halfway cases, subnormals, overflow and digits beyond what a double can hold */
+    const char *numbers[] = {
+        "0.1", "2.2250738585072011e-308", "2.2250738585072012e-308", "4.9406564584124654e-324",
+        "2.4703282292062327e-324", "2.4703282292062328e-324", "1.7976931348623157e308",
+        "1.7976931348623158e308", "1.7976931348623159e308", "1e-400", "-1e400", "9007199254740993.0",
+        "9007199254740993.00000000000000000000000000000000000000000000000000000000000000000000000001",
+        "123456789012345678901234567890e-30", "0.000000000000000000000000000000000000000000001e45",
+        "7.0e-10", "8.98846567431158e307", "-0.0", "1E+22", "1e23",
+    };
+
+    char        memory[256];
+    char        text[128];
+    json_pool_t pool;
+    Json        json = NULL;
+
+    for (size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++) {
+        double expected = strtod(numbers[i], NULL);
+
+        strcpy(text, numbers[i]);
+        json_pool_init(&pool, memory, sizeof(memory));
+        munit_assert_int(json_parse(text, strlen(text), &pool, &json), ==, JSON_PARSE_OK);
+        munit_assert_memory_equal(sizeof(double), &json->as.floating, &expected);
+    }
+
+    uint64_t state = 0x9e3779b97f4a7c15;
+
+    for (size_t i = 0; i < 20000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        double floating;
+
+        memcpy(&floating, &state, sizeof(floating));
+
+        if (floating != floating || floating - floating != 0) {
+            continue;
+        }
+
+        snprintf(text, sizeof(text), i % 2 ? "%.17e" : "%.16e", floating);
+
+        json_pool_init(&pool, memory, sizeof(memory));
+        munit_assert_int(json_parse(text, strlen(text), &pool, &json), ==, JSON_PARSE_OK);
+        munit_assert_memory_equal(sizeof(double), &json->as.floating, &floating);
+    }
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_cursor_fields(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    const char text[] =
+        "{"
+            "\"payload\": {\"items\": [1, {\"id\": 2, \"s\": \"}]\\\"\"}, [[]]], \"id\": -1},"
+            "\"type\": \"order\\u0021\","
+            "\"id\": 42,"
+            "\"price\": 1.25,"
+            "\"long\": 1.00000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001,"
+            "\"wide\": 123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890,"
+            "\"ok\": true"
+        "}";
+
+    json_cursor_t root;
+    json_cursor_init(&root, text, strlen(text));
+
+    json_cursor_t id    = root;
+    json_cursor_t type  = root;
+    json_cursor_t price = root;
+    json_cursor_t large = root;
+    json_cursor_t wide  = root;
+    json_cursor_t ok    = root;
+
+    int64_t      integer = 0;
+    char         buffer[16];
+    json_value_t value;
+
+    munit_assert(json_cursor_find_key(&id, "id"));
+    munit_assert(json_cursor_get_int(&id, &integer));
+    munit_assert_int64(integer, ==, 42);
+
+    munit_assert(json_cursor_find_key(&type, "type"));
+    munit_assert(json_cursor_get_string(&type, buffer, sizeof(buffer)));
+    munit_assert_string_equal(buffer, "order!");
+
+    munit_assert(json_cursor_find_key(&price, "price"));
+    munit_assert(!json_cursor_get_int(&price, &integer));
+    munit_assert(json_cursor_get_value(&price, &value, NULL, 0));
+    munit_assert(value.type == JSON_VALUE_TYPE_FLOAT);
+    munit_assert_double_equal(value.as.floating, 1.25, 6);
+
+    /* Numbers longer than any fixed scratch buffer are read in place */
+    munit_assert(json_cursor_find_key(&large, "long"));
+    munit_assert(json_cursor_get_value(&large, &value, NULL, 0));
+    munit_assert(value.type == JSON_VALUE_TYPE_FLOAT);
+    munit_assert_double(value.as.floating, ==, 1.0);
+
+    munit_assert(json_cursor_find_key(&wide, "wide"));
+    munit_assert(json_cursor_get_value(&wide, &value, NULL, 0));
+    munit_assert(value.type == JSON_VALUE_TYPE_FLOAT);
+    munit_assert_double(value.as.floating, ==, 123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890.0);
+
+    munit_assert(json_cursor_find_key(&ok, "ok"));
+    munit_assert(json_cursor_get_value(&ok, &value, NULL, 0));
+    munit_assert(value.type == JSON_VALUE_TYPE_BOOL && value.as.boolean);
+
+    munit_assert(!json_cursor_find_key(&root, "missing"));
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_cursor_nested(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    const char text[] = " { \"a\" : [ 10 , { \"b\" : \"deep\" } , null ] } ";
+
+    json_cursor_t cursor;
+    json_cursor_init(&cursor, text, strlen(text));
+
+    char         buffer[8];
+    json_value_t value;
+
+    munit_assert(json_cursor_find_key(&cursor, "a"));
+    munit_assert(!json_cursor_find_index(&cursor, 3));
+
+    json_cursor_t null = cursor;
+    munit_assert(json_cursor_find_index(&null, 2));
+    munit_assert(json_cursor_get_value(&null, &value, NULL, 0));
+    munit_assert(value.type == JSON_VALUE_TYPE_NULL);
+
+    munit_assert(json_cursor_find_index(&cursor, 1));
+    munit_assert(json_cursor_find_key(&cursor, "b"));
+    munit_assert(json_cursor_get_value(&cursor, &value, buffer, sizeof(buffer)));
+    munit_assert(value.type == JSON_VALUE_TYPE_STRING);
+    munit_assert_string_equal(value.as.string, "deep");
+
+    munit_assert(!json_cursor_get_string(&cursor, buffer, 4));
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_cursor_truncated(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    /* Texts end right after a backslash, copies on the heap let sanitizers catch reads past the end */
+    const char *texts[] = { "{\"a\\", "[\"\\", "{\"a\":\"x\\", "[1,\"x\\" };
+    char       *copies[4];
+    size_t      lengths[4];
+
+    char          buffer[8];
+    json_value_t  value;
+    json_cursor_t cursor;
+
+    for (size_t i = 0; i < 4; i++) {
+        lengths[i] = strlen(texts[i]);
+        copies[i]  = memcpy(malloc(lengths[i]), texts[i], lengths[i]);
+
+        json_cursor_init(&cursor, copies[i], lengths[i]);
+        munit_assert(!json_cursor_find_key(&cursor, "b"));
+
+        json_cursor_init(&cursor, copies[i], lengths[i]);
+        munit_assert(!json_cursor_find_index(&cursor, 2));
+
+        json_cursor_init(&cursor, copies[i], lengths[i]);
+        munit_assert(!json_cursor_get_value(&cursor, &value, buffer, sizeof(buffer)));
+    }
+
+    json_cursor_init(&cursor, copies[1], lengths[1]);
+    munit_assert(json_cursor_find_index(&cursor, 0));
+    munit_assert(!json_cursor_get_value(&cursor, &value, buffer, sizeof(buffer)));
+
+    json_cursor_init(&cursor, copies[2], lengths[2]);
+    munit_assert(json_cursor_find_key(&cursor, "a"));
+    munit_assert(!json_cursor_get_value(&cursor, &value, buffer, sizeof(buffer)));
+
+    json_cursor_init(&cursor, copies[3], lengths[3]);
+    munit_assert(json_cursor_find_index(&cursor, 1));
+    munit_assert(!json_cursor_get_value(&cursor, &value, buffer, sizeof(buffer)));
+
+    for (size_t i = 0; i < 4; i++) {
+        free(copies[i]);
+    }
+
+    return MUNIT_OK;
+}
+
+/* ---------------------------------- */
+
+static MunitResult json_clone_contiguous(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    char name[] = "name";
+
+    Json json = JsonObject(
+        JsonProp(name,    JsonString(name)),
+        JsonProp("list",  JsonArray(JsonInt(1), JsonFloat(2.5), JsonNull(), JsonArray(), JsonObject())),
+        JsonProp("slot",  JsonPaddedInt(3, 4)),
+        JsonProp("flag",  JsonBool(true)),
+    );
+
+    Json clone = json_clone_into(json, malloc(json_clone_size(json)));
+
+    strcpy(name, "gone");
+    json->as.object->props[1]->entry->as.array->entries[0]->as.integer = 100;
+
+    char *string = json_stringify(clone);
+    munit_assert_string_equal(string, "{\"name\":\"name\",\"list\":[1,2.500000,null,[],{}],\"slot\":   3,\"flag\":true}");
+    free(string);
+
+    free(clone);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_clone_size_bounds(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json   json = JsonArray(JsonString("abc"), JsonObject(JsonProp("k", JsonInt(1))));
+    size_t size = json_clone_size(json);
+    char  *end  = NULL;
+
+    char *buffer = malloc(size);
+    Json  clone  = json_clone_into(json, buffer);
+
+    munit_assert_ptr_equal(clone, buffer);
+
+    end = (char *) clone->as.array->entries[1]->as.object->props[0]->entry + sizeof(json_value_t);
+    munit_assert(end <= buffer + size);
+    munit_assert((char *) clone->as.array->entries[0]->as.string >= buffer);
+    munit_assert_ptr_not_equal(clone->as.array->entries[0]->as.string, json->as.array->entries[0]->as.string);
+
+    free(buffer);
+
+    return MUNIT_OK;
+}
+
+/* ---------------------------------- */
+
+static MunitResult json_snapshot_round_trip(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json json = JsonObject(
+        JsonProp("name",  JsonString("catalog \"v1\"")),
+        JsonProp("items", JsonArray(JsonInt(-1), JsonFloat(0.5), JsonNull(), JsonBool(false), JsonArray(), JsonObject())),
+        JsonProp("slot",  JsonPaddedInt(12, 5)),
+    );
+
+    size_t size     = json_snapshot_size(json);
+    void  *snapshot = malloc(size);
+    void  *moved    = malloc(size);
+
+    json_snapshot_write(json, snapshot);
+    memcpy(moved, snapshot, size);
+    memset(snapshot, 0, size);
+
+    json_value_t view;
+    munit_assert(json_snapshot_view(moved, size, &view));
+
+    char *expected = json_stringify(json);
+    char *string   = json_stringify(&view);
+
+    munit_assert_string_equal(string, expected);
+    munit_assert_size(json_stingified_size(&view), ==, json_stingified_size(json));
+    munit_assert_size(json_patchable_slots_count(JsonArray(&view)), ==, 1);
+
+    size_t   msgpack_size     = 0;
+    size_t   msgpack_expected = 0;
+    uint8_t *msgpack          = json_encode_msgpack(JsonArray(&view, JsonNull()), &msgpack_size);
+    uint8_t *msgpack_tree     = json_encode_msgpack(JsonArray(json,  JsonNull()), &msgpack_expected);
+
+    munit_assert_size(msgpack_size, ==, msgpack_expected);
+    munit_assert_memory_equal(msgpack_size, msgpack, msgpack_tree);
+
+    free(msgpack);
+    free(msgpack_tree);
+    free(expected);
+    free(string);
+    free(snapshot);
+    free(moved);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_snapshot_invalid(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json   json     = JsonArray(JsonInt(1));
+    size_t size     = json_snapshot_size(json);
+    char  *snapshot = malloc(size);
+
+    json_value_t view;
+    json_snapshot_write(json, snapshot);
+
+    munit_assert(!json_snapshot_view(snapshot, size - 1, &view));
+    munit_assert(!json_snapshot_view(snapshot, 8, &view));
+
+    snapshot[0] = 'X';
+    munit_assert(!json_snapshot_view(snapshot, size, &view));
+
+    free(snapshot);
+
+    return MUNIT_OK;
+}
+
+/* ---------------------------------- */
+
+static bool json_generate_squares(void *context, size_t index, json_value_t *entry)
+{
+    size_t *count = context;
+
+    if (index >= *count) {
+        return false;
+    }
+
+    entry->type       = JSON_VALUE_TYPE_INT;
+    entry->as.integer = (int64_t) (index * index);
+
+    return true;
+}
+
+static bool json_generate_fields(void *context, size_t index, json_prop_t *property)
+{
+    static const char       *keys[] = { "id", "name", "slot" };
+    static json_padded_int_t slot   = { .integer = 3, .width = 4 };
+
+    (void) context;
+
+    if (index >= sizeof(keys) / sizeof(keys[0])) {
+        return false;
+    }
+
+    property->key = keys[index];
+
+    switch (index) {
+    case 0:
+        property->entry->type       = JSON_VALUE_TYPE_INT;
+        property->entry->as.integer = 7;
+        break;
+    case 1:
+        property->entry->type      = JSON_VALUE_TYPE_STRING;
+        property->entry->as.string = "row";
+        break;
+    default:
+        property->entry->type      = JSON_VALUE_TYPE_PADDED;
+        property->entry->as.padded = &slot;
+        break;
+    }
+
+    return true;
+}
+
+static MunitResult json_generator_array(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    size_t count = 4;
+    size_t empty = 0;
+
+    Json json = JsonArray(
+        JsonArrayGenerator(json_generate_squares, &count),
+        JsonArrayGenerator(json_generate_squares, &empty),
+    );
+
+    char *string = json_stringify(json);
+
+    munit_assert_string_equal(string, "[[0,1,4,9],[]]");
+    munit_assert_size(json_stingified_size(json), ==, strlen(string) + 1);
+
+    /* Generator contexts can't be copied, so trees with generators are not cloned */
+    json_value_t scratch;
+
+    munit_assert_size(json_clone_size(json), ==, 0);
+    munit_assert_null(json_clone_into(json, &scratch));
+
+    free(string);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_generator_object(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json json = JsonObjectGenerator(json_generate_fields, NULL);
+
+    char *string = json_stringify(json);
+
+    munit_assert_string_equal(string, "{\"id\":7,\"name\":\"row\",\"slot\":   3}");
+    munit_assert_size(json_stingified_size(json), ==, strlen(string) + 1);
+    munit_assert_size(json_patchable_slots_count(json), ==, 1);
+
+    const uint8_t expected[] = {
+        0x83,
+        0xa2, 'i', 'd', 0x07,
+        0xa4, 'n', 'a', 'm', 'e', 0xa3, 'r', 'o', 'w',
+        0xa4, 's', 'l', 'o', 't', 0x03,
+    };
+
+    uint8_t buffer[sizeof(expected)];
+
+    munit_assert_size(json_encode_msgpack_size(json), ==, sizeof(expected));
+    json_encode_msgpack_into_buffer(json, buffer);
+    munit_assert_memory_equal(sizeof(expected), buffer, expected);
+
+    free(string);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_generator_snapshot(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    size_t count = 3;
+    Json   json  = JsonArray(
+        JsonArrayGenerator(json_generate_squares, &count),
+        JsonObjectGenerator(json_generate_fields, NULL),
+    );
+
+    size_t size     = json_snapshot_size(json);
+    void  *snapshot = malloc(size);
+
+    json_value_t view;
+    json_snapshot_write(json, snapshot);
+    munit_assert(json_snapshot_view(snapshot, size, &view));
+
+    char *expected = json_stringify(json);
+    char *string   = json_stringify(&view);
+
+    munit_assert_string_equal(string, expected);
+
+    free(expected);
+    free(string);
+    free(snapshot);
+
+    return MUNIT_OK;
+}
+
+/* ---------------------------------- */
+
+typedef struct trade_t
+{
+    int64_t quantity;
+    double  price;
+} trade_t;
+
+typedef struct order_t
+{
+    int64_t     id;
+    const char *symbol;
+    double      price;
+    bool        active;
+    trade_t     trade;
+} order_t;
+
+JSON_DESCRIBE(trade_t,
+    JSON_FIELD_INT(quantity),
+    JSON_FIELD_FLOAT(price)
+)
+
+JSON_DESCRIBE(order_t,
+    JSON_FIELD_INT(id),
+    JSON_FIELD_STRING(symbol),
+    JSON_FIELD_NAMED(FLOAT, price, "px"),
+    JSON_FIELD_BOOL(active),
+    JSON_FIELD_OBJECT(trade, trade_t)
+)
+
+static MunitResult json_describe_struct(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    order_t order = {
+        .id     = INT64_MIN,
+        .symbol = "AB\"C\n",
+        .price  = -12.5,
+        .active = false,
+        .trade  = { .quantity = 300, .price = 0.25 },
+    };
+
+    Json json = JsonObject(
+        JsonProp("id",     JsonInt(order.id)),
+        JsonProp("symbol", JsonString(order.symbol)),
+        JsonProp("px",     JsonFloat(order.price)),
+        JsonProp("active", JsonBool(order.active)),
+        JsonProp("trade",  JsonObject(
+            JsonProp("quantity", JsonInt(order.trade.quantity)),
+            JsonProp("price",    JsonFloat(order.trade.price)),
+        )),
+    );
+
+    char  *expected = json_stringify(json);
+    size_t size     = json_stringified_size_order_t(&order);
+    char  *buffer   = malloc(size);
+
+    munit_assert_size(size, ==, json_stingified_size(json));
+    munit_assert_size(json_stringify_order_t_into_buffer(&order, buffer), ==, size - 1);
+    munit_assert_string_equal(buffer, expected);
+
+    free(expected);
+    free(buffer);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_describe_formatters(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    static const struct { int64_t value; const char *text; } integers[] = {
+        { INT64_MIN, "-9223372036854775808" },
+        { INT64_MAX, "9223372036854775807"  },
+        { 0,         "0"                    },
+        { -1,        "-1"                   },
+    };
+
+    static const struct { double value; const char *text; } floats[] = {
+        { 0.0,       "0.000000"  },
+        { -0.0,      "-0.000000" },
+        { 5e-324,    "0.000000"  },
+        { -5e-324,   "-0.000000" },
+        { 0.0000005, "0.000000"  },
+        { 0.0000015, "0.000002"  },
+        { 0.0000025, "0.000003"  },
+        { 2.5,       "2.500000"  },
+        { NAN,       "nan"       },
+        { INFINITY,  "inf"       },
+        { -INFINITY, "-inf"      },
+        { DBL_MAX,   "179769313486231570814527423731704356798070567525844996598917476803157260780028538760589558632766878171540458953514382464234321326889464182768467546703537516986049910576551282076245490090389328944075868508455133942304583236903222948165808559332123348274797826204144723168738177180919299881250404026184124858368.000000" },
+    };
+
+    char text[400];
+
+    for (size_t i = 0; i < sizeof(integers) / sizeof(integers[0]); i++) {
+        char *end = json_int_text_write(text, integers[i].value);
+
+        munit_assert_size(json_int_text_size(integers[i].value), ==, strlen(integers[i].text));
+        munit_assert_size((size_t) (end - text), ==, strlen(integers[i].text));
+        munit_assert_memory_equal(strlen(integers[i].text), text, integers[i].text);
+    }
+
+    for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++) {
+        char *end = json_float_text_write(text, floats[i].value);
+
+        munit_assert_size(json_float_text_size(floats[i].value), ==, strlen(floats[i].text));
+        munit_assert_size((size_t) (end - text), ==, strlen(floats[i].text));
+        munit_assert_memory_equal(strlen(floats[i].text), text, floats[i].text);
+    }
+
+    return MUNIT_OK;
+}
+
+/* ---------------------------------- */
+
+static MunitResult json_table_rows(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    const char  *keys[]   = { "id", "name\"", "slot" };
+    json_value_t values[] = {
+        *JsonInt(1),          *JsonInt(2),
+        *JsonString("a"),     *JsonNull(),
+        *JsonPaddedInt(7, 3), *JsonPaddedInt(8, 3),
+    };
+
+    Json json = JsonTable(keys, values, 3, 2);
+    Json rows = JsonArray(
+        JsonObject(JsonProp("id", JsonInt(1)), JsonProp("name\"", JsonString("a")), JsonProp("slot", JsonPaddedInt(7, 3))),
+        JsonObject(JsonProp("id", JsonInt(2)), JsonProp("name\"", JsonNull()),      JsonProp("slot", JsonPaddedInt(8, 3))),
+    );
+
+    char *string   = json_stringify(json);
+    char *expected = json_stringify(rows);
+
+    munit_assert_string_equal(string, "[{\"id\":1,\"name\\\"\":\"a\",\"slot\":  7},{\"id\":2,\"name\\\"\":null,\"slot\":  8}]");
+    munit_assert_string_equal(string, expected);
+    munit_assert_size(json_stingified_size(json), ==, strlen(expected) + 1);
+    munit_assert_size(json_patchable_slots_count(json), ==, 2);
+
+    size_t   msgpack_size     = 0;
+    size_t   msgpack_expected = 0;
+    uint8_t *msgpack          = json_encode_msgpack(json, &msgpack_size);
+    uint8_t *msgpack_rows     = json_encode_msgpack(rows, &msgpack_expected);
+
+    munit_assert_size(msgpack_size, ==, msgpack_expected);
+    munit_assert_memory_equal(msgpack_size, msgpack, msgpack_rows);
+
+    size_t size     = json_snapshot_size(json);
+    void  *snapshot = malloc(size);
+
+    json_value_t view;
+    json_snapshot_write(json, snapshot);
+    munit_assert(json_snapshot_view(snapshot, size, &view));
+
+    char *viewed = json_stringify(&view);
+    munit_assert_string_equal(viewed, expected);
+
+    void *buffer = malloc(json_clone_size(json));
+    char *cloned = json_stringify(json_clone_into(json, buffer));
+
+    munit_assert_string_equal(cloned, expected);
+
+    free(cloned);
+    free(buffer);
+    free(viewed);
+    free(snapshot);
+    free(msgpack);
+    free(msgpack_rows);
+    free(string);
+    free(expected);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_table_shapes(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    char         names[100][4];
+    const char  *keys[100];
+    json_value_t values[200];
+
+    for (size_t i = 0; i < 100; i++) {
+        names[i][0] = (char) ('a' + i / 26 % 26);
+        names[i][1] = (char) ('a' + i % 26);
+        names[i][2] = (char) ('0' + i / 10 % 10);
+        names[i][3] = '\0';
+
+        keys[i]           = names[i];
+        values[i * 2]     = *JsonInt((int64_t) i);
+        values[i * 2 + 1] = *JsonBool(i % 2 == 0);
+    }
+
+    Json  json   = JsonTable(keys, values, 100, 2);
+    char *string = json_stringify(json);
+
+    munit_assert_size(json_stingified_size(json), ==, strlen(string) + 1);
+    munit_assert_not_null(strstr(string, ",\"dt9\":97,\"du9\":98,\"dv9\":99},{\"aa0\":true,\"ab0\":false,"));
+    munit_assert_not_null(strstr(string, ",\"dt9\":false,\"du9\":true,\"dv9\":false}]"));
+
+    free(string);
+
+    string = json_stringify(JsonArray(JsonTable(keys, values, 100, 0), JsonTable(keys, values, 0, 2)));
+    munit_assert_string_equal(string, "[[],[{},{}]]");
+    free(string);
+
+    return MUNIT_OK;
+}
+
+#if defined(STATIC_JSON_BUILDER_THREADS)
+
+static MunitResult json_pipeline_fd(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    static char        names[64][4];
+    static const char *keys[64];
+    static json_value_t values[64 * 500];
+    static char         text[20000];
+
+    for (size_t i = 0; i < 64; i++) {
+        names[i][0] = (char) ('a' + i / 26);
+        names[i][1] = (char) ('a' + i % 26);
+        names[i][2] = '"';
+        names[i][3] = '\0';
+        keys[i]     = names[i];
+    }
+
+    for (size_t i = 0; i < 64 * 500; i++) {
+        values[i] = i % 3 == 0 ? *JsonInt((int64_t) i * 7919) : i % 3 == 1 ? *JsonFloat((double) i / 3) : *JsonString(names[i % 64]);
+    }
+
+    for (size_t i = 0; i < sizeof(text) - 1; i++) {
+        text[i] = i % 97 == 0 ? '\n' : (char) ('a' + i % 26);
+    }
+
+    Json  json     = JsonObject(JsonProp("rows", JsonTable(keys, values, 64, 500)), JsonProp("text", JsonString(text)), JsonProp("padded", JsonPaddedInt(7, 5000)));
+    char *expected = json_stringify(json);
+    FILE *file     = tmpfile();
+
+    munit_assert_not_null(file);
+    munit_assert_true(json_stringify_to_fd_pipelined(json, fileno(file), 4096, 2));
+
+    size_t length = strlen(expected);
+    char  *actual = malloc(length + 1);
+
+    munit_assert_size((size_t) ftell(file), ==, length);
+    rewind(file);
+    munit_assert_size(fread(actual, 1, length + 1, file), ==, length);
+    munit_assert_memory_equal(length, actual, expected);
+
+    fclose(file);
+    free(actual);
+    free(expected);
+
+    munit_assert_false(json_stringify_to_fd_pipelined(json, -1, 0, 0));
+
+    return MUNIT_OK;
+}
+
+typedef struct json_log_producer_t
+{
+    json_log_t *log;
+    const char *text;
+    size_t      id;
+    size_t      records;
+    size_t      rejected;
+} json_log_producer_t;
+
+#if defined(_WIN32)
+static DWORD WINAPI json_log_producer(LPVOID argument)
+#else
+static void *json_log_producer(void *argument)
+#endif
+{
+    json_log_producer_t *producer = argument;
+
+    /* Records of varying sizes make the ring wrap at every possible offset */
+    for (size_t i = 0; i < producer->records; i++) {
+        Json json = JsonObject(
+            JsonProp("producer", JsonInt((int64_t) producer->id)),
+            JsonProp("record",   JsonInt((int64_t) i)),
+            JsonProp("text",     JsonString(producer->text + 2999 - i % 3000)),
+        );
+
+        producer->rejected += !json_log_write(producer->log, json);
+    }
+
+#if defined(_WIN32)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static MunitResult json_log_writer(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    enum { PRODUCERS = 4, RECORDS = 2000 };
+
+    static char         text[40000];
+    json_log_producer_t producers[PRODUCERS];
+    size_t              next[PRODUCERS] = { 0 };
+    FILE               *file            = tmpfile();
+    json_log_t         *log             = NULL;
+
+    for (size_t i = 0; i < sizeof(text) - 1; i++) {
+        text[i] = (char) ('a' + i % 26);
+    }
+
+    munit_assert_not_null(file);
+    log = json_log_open(fileno(file), 0);
+    munit_assert_not_null(log);
+
+#if defined(_WIN32)
+    HANDLE threads[PRODUCERS];
+#else
+    pthread_t threads[PRODUCERS];
+#endif
+
+    for (size_t i = 0; i < PRODUCERS; i++) {
+        producers[i] = (json_log_producer_t) { .log = log, .text = text + sizeof(text) - 3000, .id = i, .records = RECORDS, .rejected = 0 };
+#if defined(_WIN32)
+        threads[i] = CreateThread(NULL, 0, json_log_producer, &producers[i], 0, NULL);
+#else
+        munit_assert_int(pthread_create(&threads[i], NULL, json_log_producer, &producers[i]), ==, 0);
+#endif
+    }
+
+    for (size_t i = 0; i < PRODUCERS; i++) {
+#if defined(_WIN32)
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+        munit_assert_size(producers[i].rejected, ==, 0);
+    }
+
+    munit_assert_false(json_log_write(log, JsonString(text)));
+    munit_assert_true(json_log_close(log));
+
+    /* Every line is a whole record and records of one producer keep their order */
+    char   line[4096];
+    size_t lines = 0;
+
+    rewind(file);
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        size_t producer = 0;
+        size_t record   = 0;
+        int    offset   = 0;
+
+        munit_assert_int(sscanf(line, "{\"producer\":%zu,\"record\":%zu,\"text\":\"%n", &producer, &record, &offset), ==, 2);
+        munit_assert_size(producer, <, PRODUCERS);
+        munit_assert_size(record, ==, next[producer]);
+        munit_assert_size(strlen(line + offset), ==, record % 3000 + strlen("\"}\n"));
+
+        next[producer]++;
+        lines++;
+    }
+
+    munit_assert_size(lines, ==, PRODUCERS * RECORDS);
+
+    fclose(file);
+
+    return MUNIT_OK;
+}
+
+#endif
+
+static MunitResult json_compact_values(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    json_compact_t compact = JsonCompactObject(
+        JsonCompactProp("null", JsonCompactNull()),
+        JsonCompactProp("bools", JsonCompactArray(JsonCompactBool(true), JsonCompactBool(false))),
+        JsonCompactProp("ints", JsonCompactArray(JsonCompactInt(0), JsonCompactInt(-1), JsonCompactInt(JSON_COMPACT_INT_MIN),
+                                                 JsonCompactInt(JSON_COMPACT_INT_MAX), JsonCompactInt(INT64_MIN), JsonCompactInt(INT64_MAX))),
+        JsonCompactProp("floats", JsonCompactArray(JsonCompactFloat(1.5), JsonCompactFloat(-0.25))),
+        JsonCompactProp("string", JsonCompactString("a\"b")),
+        JsonCompactProp("empty", JsonCompactArray()),
+        JsonCompactProp("nested", JsonCompactObject(JsonCompactProp("object", JsonCompactObject())))
+    );
+
+    Json json = JsonObject(
+        JsonProp("null", JsonNull()),
+        JsonProp("bools", JsonArray(JsonBool(true), JsonBool(false))),
+        JsonProp("ints", JsonArray(JsonInt(0), JsonInt(-1), JsonInt(JSON_COMPACT_INT_MIN),
+                                   JsonInt(JSON_COMPACT_INT_MAX), JsonInt(INT64_MIN), JsonInt(INT64_MAX))),
+        JsonProp("floats", JsonArray(JsonFloat(1.5), JsonFloat(-0.25))),
+        JsonProp("string", JsonString("a\"b")),
+        JsonProp("empty", JsonArray()),
+        JsonProp("nested", JsonObject(JsonProp("object", JsonObject())))
+    );
+
+    char  *expected = json_stringify(json);
+    char  *actual   = json_stringify(JsonCompact(compact));
+    size_t size     = 0;
+
+    munit_assert_size(sizeof(json_compact_t), ==, 8);
+    munit_assert_string_equal(actual, expected);
+    munit_assert_size(json_stingified_size(JsonCompact(compact)), ==, strlen(expected) + 1);
+    munit_assert_size(json_stringified_size_upper_bound(JsonCompact(compact)), >=, strlen(expected) + 1);
+
+    uint8_t *msgpack = json_encode_msgpack(JsonCompact(compact), &size);
+
+    munit_assert_size(size, ==, json_encode_msgpack_size(json));
+    free(msgpack);
+    free(actual);
+    free(expected);
+
+    actual = json_stringify(JsonArray(JsonCompact(JsonCompactInt(-7)), JsonCompact(JsonCompactString("x"))));
+    munit_assert_string_equal(actual, "[-7,\"x\"]");
+    free(actual);
+
+    volatile double zero = 0;
+
+    munit_assert_true(JsonCompactFloat(-(zero / zero)) != JsonCompactNull());
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_compact_copies(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json  json     = JsonCompact(JsonCompactArray(JsonCompactInt(INT64_MAX), JsonCompactString("text"),
+                                                  JsonCompactObject(JsonCompactProp("key", JsonCompactFloat(2)))));
+    char *expected = json_stringify(json);
+    void *clone    = malloc(json_clone_size(json));
+    void *snapshot = malloc(json_snapshot_size(json));
+
+    json_value_t *copy = json_clone_into(json, clone);
+    json_value_t  view;
+
+    json_snapshot_write(json, snapshot);
+    munit_assert_true(json_snapshot_view(snapshot, json_snapshot_size(json), &view));
+
+    char *cloned = json_stringify(copy);
+    char *viewed = json_stringify(&view);
+
+    munit_assert_string_equal(cloned, expected);
+    munit_assert_string_equal(viewed, expected);
+
+    free(viewed);
+    free(cloned);
+    free(snapshot);
+    free(clone);
+    free(expected);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_base64_blob(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    uint8_t blob[300];
+    char    expected[sizeof(blob) / 3 * 4 + 8];
+
+    for (size_t i = 0; i < sizeof(blob); i++) {
+        blob[i] = (uint8_t) (i * 131 + 7);
+    }
+
+    char *string = json_stringify(JsonArray(JsonBase64("Man", 3), JsonBase64("Ma", 2), JsonBase64("M", 1), JsonBase64(NULL, 0)));
+    munit_assert_string_equal(string, "[\"TWFu\",\"TWE=\",\"TQ==\",\"\"]");
+    free(string);
+
+    /* Every length crosses the vector kernels and the tails differently */
+    for (size_t size = 0; size <= sizeof(blob); size++) {
+        char  *cursor = expected;
+        size_t i      = 0;
+
+        *cursor++ = '"';
+
+        for (; i < size; i += 3) {
+            uint32_t group = (uint32_t) blob[i] << 16 | (i + 1 < size ? (uint32_t) blob[i + 1] << 8 : 0) | (i + 2 < size ? blob[i + 2] : 0);
+
+            *cursor++ = alphabet[group >> 18];
+            *cursor++ = alphabet[group >> 12 & 0x3f];
+            *cursor++ = i + 1 < size ? alphabet[group >> 6 & 0x3f] : '=';
+            *cursor++ = i + 2 < size ? alphabet[group & 0x3f] : '=';
+        }
+
+        *cursor++ = '"';
+        *cursor   = '\0';
+
+        Json json = JsonBase64(blob, size);
+
+        string = json_stringify(json);
+        munit_assert_string_equal(string, expected);
+        munit_assert_size(json_stingified_size(json), ==, strlen(expected) + 1);
+        free(string);
+    }
+
+    Json  json     = JsonObject(JsonProp("blob", JsonBase64(blob, sizeof(blob))));
+    char *original = json_stringify(json);
+    void *clone    = malloc(json_clone_size(json));
+    void *snapshot = malloc(json_snapshot_size(json));
+
+    json_value_t view;
+
+    json_snapshot_write(json, snapshot);
+    munit_assert_true(json_snapshot_view(snapshot, json_snapshot_size(json), &view));
+
+    char *cloned = json_stringify(json_clone_into(json, clone));
+    char *viewed = json_stringify(&view);
+
+    munit_assert_string_equal(cloned, original);
+    munit_assert_string_equal(viewed, original);
+
+    size_t   size    = 0;
+    uint8_t *msgpack = json_encode_msgpack(json, &size);
+
+    munit_assert_size(size, ==, json_encode_msgpack_size(JsonObject(JsonProp("blob", JsonString(original + 9)))) - 2);
+    munit_assert_memory_equal(400, msgpack + size - 400, original + 9);
+
+    free(msgpack);
+    free(viewed);
+    free(cloned);
+    free(snapshot);
+    free(clone);
+    free(original);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_stringify_utf8(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    static const char *invalid[] = { "\x80", "\xc3", "\xc0\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80", "ab\xff" };
+
+    Json  json   = JsonObject(JsonProp("k\xc3\xa9y", JsonString("0123456789abcdef h\xc3\xa9llo \xf0\x9f\x98\x80 \x01\"")));
+    char *plain  = json_stringify(json);
+    char *string = json_stringify_with_options(json, JSON_STRINGIFY_VALIDATE_UTF8);
+    size_t size  = 0;
+
+    munit_assert_string_equal(string, plain);
+    free(string);
+    free(plain);
+
+    string = json_stringify_with_options(json, JSON_STRINGIFY_ESCAPE_NON_ASCII);
+    munit_assert_string_equal(string, "{\"k\\u00e9y\":\"0123456789abcdef h\\u00e9llo \\ud83d\\ude00 \\u0001\\\"\"}");
+    munit_assert_true(json_stringified_size_with_options(json, JSON_STRINGIFY_ESCAPE_NON_ASCII, &size));
+    munit_assert_size(size, ==, strlen(string) + 1);
+    free(string);
+
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        const char *keys[] = { invalid[i] };
+
+        munit_assert_null(json_stringify_with_options(JsonArray(JsonString("valid"), JsonString(invalid[i])), JSON_STRINGIFY_VALIDATE_UTF8));
+        munit_assert_null(json_stringify_with_options(JsonObject(JsonProp(invalid[i], JsonNull())), JSON_STRINGIFY_ESCAPE_NON_ASCII));
+        munit_assert_false(json_stringified_size_with_options(JsonTable(keys, JsonNull(), 1, 1), JSON_STRINGIFY_VALIDATE_UTF8, &size));
+
+        string = json_stringify_with_options(JsonString(invalid[i]), 0);
+        munit_assert_size(strlen(string), ==, strlen(invalid[i]) + 2);
+        free(string);
+    }
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_object_lookup(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    static char         names[1500][8];
+    static json_value_t entries[1500];
+    static json_prop_t  props[1500];
+    static json_prop_t *pointers[1500];
+
+    for (size_t i = 0; i < 1500; i++) {
+        names[i][0] = 'k';
+        names[i][1] = (char) ('0' + i / 1000 % 10);
+        names[i][2] = (char) ('0' + i / 100 % 10);
+        names[i][3] = (char) ('0' + i / 10 % 10);
+        names[i][4] = (char) ('0' + i % 10);
+        names[i][5] = '\0';
+
+        entries[i]  = *JsonInt((int64_t) i);
+        props[i]    = (json_prop_t) { .key = names[i], .entry = &entries[i] };
+        pointers[i] = &props[i];
+    }
+
+    /* The last key duplicates the first one, lookups return the first */
+    names[1499][1] = names[1499][2] = names[1499][3] = names[1499][4] = '0';
+
+    json_object_t object = { .size = 1500, .props = pointers };
+    json_value_t  json   = { .type = JSON_VALUE_TYPE_OBJECT, .as.object = &object };
+
+    munit_assert_ptr_equal(json_object_get(&json, "k0042", 5), &props[42]);
+    munit_assert_ptr_equal(json_object_get(&json, "k0042 and more", 5), &props[42]);
+    munit_assert_null(json_object_get(&json, "k004", 4));
+
+    void *index = malloc(json_object_index_size(&json));
+
+    munit_assert_size(json_object_index_size(&json), >=, 1500 * 2 * sizeof(uint64_t));
+    json_object_index_build(&json, index);
+    munit_assert_not_null(object.index);
+
+    for (size_t i = 0; i < 1499; i++) {
+        munit_assert_ptr_equal(json_object_get(&json, names[i], 5), &props[i]);
+    }
+
+    munit_assert_ptr_equal(json_object_get(&json, "k0000", 5), &props[0]);
+    munit_assert_null(json_object_get(&json, "k9999", 5));
+    munit_assert_null(json_object_get(&json, "k00", 3));
+
+    json_object_get(&json, "k0007", 5)->entry = JsonString("override");
+    munit_assert_string_equal(props[7].entry->as.string, "override");
+
+    free(index);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_diff_patch(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    char        memory[4096];
+    json_pool_t pool;
+    Json        patch  = NULL;
+    Json        shared = JsonObject(JsonProp("deep", JsonArray(JsonInt(1), JsonInt(2))));
+
+    Json from = JsonObject(
+        JsonProp("id",     JsonInt(1)),
+        JsonProp("name",   JsonString("a")),
+        JsonProp("tags",   JsonArray(JsonString("x"), JsonString("y"), JsonString("z"))),
+        JsonProp("meta",   JsonObject(JsonProp("v", JsonInt(1)), JsonProp("a/b", JsonBool(true)), JsonProp("~", JsonNull()))),
+        JsonProp("shared", shared),
+        JsonProp("gone",   JsonNull()),
+    );
+
+    Json to = JsonObject(
+        JsonProp("id",     JsonInt(1)),
+        JsonProp("name",   JsonString("b")),
+        JsonProp("tags",   JsonArray(JsonString("x"), JsonString("w"), JsonString("y"), JsonString("z"))),
+        JsonProp("meta",   JsonObject(JsonProp("v", JsonFloat(1)), JsonProp("a/b", JsonBool(false)))),
+        JsonProp("shared", shared),
+        JsonProp("added",  JsonArray(JsonInt(1))),
+    );
+
+    json_pool_init(&pool, memory, sizeof(memory));
+    munit_assert_true(json_diff(from, to, &pool, &patch));
+
+    char *string = json_stringify(patch);
+    munit_assert_string_equal(string,
+        "[{\"op\":\"replace\",\"path\":\"/name\",\"value\":\"b\"},"
+        "{\"op\":\"add\",\"path\":\"/tags/1\",\"value\":\"w\"},"
+        "{\"op\":\"replace\",\"path\":\"/meta/v\",\"value\":1.000000},"
+        "{\"op\":\"replace\",\"path\":\"/meta/a~1b\",\"value\":false},"
+        "{\"op\":\"remove\",\"path\":\"/meta/~0\"},"
+        "{\"op\":\"remove\",\"path\":\"/gone\"},"
+        "{\"op\":\"add\",\"path\":\"/added\",\"value\":[1]}]");
+    free(string);
+
+    /* Removed entries are removed at one index, so the patch applies in order */
+    Json before = JsonArray(JsonInt(1), JsonInt(2), JsonInt(3), JsonInt(4));
+    Json after  = JsonArray(JsonInt(1), JsonInt(5));
+    Json empty  = JsonNull();
+
+    json_pool_init(&pool, memory, sizeof(memory));
+    munit_assert_true(json_diff(before, after, &pool, &patch));
+
+    string = json_stringify(patch);
+    munit_assert_string_equal(string,
+        "[{\"op\":\"replace\",\"path\":\"/1\",\"value\":5},"
+        "{\"op\":\"remove\",\"path\":\"/2\"},"
+        "{\"op\":\"remove\",\"path\":\"/2\"}]");
+    free(string);
+
+    json_pool_init(&pool, memory, sizeof(memory));
+    munit_assert_true(json_diff(from, from, &pool, &patch));
+    munit_assert_size(patch->as.array->size, ==, 0);
+    munit_assert_true(json_diff(from, empty, &pool, &patch));
+
+    string = json_stringify(patch);
+    munit_assert_string_equal(string, "[{\"op\":\"replace\",\"path\":\"\",\"value\":null}]");
+    free(string);
+
+    /* Exhausted pool is left as it was */
+    json_pool_init(&pool, memory, 256);
+
+    size_t bottom = pool.bottom;
+    size_t top    = pool.top;
+
+    munit_assert_false(json_diff(from, to, &pool, &patch));
+    munit_assert_size(pool.bottom, ==, bottom);
+    munit_assert_size(pool.top, ==, top);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_overlay_large(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    /* Patches wider than the match plan, with and without an index on the base */
+    char   base_text[1024] = "{";
+    char   patch_text[1024] = "{";
+    char   expected[2048] = "{";
+    size_t count = 48;
+
+    for (size_t i = 0; i < count; i++) {
+        char *base_end     = base_text + strlen(base_text);
+        char *patch_end    = patch_text + strlen(patch_text);
+        char *expected_end = expected + strlen(expected);
+
+        sprintf(base_end, "%s\"k%zu\":%zu", i ? "," : "", i, i);
+        sprintf(patch_end, "%s\"k%zu\":%zu", i ? "," : "", i * 2 + 1, 1000 + i);
+        sprintf(expected_end, "%s\"k%zu\":%zu", i ? "," : "", i, i % 2 ? 1000 + i / 2 : i);
+    }
+
+    for (size_t i = count; i < count * 2; i++) {
+        if (i % 2) {
+            sprintf(expected + strlen(expected), ",\"k%zu\":%zu", i, 1000 + i / 2);
+        }
+    }
+
+    strcat(base_text, "}");
+    strcat(patch_text, "}");
+    strcat(expected, "}");
+
+    char        memory[32768];
+    char        merged_text[sizeof(expected)];
+    json_pool_t pool;
+    Json        base   = NULL;
+    Json        patch  = NULL;
+    Json        merged = NULL;
+
+    strcpy(merged_text, expected);
+    json_pool_init(&pool, memory, sizeof(memory));
+    munit_assert_int(json_parse(base_text, strlen(base_text), &pool, &base), ==, JSON_PARSE_OK);
+    munit_assert_int(json_parse(patch_text, strlen(patch_text), &pool, &patch), ==, JSON_PARSE_OK);
+    munit_assert_int(json_parse(merged_text, strlen(merged_text), &pool, &merged), ==, JSON_PARSE_OK);
+
+    for (int indexed = 0; indexed < 2; indexed++) {
+        if (indexed) {
+            json_object_index_build(base, malloc(json_object_index_size(base)));
+            json_object_index_build(patch, malloc(json_object_index_size(patch)));
+        }
+
+        size_t   size         = 0;
+        size_t   merged_size  = 0;
+        char    *string       = json_stringify(JsonOverlay(base, patch));
+        uint8_t *msgpack      = json_encode_msgpack(JsonOverlay(base, patch), &size);
+        uint8_t *msgpack_then = json_encode_msgpack(merged, &merged_size);
+
+        munit_assert_string_equal(string, expected);
+        munit_assert_size(size, ==, merged_size);
+        munit_assert_memory_equal(size, msgpack, msgpack_then);
+
+        free(msgpack_then);
+        free(msgpack);
+        free(string);
+    }
+
+    free((void *) base->as.object->index);
+    free((void *) patch->as.object->index);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_overlay_merge(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    Json base    = JsonObject(JsonProp("a", JsonInt(1)), JsonProp("b", JsonInt(2)), JsonProp("c", JsonObject(JsonProp("x", JsonInt(1)))));
+    Json patch   = JsonObject(JsonProp("b", JsonString("two")), JsonProp("d", JsonPaddedInt(4, 3)));
+    Json overlay = JsonOverlay(base, patch);
+    Json merged  = JsonObject(JsonProp("a", JsonInt(1)), JsonProp("b", JsonString("two")),
+                              JsonProp("c", JsonObject(JsonProp("x", JsonInt(1)))), JsonProp("d", JsonPaddedInt(4, 3)));
+
+    /* Overridden keys keep their place in the base, new keys follow */
+    char *string = json_stringify(overlay);
+    munit_assert_string_equal(string, "{\"a\":1,\"b\":\"two\",\"c\":{\"x\":1},\"d\":  4}");
+    munit_assert_size(json_stingified_size(overlay), ==, strlen(string) + 1);
+    munit_assert_size(json_patchable_slots_count(overlay), ==, 1);
+    munit_assert_size(json_encode_msgpack_size(overlay), ==, json_encode_msgpack_size(merged));
+    free(string);
+
+    string = json_stringify(base);
+    munit_assert_string_equal(string, "{\"a\":1,\"b\":2,\"c\":{\"x\":1}}");
+    free(string);
+
+    Json nested = JsonOverlay(base, JsonObject(JsonProp("c", JsonOverlay(base->as.object->props[2]->entry, JsonObject(JsonProp("y", JsonNull()))))));
+    char *expected = json_stringify(nested);
+    void *clone    = malloc(json_clone_size(nested));
+    void *snapshot = malloc(json_snapshot_size(nested));
+
+    json_value_t view;
+
+    munit_assert_string_equal(expected, "{\"a\":1,\"b\":2,\"c\":{\"x\":1,\"y\":null}}");
+    json_snapshot_write(nested, snapshot);
+    munit_assert_true(json_snapshot_view(snapshot, json_snapshot_size(nested), &view));
+
+    char *cloned = json_stringify(json_clone_into(nested, clone));
+    char *viewed = json_stringify(&view);
+
+    munit_assert_string_equal(cloned, expected);
+    munit_assert_string_equal(viewed, expected);
+
+    free(viewed);
+    free(cloned);
+    free(snapshot);
+    free(clone);
+    free(expected);
+
+    return MUNIT_OK;
+}
+
+static MunitResult json_projection_fields(const MunitParameter params[], void *data)
+{
+    MUNIT_SUPPRESS_PARAMS_AND_DATA(params, data);
+
+    static const char *keys[] = { "id", "name", "tags" };
+
+    json_value_t values[] = { *JsonInt(1), *JsonInt(2), *JsonString("a"), *JsonString("b"), *JsonNull(), *JsonNull() };
+    json_mask_t  nodes[16];
+
+    Json json = JsonObject(
+        JsonProp("id", JsonInt(7)),
+        JsonProp("author", JsonObject(JsonProp("name", JsonString("ann")), JsonProp("email", JsonString("a@b")))),
+        JsonProp("items", JsonArray(JsonObject(JsonProp("id", JsonInt(1)), JsonProp("price", JsonFloat(1))), JsonInt(5))),
+        JsonProp("rows", JsonTable(keys, values, 3, 2)),
+        JsonProp("extra", JsonOverlay(JsonObject(JsonProp("x", JsonInt(1)), JsonProp("y", JsonInt(2))), JsonObject(JsonProp("x", JsonPaddedInt(3, 2)))))
+    );
+
+    char fields[] = "id,author.name,items.id,rows.name,extra.x,author.name.first,missing";
+
+    munit_assert_size(json_mask_nodes_count(fields), <=, 16);
+    munit_assert_true(json_mask_compile(fields, nodes, json_mask_nodes_count(fields)));
+
+    char *string = json_stringify_projected(json, nodes);
+    munit_assert_string_equal(string, "{\"id\":7,\"author\":{\"name\":\"ann\"},\"items\":[{\"id\":1},5],\"rows\":[{\"name\":\"a\"},{\"name\":\"b\"}],\"extra\":{\"x\": 3}}");
+    munit_assert_size(json_stingified_size(JsonProjection(json, nodes)), ==, strlen(string) + 1);
+    munit_assert_size(json_patchable_slots_count(JsonProjection(json, nodes)), ==, 1);
+    free(string);
+
+    size_t   size    = 0;
+    uint8_t *msgpack = json_encode_msgpack(JsonProjection(json, nodes), &size);
+
+    munit_assert_size(size, ==, json_encode_msgpack_size(JsonProjection(json, nodes)));
+    free(msgpack);
+
+    char *expected = json_stringify_projected(json, nodes);
+    void *buffer   = malloc(json_clone_size(JsonProjection(json, nodes)));
+    Json  clone    = json_clone_into(JsonProjection(json, nodes), buffer);
+
+    /* The clone keeps its own mask, the nodes and the fields text are reused below */
+    memset(fields, 'x', strlen(fields));
+    munit_assert_true(json_mask_compile("", nodes, 1));
+
+    string = json_stringify(clone);
+    munit_assert_string_equal(string, expected);
+    free(string);
+    free(expected);
+    free(buffer);
+
+    string = json_stringify_projected(json, nodes);
+    munit_assert_string_equal(string, "{}");
+    free(string);
+
+    munit_assert_false(json_mask_compile("a,,b", nodes, 16));
+    munit_assert_false(json_mask_compile("a.", nodes, 16));
+    munit_assert_false(json_mask_compile("a.b.c", nodes, 3));
+
+    return MUNIT_OK;
+}
+
 static MunitTest tests[] = {
     MUNIT_SIMPLE_TEST_CASE("/null",                      json_null                     ),
     MUNIT_SIMPLE_TEST_CASE("/bool/false",                json_bool_false               ),
@@ -675,6 +2577,7 @@ static MunitTest tests[] = {
     MUNIT_SIMPLE_TEST_CASE("/array/complete",            json_array_complete           ),
     MUNIT_SIMPLE_TEST_CASE("/object/empty",              json_object_empty             ),
     MUNIT_SIMPLE_TEST_CASE("/object/complete",           json_object_complete          ),
+    MUNIT_SIMPLE_TEST_CASE("/padded-int",                json_padded_int               ),
     MUNIT_SIMPLE_TEST_CASE("/stringify/null",            json_stringify_null           ),
     MUNIT_SIMPLE_TEST_CASE("/stringify/bool/false",      json_stringify_bool_false     ),
     MUNIT_SIMPLE_TEST_CASE("/stringify/bool/true",       json_stringify_bool_true      ),
@@ -690,6 +2593,14 @@ static MunitTest tests[] = {
     MUNIT_SIMPLE_TEST_CASE("/stringify/array/complete",  json_stringify_array_complete ),
     MUNIT_SIMPLE_TEST_CASE("/stringify/object/empty",    json_stringify_object_empty   ),
     MUNIT_SIMPLE_TEST_CASE("/stringify/object/complete", json_stringify_object_complete),
+    MUNIT_SIMPLE_TEST_CASE("/stringify/padded-int",      json_stringify_padded_int     ),
+    MUNIT_SIMPLE_TEST_CASE("/stringify/padded-int/wide", json_stringify_padded_wide    ),
+    MUNIT_SIMPLE_TEST_CASE("/stringify/string/escaped",  json_stringify_string_escaped ),
+    MUNIT_SIMPLE_TEST_CASE("/stringify/capacity",        json_stringify_capacity       ),
+    MUNIT_SIMPLE_TEST_CASE("/stringify/reusable",        json_stringify_reusable_buffer),
+#if defined(STATIC_JSON_BUILDER_THREADS)
+    MUNIT_SIMPLE_TEST_CASE("/stringify/reusable/thread", json_stringify_reusable_thread),
+#endif
     MUNIT_SIMPLE_TEST_CASE("/size/null",                 json_size_null                ),
     MUNIT_SIMPLE_TEST_CASE("/size/bool/false",           json_size_bool_false          ),
     MUNIT_SIMPLE_TEST_CASE("/size/bool/true",            json_size_bool_true           ),
@@ -705,6 +2616,47 @@ static MunitTest tests[] = {
     MUNIT_SIMPLE_TEST_CASE("/size/array/complete",       json_size_array_complete      ),
     MUNIT_SIMPLE_TEST_CASE("/size/object/empty",         json_size_object_empty        ),
     MUNIT_SIMPLE_TEST_CASE("/size/object/complete",      json_size_object_complete     ),
+    MUNIT_SIMPLE_TEST_CASE("/size/padded-int",           json_size_padded_int          ),
+    MUNIT_SIMPLE_TEST_CASE("/size/upper-bound",          json_size_upper_bound         ),
+    MUNIT_SIMPLE_TEST_CASE("/patch/render",              json_patch_render             ),
+    MUNIT_SIMPLE_TEST_CASE("/patch/slot",                json_patch_slot_value         ),
+    MUNIT_SIMPLE_TEST_CASE("/patch/slot/overflow",       json_patch_slot_overflow      ),
+    MUNIT_SIMPLE_TEST_CASE("/msgpack/scalars",           json_msgpack_scalars          ),
+    MUNIT_SIMPLE_TEST_CASE("/msgpack/object",            json_msgpack_object           ),
+    MUNIT_SIMPLE_TEST_CASE("/msgpack/string/long",       json_msgpack_long_string      ),
+    MUNIT_SIMPLE_TEST_CASE("/parse/scalars",             json_parse_scalars            ),
+    MUNIT_SIMPLE_TEST_CASE("/parse/round-trip",          json_parse_round_trip         ),
+    MUNIT_SIMPLE_TEST_CASE("/parse/errors",              json_parse_errors             ),
+    MUNIT_SIMPLE_TEST_CASE("/parse/limits",              json_parse_limits             ),
+    MUNIT_SIMPLE_TEST_CASE("/parse/locale",              json_parse_locale             ),
+    MUNIT_SIMPLE_TEST_CASE("/parse/floats",              json_parse_floats             ),
+    MUNIT_SIMPLE_TEST_CASE("/cursor/fields",             json_cursor_fields            ),
+    MUNIT_SIMPLE_TEST_CASE("/cursor/nested",             json_cursor_nested            ),
+    MUNIT_SIMPLE_TEST_CASE("/cursor/truncated",          json_cursor_truncated         ),
+    MUNIT_SIMPLE_TEST_CASE("/clone/contiguous",          json_clone_contiguous         ),
+    MUNIT_SIMPLE_TEST_CASE("/clone/size",                json_clone_size_bounds        ),
+    MUNIT_SIMPLE_TEST_CASE("/snapshot/round-trip",       json_snapshot_round_trip      ),
+    MUNIT_SIMPLE_TEST_CASE("/snapshot/invalid",          json_snapshot_invalid         ),
+    MUNIT_SIMPLE_TEST_CASE("/generator/array",           json_generator_array          ),
+    MUNIT_SIMPLE_TEST_CASE("/generator/object",          json_generator_object         ),
+    MUNIT_SIMPLE_TEST_CASE("/generator/snapshot",        json_generator_snapshot       ),
+    MUNIT_SIMPLE_TEST_CASE("/describe/struct",           json_describe_struct          ),
+    MUNIT_SIMPLE_TEST_CASE("/describe/formatters",       json_describe_formatters      ),
+    MUNIT_SIMPLE_TEST_CASE("/table/rows",                json_table_rows               ),
+    MUNIT_SIMPLE_TEST_CASE("/table/shapes",              json_table_shapes             ),
+#if defined(STATIC_JSON_BUILDER_THREADS)
+    MUNIT_SIMPLE_TEST_CASE("/pipeline/fd",               json_pipeline_fd              ),
+    MUNIT_SIMPLE_TEST_CASE("/log/writer",                json_log_writer               ),
+#endif
+    MUNIT_SIMPLE_TEST_CASE("/compact/values",            json_compact_values           ),
+    MUNIT_SIMPLE_TEST_CASE("/compact/copies",            json_compact_copies           ),
+    MUNIT_SIMPLE_TEST_CASE("/base64/blob",               json_base64_blob              ),
+    MUNIT_SIMPLE_TEST_CASE("/stringify/utf8",            json_stringify_utf8           ),
+    MUNIT_SIMPLE_TEST_CASE("/object/lookup",             json_object_lookup            ),
+    MUNIT_SIMPLE_TEST_CASE("/diff/patch",                json_diff_patch               ),
+    MUNIT_SIMPLE_TEST_CASE("/overlay/merge",             json_overlay_merge            ),
+    MUNIT_SIMPLE_TEST_CASE("/overlay/large",             json_overlay_large            ),
+    MUNIT_SIMPLE_TEST_CASE("/projection/fields",         json_projection_fields        ),
     MUNIT_SIMPLE_TEST_CASE(NULL,                         NULL                          ),
 };
 
@@ -0,0 +1,480 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <static-json-builder.h>
+
+/*
+ Generates a straight-line serializer of documents shaped like a sample.
+ Every scalar of the sample becomes a field of the generated struct (ints
+ become int64_t, floats double, bools bool and strings const char *), nulls,
+ keys and punctuation are merged into literal runs copied with memcpy.
+ Arrays keep the length they have in the sample. The generated
+ `json_stringified_size_<name>_t(...)` and `json_stringify_<name>_t_into_buffer(...)`
+ work like `json_stingified_size(...)` and `json_stringify_into_buffer(...)`
+ of the equivalent tree and produce the same bytes.
+
+ Fields are named after the path of the scalar with `_` between the keys
+ and indexes, e.g. `{"order": {"fills": [1.5]}}` gives `order_fills_0`.
+ A sample without scalars gives a constant document and a struct with a
+ single unused char member.
+
+ Usage: sjb-codegen <name> <sample.json> <output.c> <output.h>
+*/
+
+#define CODEGEN_POOL_FACTOR 64
+#define CODEGEN_POOL_SLACK  4096
+
+typedef struct codegen_step_t
+{
+    char               *literal;
+    size_t              length;
+    const json_value_t *leaf;
+    char               *field;
+} codegen_step_t;
+
+typedef struct codegen_t
+{
+    codegen_step_t *steps;
+    size_t          count;
+    size_t          capacity;
+    size_t          literals;
+    size_t          fields;
+} codegen_t;
+
+static const char *codegen_keywords[] = {
+    "auto", "break", "case", "char", "const", "continue", "default", "do", "double", "else", "enum",
+    "extern", "float", "for", "goto", "if", "inline", "int", "long", "register", "restrict", "return",
+    "short", "signed", "sizeof", "static", "struct", "switch", "typedef", "union", "unsigned", "void",
+    "volatile", "while", "bool", "true", "false",
+};
+
+static void *codegen_alloc(size_t size)
+{
+    void *memory = malloc(size);
+
+    if (memory == NULL) {
+        fprintf(stderr, "sjb-codegen: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return memory;
+}
+
+static codegen_step_t *codegen_push(codegen_t *codegen)
+{
+    if (codegen->count == codegen->capacity) {
+        codegen->capacity = codegen->capacity ? codegen->capacity * 2 : 64;
+        codegen->steps    = realloc(codegen->steps, codegen->capacity * sizeof(codegen_step_t));
+
+        if (codegen->steps == NULL) {
+            fprintf(stderr, "sjb-codegen: out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    codegen_step_t *step = &codegen->steps[codegen->count++];
+    memset(step, 0, sizeof(codegen_step_t));
+
+    return step;
+}
+
+/* Literal is appended to the previous step when it is a literal too, so runs between leaves are merged */
+static void codegen_literal(codegen_t *codegen, const char *text, size_t length)
+{
+    codegen_step_t *step = codegen->count && codegen->steps[codegen->count - 1].leaf == NULL
+        ? &codegen->steps[codegen->count - 1]
+        : codegen_push(codegen);
+
+    char *literal = codegen_alloc(step->length + length);
+
+    if (step->literal != NULL) {
+        memcpy(literal, step->literal, step->length);
+    }
+
+    memcpy(literal + step->length, text, length);
+    free(step->literal);
+
+    step->literal      = literal;
+    step->length      += length;
+    codegen->literals += length;
+}
+
+static bool codegen_field_taken(const codegen_t *codegen, const char *field)
+{
+    for (size_t i = 0; i < codegen->count; i++) {
+        if (codegen->steps[i].field != NULL && strcmp(codegen->steps[i].field, field) == 0) {
+            return true;
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(codegen_keywords) / sizeof(codegen_keywords[0]); i++) {
+        if (strcmp(codegen_keywords[i], field) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Field names keep letters, digits and underscores of the path, clashes get a numeric suffix */
+static char *codegen_field(const codegen_t *codegen, const char *path)
+{
+    size_t length = strlen(path);
+    char  *field  = codegen_alloc(length + 32);
+    char  *cursor = field;
+
+    if (length == 0) {
+        cursor += sprintf(cursor, "value");
+    } else if (isdigit((unsigned char) path[0])) {
+        *cursor++ = '_';
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        *cursor++ = isalnum((unsigned char) path[i]) ? path[i] : '_';
+    }
+
+    *cursor = '\0';
+
+    for (size_t suffix = 2; codegen_field_taken(codegen, field); suffix++) {
+        sprintf(cursor, "_%zu", suffix);
+    }
+
+    return field;
+}
+
+static char *codegen_path(const char *parent, const char *key, size_t index)
+{
+    char *path = codegen_alloc(strlen(parent) + (key ? strlen(key) : 0) + 32);
+
+    if (key != NULL) {
+        sprintf(path, "%s%s%s", parent, *parent ? "_" : "", key);
+    } else {
+        sprintf(path, "%s%s%zu", parent, *parent ? "_" : "", index);
+    }
+
+    return path;
+}
+
+static bool codegen_walk(codegen_t *codegen, const json_value_t *json, const char *path)
+{
+    switch (json->type) {
+        case JSON_VALUE_TYPE_NULL:
+            codegen_literal(codegen, "null", strlen("null"));
+            return true;
+
+        case JSON_VALUE_TYPE_BOOL:
+        case JSON_VALUE_TYPE_INT:
+        case JSON_VALUE_TYPE_FLOAT:
+        case JSON_VALUE_TYPE_STRING: {
+            char           *field = codegen_field(codegen, path);
+            codegen_step_t *step  = codegen_push(codegen);
+
+            step->leaf  = json;
+            step->field = field;
+            codegen->fields++;
+
+            return true;
+        }
+
+        case JSON_VALUE_TYPE_ARRAY:
+            codegen_literal(codegen, "[", 1);
+
+            for (size_t i = 0; i < json->as.array->size; i++) {
+                char *child = codegen_path(path, NULL, i);
+
+                if (i != 0) {
+                    codegen_literal(codegen, ",", 1);
+                }
+
+                bool walked = codegen_walk(codegen, json->as.array->entries[i], child);
+                free(child);
+
+                if (!walked) {
+                    return false;
+                }
+            }
+
+            codegen_literal(codegen, "]", 1);
+            return true;
+
+        case JSON_VALUE_TYPE_OBJECT:
+            codegen_literal(codegen, "{", 1);
+
+            for (size_t i = 0; i < json->as.object->size; i++) {
+                const json_prop_t *property = json->as.object->props[i];
+                char              *key      = codegen_alloc(json_string_text_size(property->key) + 2);
+                char              *end      = json_string_text_write(key + 1, property->key);
+                char              *child    = codegen_path(path, property->key, 0);
+
+                /* Key is rendered by the library itself so its escapes match the stringified text */
+                key[0] = ',';
+                *end++ = ':';
+
+                codegen_literal(codegen, key + (i == 0), (size_t) (end - key) - (i == 0));
+                free(key);
+
+                bool walked = codegen_walk(codegen, property->entry, child);
+                free(child);
+
+                if (!walked) {
+                    return false;
+                }
+            }
+
+            codegen_literal(codegen, "}", 1);
+            return true;
+
+        default:
+            fprintf(stderr, "sjb-codegen: sample contains a value of unsupported type\n");
+            return false;
+    }
+}
+
+/* Question marks are escaped too since C99 compilers may replace trigraphs */
+static void codegen_print_literal(FILE *file, const char *literal, size_t length)
+{
+    fputc('"', file);
+
+    for (size_t i = 0; i < length; i++) {
+        unsigned char character = (unsigned char) literal[i];
+
+        if (character == '"' || character == '\\' || character == '?') {
+            fprintf(file, "\\%c", character);
+        } else if (character >= 0x20 && character < 0x7F) {
+            fputc(character, file);
+        } else {
+            fprintf(file, "\\%03o", character);
+        }
+    }
+
+    fputc('"', file);
+}
+
+static const char *codegen_field_type(const json_value_t *leaf)
+{
+    switch (leaf->type) {
+        case JSON_VALUE_TYPE_BOOL:  return "bool";
+        case JSON_VALUE_TYPE_INT:   return "int64_t";
+        case JSON_VALUE_TYPE_FLOAT: return "double";
+        default:                    return "const char *";
+    }
+}
+
+static void codegen_print_header(FILE *file, const codegen_t *codegen, const char *name, const char *sample)
+{
+    char   guard[256];
+    size_t i = 0;
+
+    for (; name[i] != '\0' && i < sizeof(guard) - strlen("_JSON_H") - 1; i++) {
+        guard[i] = (char) toupper((unsigned char) name[i]);
+    }
+
+    strcpy(guard + i, "_JSON_H");
+
+    fprintf(file, "/* Generated by sjb-codegen from %s, do not edit */\n\n", sample);
+    fprintf(file, "#ifndef %s\n#define %s\n\n", guard, guard);
+    fprintf(file, "#include <stdbool.h>\n#include <stddef.h>\n#include <stdint.h>\n\n");
+    fprintf(file, "typedef struct %s_t\n{\n", name);
+
+    /* Members are aligned like hand-written structs, pointers keep the star next to the name */
+    for (i = 0; i < codegen->count; i++) {
+        const codegen_step_t *step = &codegen->steps[i];
+
+        if (step->leaf != NULL) {
+            const char *type = codegen_field_type(step->leaf);
+            fprintf(file, "    %-*s%s;\n", (int) strlen("const char *"), type, step->field);
+        }
+    }
+
+    /* A sample without scalars still needs a member, C doesn't allow empty structs */
+    if (codegen->fields == 0) {
+        fprintf(file, "    %-*sunused;\n", (int) strlen("const char *"), "char");
+    }
+
+    fprintf(file, "} %s_t;\n\n", name);
+    fprintf(file, "size_t json_stringified_size_%s_t(const %s_t *value);\n", name, name);
+    fprintf(file, "size_t json_stringify_%s_t_into_buffer(const %s_t *value, char *buffer);\n\n", name, name);
+    fprintf(file, "#endif /* %s */\n", guard);
+}
+
+static void codegen_print_source(FILE *file, const codegen_t *codegen, const char *name, const char *sample, const char *header)
+{
+    const char *include = strrchr(header, '/');
+    include = include ? include + 1 : header;
+
+    fprintf(file, "/* Generated by sjb-codegen from %s, do not edit */\n\n", sample);
+    fprintf(file, "#include <string.h>\n#include <static-json-builder.h>\n#include \"%s\"\n\n", include);
+
+    fprintf(file, "size_t json_stringified_size_%s_t(const %s_t *value)\n{\n", name, name);
+    fprintf(file, "%s", codegen->fields == 0 ? "    (void) value;\n\n" : "");
+    fprintf(file, "    size_t size = %zu;\n%s", codegen->literals + 1, codegen->fields == 0 ? "" : "\n");
+
+    for (size_t i = 0; i < codegen->count; i++) {
+        const codegen_step_t *step = &codegen->steps[i];
+
+        switch (step->leaf ? step->leaf->type : JSON_VALUE_TYPE_NULL) {
+            case JSON_VALUE_TYPE_BOOL:
+                fprintf(file, "    size += value->%s ? 4 : 5;\n", step->field);
+                break;
+
+            case JSON_VALUE_TYPE_INT:
+                fprintf(file, "    size += json_int_text_size(value->%s);\n", step->field);
+                break;
+
+            case JSON_VALUE_TYPE_FLOAT:
+                fprintf(file, "    size += json_float_text_size(value->%s);\n", step->field);
+                break;
+
+            case JSON_VALUE_TYPE_STRING:
+                fprintf(file, "    size += json_string_text_size(value->%s);\n", step->field);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    fprintf(file, "\n    return size;\n}\n\n");
+
+    fprintf(file, "size_t json_stringify_%s_t_into_buffer(const %s_t *value, char *buffer)\n{\n", name, name);
+    fprintf(file, "%s", codegen->fields == 0 ? "    (void) value;\n\n" : "");
+    fprintf(file, "    char *cursor = buffer;\n\n");
+
+    for (size_t i = 0; i < codegen->count; i++) {
+        const codegen_step_t *step = &codegen->steps[i];
+
+        switch (step->leaf ? step->leaf->type : JSON_VALUE_TYPE_NULL) {
+            case JSON_VALUE_TYPE_BOOL:
+                fprintf(file, "    cursor  = value->%s ? (char *) memcpy(cursor, \"true\", 4) + 4 : (char *) memcpy(cursor, \"false\", 5) + 5;\n", step->field);
+                break;
+
+            case JSON_VALUE_TYPE_INT:
+                fprintf(file, "    cursor  = json_int_text_write(cursor, value->%s);\n", step->field);
+                break;
+
+            case JSON_VALUE_TYPE_FLOAT:
+                fprintf(file, "    cursor  = json_float_text_write(cursor, value->%s);\n", step->field);
+                break;
+
+            case JSON_VALUE_TYPE_STRING:
+                fprintf(file, "    cursor  = json_string_text_write(cursor, value->%s);\n", step->field);
+                break;
+
+            default:
+                fprintf(file, "    memcpy(cursor, ");
+                codegen_print_literal(file, step->literal, step->length);
+                fprintf(file, ", %zu);\n    cursor += %zu;\n", step->length, step->length);
+                break;
+        }
+    }
+
+    fprintf(file, "\n    *cursor = '\\0';\n");
+    fprintf(file, "    return (size_t) (cursor - buffer);\n}\n");
+}
+
+static char *codegen_read(const char *path, size_t *length)
+{
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL || fseek(file, 0, SEEK_END) != 0) {
+        fprintf(stderr, "sjb-codegen: can't read %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    long  size = ftell(file);
+    char *text = codegen_alloc(size > 0 ? (size_t) size : 1);
+
+    rewind(file);
+
+    if (size < 0 || fread(text, 1, (size_t) size, file) != (size_t) size) {
+        fprintf(stderr, "sjb-codegen: can't read %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    fclose(file);
+    *length = (size_t) size;
+
+    return text;
+}
+
+static bool codegen_identifier(const char *name)
+{
+    if (!isalpha((unsigned char) name[0]) && name[0] != '_') {
+        return false;
+    }
+
+    for (const char *character = name; *character != '\0'; character++) {
+        if (!isalnum((unsigned char) *character) && *character != '_') {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 5 || !codegen_identifier(argv[1])) {
+        fprintf(stderr, "usage: sjb-codegen <name> <sample.json> <output.c> <output.h>\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t        length   = 0;
+    char         *text     = codegen_read(argv[2], &length);
+    size_t        capacity = length * CODEGEN_POOL_FACTOR + CODEGEN_POOL_SLACK;
+    void         *memory   = codegen_alloc(capacity);
+    json_pool_t   pool;
+    json_value_t *json     = NULL;
+    codegen_t     codegen  = { 0 };
+
+    json_pool_init(&pool, memory, capacity);
+
+    json_parse_status_t status = json_parse(text, length, &pool, &json);
+
+    if (status == JSON_PARSE_ERROR_NUL_CHARACTER) {
+        fprintf(stderr, "sjb-codegen: %s has a string with \\u0000, which C strings can't hold\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    if (status != JSON_PARSE_OK) {
+        fprintf(stderr, "sjb-codegen: %s is not valid json\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    if (!codegen_walk(&codegen, json, "")) {
+        return EXIT_FAILURE;
+    }
+
+    FILE *source = fopen(argv[3], "w");
+    FILE *header = fopen(argv[4], "w");
+
+    if (source == NULL || header == NULL) {
+        fprintf(stderr, "sjb-codegen: can't write %s\n", source == NULL ? argv[3] : argv[4]);
+        return EXIT_FAILURE;
+    }
+
+    codegen_print_source(source, &codegen, argv[1], argv[2], argv[4]);
+    codegen_print_header(header, &codegen, argv[1], argv[2]);
+
+    bool written = !ferror(source) && !ferror(header);
+
+    written = fclose(source) == 0 && written;
+    written = fclose(header) == 0 && written;
+
+    for (size_t i = 0; i < codegen.count; i++) {
+        free(codegen.steps[i].literal);
+        free(codegen.steps[i].field);
+    }
+
+    free(codegen.steps);
+    free(memory);
+    free(text);
+
+    if (!written) {
+        fprintf(stderr, "sjb-codegen: can't write the generated files\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}